@@ -6,6 +6,7 @@
 #include "accumulatormap.h"
 #include "accumulators.h"
 #include "libzerocoin/Denominations.h"
+#include "libzerocoin/ParallelFor.h"
 #include "main.h"
 #include "txdb.h"
 
@@ -64,6 +65,33 @@ bool AccumulatorMap::Accumulate(const PublicCoin& pubCoin, bool fSkipValidation)
   return true;
 }
 
+// Add zerocoins to the accumulators of their denominations. Each denomination takes a single exponentiation per
+// ACCUMULATOR_BATCH_MAX coins, and the denominations are worked on in parallel.
+bool AccumulatorMap::Accumulate(const vector<PublicCoin>& vPubcoins, bool fSkipValidation) {
+  map<CoinDenomination, vector<PublicCoin> > mapDenomCoins;
+  for (const PublicCoin& pubCoin : vPubcoins) {
+    if (pubCoin.getDenomination() == CoinDenomination::ZQ_ERROR) return false;
+    mapDenomCoins[pubCoin.getDenomination()].push_back(pubCoin);
+  }
+
+  vector<pair<Accumulator*, const vector<PublicCoin>*> > vWork;
+  for (const auto& it : mapDenomCoins) vWork.emplace_back(mapAccumValues.at(it.first).get(), &it.second);
+
+  ParallelFor(vWork.size(), [&](size_t i) {
+    Accumulator* accumulator = vWork[i].first;
+    const vector<PublicCoin>& vCoins = *vWork[i].second;
+    if (!fSkipValidation) {
+      accumulator->accumulate(vCoins);
+      return;
+    }
+    vector<CBigNum> vValues;
+    vValues.reserve(vCoins.size());
+    for (const PublicCoin& pubCoin : vCoins) vValues.push_back(pubCoin.getValue());
+    accumulator->increment(vValues);
+  });
+  return true;
+}
+
 // Get the value of a specific accumulator
 CBigNum AccumulatorMap::GetValue(CoinDenomination denom) {
   if (denom == CoinDenomination::ZQ_ERROR) return CBigNum(0);
@@ -20,6 +20,7 @@ class AccumulatorMap {
   bool Load(uint256 nCheckpoint);
   void Load(const AccumulatorCheckpoints::Checkpoint& checkpoint);
   bool Accumulate(const libzerocoin::PublicCoin& pubCoin, bool fSkipValidation = false);
+  bool Accumulate(const std::vector<libzerocoin::PublicCoin>& vPubcoins, bool fSkipValidation = false);
   CBigNum GetValue(libzerocoin::CoinDenomination denom);
   uint256 GetCheckpoint();
   void Reset();
@@ -217,7 +217,7 @@ bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, Accumulat
 
   // Accumulate all coins over the last ten blocks that havent been accumulated (height - 2*ACC_BLOCK_INTERVAL through
   // height - 11)
-  int nTotalMintsFound = 0;
+  std::vector<PublicCoin> vPubcoins;
   CBlockIndex* pindex = chainActive[nHeightCheckpoint - 2 * ACC_BLOCK_INTERVAL];
 
 #warning "Check this"
@@ -241,19 +241,17 @@ bool CalculateAccumulatorCheckpoint(int nHeight, uint256& nCheckpoint, Accumulat
     if (!BlockToPubcoinList(block, listPubcoins))
       return error("%s: failed to get zerocoin mintlist from block %d", __func__, pindex->nHeight);
 
-    nTotalMintsFound += listPubcoins.size();
     LogPrint(TessaLog::ZERO, "%s found %d mints at height %d\n", __func__, listPubcoins.size(), pindex->nHeight);
-
-    // add the pubcoins to accumulator
-    for (const PublicCoin& pubcoin : listPubcoins) {
-      if (!mapAccumulators.Accumulate(pubcoin, true))
-        return error("%s: failed to add pubcoin to accumulator at height %d", __func__, pindex->nHeight);
-    }
+    vPubcoins.insert(vPubcoins.end(), listPubcoins.begin(), listPubcoins.end());
     pindex = chainActive.Next(pindex);
   }
 
+  // add the pubcoins of the whole interval to the accumulators at once
+  if (!mapAccumulators.Accumulate(vPubcoins, true))
+    return error("%s: failed to add pubcoins to accumulators at height %d", __func__, nHeight);
+
   // if there were no new mints found, the accumulator checkpoint will be the same as the last checkpoint
-  if (nTotalMintsFound == 0)
+  if (vPubcoins.empty())
     nCheckpoint = chainActive[nHeight - 1]->nAccumulatorCheckpoint;
   else
     nCheckpoint = mapAccumulators.GetCheckpoint();
@@ -316,29 +314,41 @@ int ComputeAccumulatedCoins(int nHeightEnd, libzerocoin::CoinDenomination denom)
   return n;
 }
 
+// The pubcoins of denom minted in a block, from the mint index or else from the block itself
+static bool ReadBlockPubcoins(libzerocoin::CoinDenomination denom, int nHeight, const uint256& hashBlock,
+                              const CDiskBlockPos& pos, vector<CBigNum>& vPubcoins) {
+  vPubcoins.clear();
+  if (zerocoinDB->ReadBlockMints(denom, nHeight, hashBlock, vPubcoins)) return true;
+
+  CBlock block;
+  if (!ReadBlockFromDisk(block, pos) || block.GetHash() != hashBlock)
+    return error("%s: failed to read block %d from disk while adding pubcoins to witness", __func__, nHeight);
+
+  list<PublicCoin> listPubcoins;
+  if (!BlockToPubcoinList(block, listPubcoins))
+    return error("%s: failed to get zerocoin mintlist from block %d\n", __func__, nHeight);
+
+  for (const PublicCoin& pubcoin : listPubcoins) {
+    if (pubcoin.getDenomination() == denom) vPubcoins.push_back(pubcoin.getValue());
+  }
+  return true;
+}
+
 int AddBlockMintsToAccumulator(const libzerocoin::PublicCoin& coin, const int nHeightMintAdded,
                                const CBlockIndex* pindex, libzerocoin::Accumulator* accumulator, bool isWitness) {
   // if this block contains mints of the denomination that is being spent, then add them to the witness
   int nMintsAdded = 0;
   if (pindex->MintedDenomination(coin.getDenomination())) {
-    // grab mints from this block
-    CBlock block;
-    if (!ReadBlockFromDisk(block, pindex))
-      return error("%s: failed to read block from disk while adding pubcoins to witness", __func__);
-
-    list<PublicCoin> listPubcoins;
-    if (!BlockToPubcoinList(block, listPubcoins))
-      return error("%s: failed to get zerocoin mintlist from block %n\n", __func__, pindex->nHeight);
+    vector<CBigNum> vPubcoins;
+    if (!ReadBlockPubcoins(coin.getDenomination(), pindex->nHeight, pindex->GetBlockHash(), pindex->GetBlockPos(),
+                           vPubcoins))
+      return 0;
 
     // add the mints to the witness
-    for (const PublicCoin& pubcoin : listPubcoins) {
-      if (pubcoin.getDenomination() != coin.getDenomination()) continue;
-
-      if (isWitness && pindex->nHeight == nHeightMintAdded && pubcoin.getValue() == coin.getValue()) continue;
-
-      accumulator->increment(pubcoin.getValue());
-      ++nMintsAdded;
-    }
+    if (isWitness && pindex->nHeight == nHeightMintAdded)
+      vPubcoins.erase(remove(vPubcoins.begin(), vPubcoins.end(), coin.getValue()), vPubcoins.end());
+    accumulator->increment(vPubcoins);
+    nMintsAdded = vPubcoins.size();
   }
 
   return nMintsAdded;
@@ -369,21 +379,13 @@ bool GetAccumulatorValue(int& nHeight, const libzerocoin::CoinDenomination denom
   return true;
 }
 
-bool GenerateAccumulatorWitness(const PublicCoin& coin, Accumulator& accumulator, AccumulatorWitness& witness,
-                                int nSecurityLevel, int& nMintsAdded, string& strError, CBlockIndex* pindexCheckpoint) {
-  LogPrint(TessaLog::ZERO, "%s: generating\n", __func__);
-  int nLockAttempts = 0;
-  while (nLockAttempts < 100) {
-    TRY_LOCK(cs_main, lockMain);
-    if (!lockMain) {
-      MilliSleep(50);
-      nLockAttempts++;
-      continue;
-    }
-    break;
-  }
-  if (nLockAttempts == 100) return error("%s: could not get lock on cs_main", __func__);
-  LogPrint(TessaLog::ZERO, "%s: after lock\n", __func__);
+int GetWitnessStopHeight() {
+  int nChainHeight = chainActive.Height();
+  return nChainHeight - (nChainHeight % ACC_BLOCK_INTERVAL) - 2 * ACC_BLOCK_INTERVAL;
+}
+
+// Find the accumulator the witness of coin starts from, and the block to start adding mints at
+static bool InitMintWitness(const PublicCoin& coin, CMintWitness& mintWitness) {
   uint256 txid;
   if (!zerocoinDB->ReadCoinMint(coin.getValue(), txid)) return error("%s failed to read mint from db", __func__);
   LogPrint(TessaLog::ZERO, "%s Read mint for %s from DB", __func__, coin.getValue());
@@ -403,65 +405,168 @@ bool GenerateAccumulatorWitness(const PublicCoin& coin, Accumulator& accumulator
   int nHeightCheckpoint = nHeightMintAdded + (ACC_BLOCK_INTERVAL - (nHeightMintAdded % ACC_BLOCK_INTERVAL));
   LogPrint(TessaLog::ZERO, "%s nHeightCheckpoint %d", __func__, nHeightCheckpoint);
 
-  // the height to start accumulating coins to add to witness
-  int nAccStartHeight = nHeightMintAdded - (nHeightMintAdded % ACC_BLOCK_INTERVAL);
-
   // Get the accumulator that is right before the cluster of blocks containing our mint was added to the accumulator
+  libzerocoin::Accumulator accumulator(libzerocoin::gpZerocoinParams, coin.getDenomination());
   CBigNum bnAccValue = 0;
-  if (GetAccumulatorValue(nHeightCheckpoint, coin.getDenomination(), bnAccValue)) {
-    accumulator.setValue(bnAccValue);
-    witness.resetValue(accumulator, coin);
+  if (GetAccumulatorValue(nHeightCheckpoint, coin.getDenomination(), bnAccValue)) accumulator.setValue(bnAccValue);
+
+  CBlockIndex* pindexStart = chainActive[nHeightCheckpoint - ACC_BLOCK_INTERVAL];
+  if (!pindexStart) return error("%s: accumulation start %d is not in chain", __func__, nHeightCheckpoint);
+
+  mintWitness.SetNull();
+  mintWitness.bnPubcoin = coin.getValue();
+  mintWitness.denom = coin.getDenomination();
+  mintWitness.bnWitness = accumulator.getValue();
+  mintWitness.nHeightMintAdded = nHeightMintAdded;
+  // the height to start accumulating coins to add to witness
+  mintWitness.nHeightAccStart = nHeightMintAdded - (nHeightMintAdded % ACC_BLOCK_INTERVAL);
+  mintWitness.nHeightStart = pindexStart->nHeight;
+  mintWitness.nHeight = pindexStart->nHeight;
+  mintWitness.hashBlockLast = pindexStart->pprev ? pindexStart->pprev->GetBlockHash() : uint256();
+  return true;
+}
+
+// Whether the blocks mintWitness covers are still the ones on the active chain
+static bool IsMintWitnessInChain(const CMintWitness& mintWitness) {
+  if (mintWitness.IsNull() || mintWitness.nHeight > chainActive.Height() + 1) return false;
+  const CBlockIndex* pindexLast = chainActive[mintWitness.nHeight - 1];
+  return pindexLast && pindexLast->GetBlockHash() == mintWitness.hashBlockLast;
+}
+
+// What adding pindex to mintWitness needs from the block index
+static CWitnessBlock GetWitnessBlock(const CMintWitness& mintWitness, const CBlockIndex* pindex) {
+  CWitnessBlock block;
+  block.nHeight = pindex->nHeight;
+  block.hashBlock = pindex->GetBlockHash();
+  block.pos = pindex->GetBlockPos();
+  block.fMinted = pindex->MintedDenomination(mintWitness.denom);
+  block.fNewCheckpoint = pindex->nHeight != mintWitness.nHeightAccStart &&
+                         pindex->pprev->nAccumulatorCheckpoint != pindex->nAccumulatorCheckpoint;
+  return block;
+}
+
+bool SnapshotMintWitness(const PublicCoin& coin, CMintWitness& mintWitness, int nHeightEnd, size_t nMaxBlocks,
+                         std::vector<CWitnessBlock>& vBlocks) {
+  AssertLockHeld(cs_main);
+  if (!IsMintWitnessInChain(mintWitness) || mintWitness.bnPubcoin != coin.getValue()) {
+    if (!InitMintWitness(coin, mintWitness)) return false;
   }
 
-  // add the pubcoins from the blockchain up to the next checksum starting from the block
-  CBlockIndex* pindex = chainActive[nHeightCheckpoint - ACC_BLOCK_INTERVAL];
-  int nChainHeight = chainActive.Height();
-  int nHeightStop = nChainHeight % ACC_BLOCK_INTERVAL;
-  nHeightStop = nChainHeight - nHeightStop - 2 * ACC_BLOCK_INTERVAL;  // at least two checkpoints deep
+  vBlocks.clear();
+  for (CBlockIndex* pindex = chainActive[mintWitness.nHeight];
+       pindex && pindex->nHeight < nHeightEnd && vBlocks.size() < nMaxBlocks; pindex = chainActive.Next(pindex))
+    vBlocks.push_back(GetWitnessBlock(mintWitness, pindex));
+  return true;
+}
 
-  // If looking for a specific checkpoint
-  if (pindexCheckpoint) nHeightStop = pindexCheckpoint->nHeight - ACC_BLOCK_INTERVAL;
+bool AddBlocksToMintWitness(const PublicCoin& coin, CMintWitness& mintWitness,
+                            const std::vector<CWitnessBlock>& vBlocks) {
+  // Collect the mints of every block first, so that they are accumulated in one go
+  CMintWitness mintWitnessNew = mintWitness;
+  vector<CBigNum> vPubcoins, vBlockPubcoins;
+  for (const CWitnessBlock& block : vBlocks) {
+    if (ShutdownRequested()) return false;
+    if (block.nHeight != mintWitnessNew.nHeight)
+      return error("%s: block %d does not follow the witness at %d", __func__, block.nHeight, mintWitnessNew.nHeight);
+
+    if (block.fNewCheckpoint) ++mintWitnessNew.nCheckpointsAdded;
+    if (block.fMinted) {
+      if (!ReadBlockPubcoins(coin.getDenomination(), block.nHeight, block.hashBlock, block.pos, vBlockPubcoins))
+        return false;
+      if (block.nHeight == mintWitnessNew.nHeightMintAdded)
+        vBlockPubcoins.erase(remove(vBlockPubcoins.begin(), vBlockPubcoins.end(), coin.getValue()),
+                             vBlockPubcoins.end());
+      vPubcoins.insert(vPubcoins.end(), vBlockPubcoins.begin(), vBlockPubcoins.end());
+    }
+    mintWitnessNew.nHeight = block.nHeight + 1;
+    mintWitnessNew.hashBlockLast = block.hashBlock;
+  }
 
-  // Iterate through the chain and calculate the witness
-  int nCheckpointsAdded = 0;
-  nMintsAdded = 0;
-  if (Params().NetworkID() == CBaseChainParams::MAIN)
-    RandomizeSecurityLevel(nSecurityLevel);  // make security level not always the same and predictable
-  libzerocoin::Accumulator witnessAccumulator = accumulator;
+  libzerocoin::Accumulator witnessAccumulator(libzerocoin::gpZerocoinParams, coin.getDenomination(),
+                                              mintWitnessNew.bnWitness);
+  witnessAccumulator.increment(vPubcoins);
+  mintWitnessNew.bnWitness = witnessAccumulator.getValue();
+  mintWitnessNew.nMintsAdded += vPubcoins.size();
+  mintWitness = mintWitnessNew;
+  return true;
+}
 
-  while (pindex) {
-    LogPrint(TessaLog::ZERO, "%s Height = %d CheckPoint = %s", __func__, pindex->nHeight,
-             pindex->nAccumulatorCheckpoint.ToString());
-    if (pindex->nHeight != nAccStartHeight && pindex->pprev->nAccumulatorCheckpoint != pindex->nAccumulatorCheckpoint)
-      ++nCheckpointsAdded;
-
-    // If the security level is satisfied, or the stop height is reached, then initialize the accumulator from here
-    bool fSecurityLevelSatisfied = (nSecurityLevel != 100 && nCheckpointsAdded >= nSecurityLevel);
-    if (pindex->nHeight >= nHeightStop || fSecurityLevelSatisfied) {
-      bnAccValue = 0;
-      uint256 nCheckpointSpend = chainActive[pindex->nHeight + ACC_BLOCK_INTERVAL]->nAccumulatorCheckpoint;
-      if (!GetAccumulatorValueFromDB(nCheckpointSpend, coin.getDenomination(), bnAccValue) || bnAccValue == 0)
-        return error("%s : failed to find checksum in database for accumulator", __func__);
-
-      accumulator.setValue(bnAccValue);
-      break;
+bool GenerateAccumulatorWitness(const PublicCoin& coin, Accumulator& accumulator, AccumulatorWitness& witness,
+                                int nSecurityLevel, int& nMintsAdded, string& strError, CBlockIndex* pindexCheckpoint,
+                                const CMintWitness* pcached) {
+  LogPrint(TessaLog::ZERO, "%s: generating\n", __func__);
+
+  // The blocks to add and the accumulator to check against are taken from the chain under cs_main,
+  // the mints of those blocks are read and accumulated after it is released
+  CMintWitness mintWitness;
+  std::vector<CWitnessBlock> vBlocks;
+  CBigNum bnAccValue;
+  int nMintsBefore = 0;
+  {
+    LOCK(cs_main);
+
+    // add the pubcoins from the blockchain up to the next checksum starting from the block
+    int nHeightStop = GetWitnessStopHeight();  // at least two checkpoints deep
+
+    // If looking for a specific checkpoint
+    if (pindexCheckpoint) nHeightStop = pindexCheckpoint->nHeight - ACC_BLOCK_INTERVAL;
+
+    if (Params().NetworkID() == CBaseChainParams::MAIN)
+      RandomizeSecurityLevel(nSecurityLevel);  // make security level not always the same and predictable
+
+    // A cached witness can be carried on if none of the blocks it covers would have ended this spend's witness
+    if (pcached && pcached->bnPubcoin == coin.getValue() && IsMintWitnessInChain(*pcached) &&
+        pcached->nHeight <= nHeightStop && (nSecurityLevel == 100 || pcached->nCheckpointsAdded < nSecurityLevel)) {
+      mintWitness = *pcached;
+      LogPrint(TessaLog::ZERO, "%s: continuing cached witness at height %d\n", __func__, mintWitness.nHeight);
+    } else if (!InitMintWitness(coin, mintWitness)) {
+      return false;
     }
 
-    nMintsAdded += AddBlockMintsToAccumulator(coin, nHeightMintAdded, pindex, &witnessAccumulator, true);
-    pindex = chainActive.Next(pindex);
+    bnAccValue = mintWitness.bnWitness;
+
+    // Iterate through the chain to find the blocks of the witness
+    int nCheckpointsAdded = mintWitness.nCheckpointsAdded;
+    for (CBlockIndex* pindex = chainActive[mintWitness.nHeight]; pindex; pindex = chainActive.Next(pindex)) {
+      LogPrint(TessaLog::ZERO, "%s Height = %d CheckPoint = %s", __func__, pindex->nHeight,
+               pindex->nAccumulatorCheckpoint.ToString());
+      CWitnessBlock block = GetWitnessBlock(mintWitness, pindex);
+      if (block.fNewCheckpoint) ++nCheckpointsAdded;
+
+      // If the security level is satisfied, or the stop height is reached, then initialize the accumulator from here
+      bool fSecurityLevelSatisfied = (nSecurityLevel != 100 && nCheckpointsAdded >= nSecurityLevel);
+      if (pindex->nHeight >= nHeightStop || fSecurityLevelSatisfied) {
+        CBlockIndex* pindexSpend = chainActive[pindex->nHeight + ACC_BLOCK_INTERVAL];
+        if (!pindexSpend || !GetAccumulatorValueFromDB(pindexSpend->nAccumulatorCheckpoint, coin.getDenomination(),
+                                                       bnAccValue) || bnAccValue == 0)
+          return error("%s : failed to find checksum in database for accumulator", __func__);
+        break;
+      }
+      vBlocks.push_back(block);
+    }
+
+    // how many mints of this denomination existed in the accumulator we initialized
+    nMintsBefore = ComputeAccumulatedCoins(mintWitness.nHeightAccStart, coin.getDenomination());
   }
+
+  if (!AddBlocksToMintWitness(coin, mintWitness, vBlocks))
+    return error("%s: failed to add the mints of %u blocks to the witness", __func__, vBlocks.size());
+
+  accumulator.setValue(bnAccValue);
+  libzerocoin::Accumulator witnessAccumulator(libzerocoin::gpZerocoinParams, coin.getDenomination(),
+                                              mintWitness.bnWitness);
   witness.resetValue(witnessAccumulator, coin);
   if (!witness.VerifyWitness(accumulator, coin)) { return error("%s: failed to verify witness", __func__); }
 
   // A certain amount of accumulated coins are required
+  nMintsAdded = mintWitness.nMintsAdded;
   if (nMintsAdded < Params().Zerocoin_RequiredAccumulation()) {
     strError =
         strprintf("Less than %d mints added, unable to create spend", Params().Zerocoin_RequiredAccumulation()).c_str();
     return error("%s : %s", __func__, strError);
   }
 
-  // calculate how many mints of this denomination existed in the accumulator we initialized
-  nMintsAdded += ComputeAccumulatedCoins(nAccStartHeight, coin.getDenomination());
+  nMintsAdded += nMintsBefore;
   LogPrint(TessaLog::ZERO, "%s : %d mints added to witness\n", __func__, nMintsAdded);
 
   return true;
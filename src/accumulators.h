@@ -16,10 +16,89 @@
 
 class CBlockIndex;
 
+/**
+ * The witness accumulator of one mint as GenerateAccumulatorWitness() builds it,
+ * kept so that it can be carried forward a block at a time instead of being
+ * rebuilt from the mint for every spend.
+ */
+class CMintWitness {
+ public:
+  CBigNum bnPubcoin;
+  libzerocoin::CoinDenomination denom;
+  //! Every other mint of the denomination from the accumulator start up to, not including, nHeight
+  CBigNum bnWitness;
+  int nHeightMintAdded;
+  //! Start of the checkpoint interval of the mint, and the first block added
+  int nHeightAccStart;
+  int nHeightStart;
+  //! Next block to add, and the hash of the one before it to notice a reorg
+  int nHeight;
+  uint256 hashBlockLast;
+  int nCheckpointsAdded;
+  int nMintsAdded;
+
+  CMintWitness() { SetNull(); }
+
+  void SetNull() {
+    bnPubcoin = 0;
+    denom = libzerocoin::ZQ_ERROR;
+    bnWitness = 0;
+    nHeightMintAdded = nHeightAccStart = nHeightStart = nHeight = 0;
+    hashBlockLast.SetNull();
+    nCheckpointsAdded = nMintsAdded = 0;
+  }
+
+  bool IsNull() const { return nHeight == 0; }
+
+  ADD_SERIALIZE_METHODS
+  template <typename Stream, typename Operation> inline void SerializationOp(Stream& s, Operation ser_action) {
+    READWRITE(bnPubcoin);
+    READWRITE(denom);
+    READWRITE(bnWitness);
+    READWRITE(nHeightMintAdded);
+    READWRITE(nHeightAccStart);
+    READWRITE(nHeightStart);
+    READWRITE(nHeight);
+    READWRITE(hashBlockLast);
+    READWRITE(nCheckpointsAdded);
+    READWRITE(nMintsAdded);
+  }
+};
+
+/**
+ * A block to add to a mint's witness, copied from the block index under cs_main
+ * so that its mints can be read and accumulated without holding it.
+ */
+struct CWitnessBlock {
+  int nHeight;
+  uint256 hashBlock;
+  CDiskBlockPos pos;
+  //! The block has mints of the witness' denomination
+  bool fMinted;
+  //! The block starts a new accumulator checkpoint
+  bool fNewCheckpoint;
+};
+
 std::map<libzerocoin::CoinDenomination, int> GetMintMaturityHeight();
+/**
+ * Build the witness for a spend of coin. With pcached set and still on the active chain,
+ * the blocks it already covers are not read again.
+ */
 bool GenerateAccumulatorWitness(const libzerocoin::PublicCoin& coin, libzerocoin::Accumulator& accumulator,
                                 libzerocoin::AccumulatorWitness& witness, int nSecurityLevel, int& nMintsAdded,
-                                std::string& strError, CBlockIndex* pindexCheckpoint = nullptr);
+                                std::string& strError, CBlockIndex* pindexCheckpoint = nullptr,
+                                const CMintWitness* pcached = nullptr);
+/**
+ * Requires cs_main. Start mintWitness for coin over if a reorg went below it, then list the blocks after it,
+ * at most nMaxBlocks of them and none from nHeightEnd on.
+ */
+bool SnapshotMintWitness(const libzerocoin::PublicCoin& coin, CMintWitness& mintWitness, int nHeightEnd,
+                         size_t nMaxBlocks, std::vector<CWitnessBlock>& vBlocks);
+//! Add the mints of vBlocks, as SnapshotMintWitness() listed them, to mintWitness. Does not need cs_main.
+bool AddBlocksToMintWitness(const libzerocoin::PublicCoin& coin, CMintWitness& mintWitness,
+                            const std::vector<CWitnessBlock>& vBlocks);
+//! First block a spend at the highest security level leaves out of its witness, two checkpoints below the tip
+int GetWitnessStopHeight();
 bool GetAccumulatorValueFromDB(uint256 nCheckpoint, libzerocoin::CoinDenomination denom, CBigNum& bnAccValue);
 bool GetAccumulatorValueFromChecksum(uint32_t nChecksum, bool fMemoryOnly, CBigNum& bnAccValue);
 void AddAccumulatorChecksum(const uint32_t nChecksum, const CBigNum& bnValue, bool fMemoryOnly);
@@ -0,0 +1,145 @@
+// Copyright (c) 2018 The Tessacoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bignum.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+//! Distinct block sizes a thread keeps freed blocks for
+const int LIMB_POOL_SLOTS = 16;
+//! Most blocks kept per size
+const unsigned int LIMB_POOL_DEPTH = 256;
+//! Most bytes kept per size; larger blocks always go back to malloc
+const size_t LIMB_POOL_SLOT_BYTES = 64 * 1024;
+
+std::atomic<bool> fPooling(false);
+
+/**
+ * Freed GMP blocks of one thread, grouped by their exact size. A block is only
+ * handed out again for a request of the size it was freed with, so blocks
+ * that came from plain malloc before the pool was installed are safe to keep.
+ */
+struct LimbPool {
+  size_t vSize[LIMB_POOL_SLOTS];
+  unsigned int vCount[LIMB_POOL_SLOTS];
+  void* vBlocks[LIMB_POOL_SLOTS][LIMB_POOL_DEPTH];
+  uint64_t nAllocs;
+  uint64_t nMallocs;
+
+  ~LimbPool();
+
+  //! Slot holding blocks of n bytes, -1 if there is none
+  int Find(size_t n) const {
+    for (int i = 0; i < LIMB_POOL_SLOTS; i++)
+      if (vSize[i] == n) return i;
+    return -1;
+  }
+
+  //! Slot for n bytes, taking over an empty one if needed, -1 if all are in use
+  int Claim(size_t n) {
+    int nEmpty = -1;
+    for (int i = 0; i < LIMB_POOL_SLOTS; i++) {
+      if (vSize[i] == n) return i;
+      if (nEmpty < 0 && vCount[i] == 0) nEmpty = i;
+    }
+    if (nEmpty >= 0) vSize[nEmpty] = n;
+    return nEmpty;
+  }
+};
+
+thread_local LimbPool pool;
+//! 0 before the thread first used the pool, 1 while it is alive, 2 once it has been torn down
+thread_local int nPoolState = 0;
+
+LimbPool::~LimbPool() {
+  for (int i = 0; i < LIMB_POOL_SLOTS; i++)
+    for (unsigned int j = 0; j < vCount[i]; j++) free(vBlocks[i][j]);
+  // Static bignums are still freed after this, straight to malloc
+  nPoolState = 2;
+}
+
+//! The calling thread's pool, nullptr once the thread is exiting
+LimbPool* GetPool() {
+  if (nPoolState == 0) {
+    // First use constructs the pool and registers its destructor for thread exit
+    pool.nAllocs = pool.nMallocs = 0;
+    nPoolState = 1;
+  }
+  return nPoolState == 1 ? &pool : nullptr;
+}
+
+void* CheckedAlloc(void* ptr) {
+  if (!ptr) {
+    fprintf(stderr, "GNU MP: Cannot allocate memory\n");
+    abort();
+  }
+  return ptr;
+}
+
+void* PoolAlloc(size_t n) {
+  LimbPool* p = GetPool();
+  if (p) {
+    ++p->nAllocs;
+    if (fPooling.load(std::memory_order_relaxed)) {
+      int i = p->Find(n);
+      if (i >= 0 && p->vCount[i] > 0) return p->vBlocks[i][--p->vCount[i]];
+    }
+    ++p->nMallocs;
+  }
+  return CheckedAlloc(malloc(n));
+}
+
+void PoolFree(void* ptr, size_t n);
+
+void* PoolRealloc(void* ptr, size_t nOld, size_t nNew) {
+  if (nOld == nNew) return ptr;
+  LimbPool* p = GetPool();
+  if (p) {
+    ++p->nAllocs;
+    // Growing into a pooled block is a copy of the old limbs, and the old block goes back to the pool
+    int i = fPooling.load(std::memory_order_relaxed) ? p->Find(nNew) : -1;
+    if (i >= 0 && p->vCount[i] > 0) {
+      void* ptrNew = p->vBlocks[i][--p->vCount[i]];
+      memcpy(ptrNew, ptr, std::min(nOld, nNew));
+      PoolFree(ptr, nOld);
+      return ptrNew;
+    }
+    ++p->nMallocs;
+  }
+  return CheckedAlloc(realloc(ptr, nNew));
+}
+
+void PoolFree(void* ptr, size_t n) {
+  LimbPool* p = GetPool();
+  if (p && n <= LIMB_POOL_SLOT_BYTES && fPooling.load(std::memory_order_relaxed)) {
+    int i = p->Claim(n);
+    if (i >= 0 && p->vCount[i] < std::min<size_t>(LIMB_POOL_DEPTH, LIMB_POOL_SLOT_BYTES / n)) {
+      p->vBlocks[i][p->vCount[i]++] = ptr;
+      return;
+    }
+  }
+  free(ptr);
+}
+
+}  // namespace
+
+void SetBignumPooling(bool fEnable) {
+  static std::once_flag flagInstall;
+  std::call_once(flagInstall, [] { mp_set_memory_functions(PoolAlloc, PoolRealloc, PoolFree); });
+  fPooling = fEnable;
+  if (LimbPool* p = GetPool()) p->nAllocs = p->nMallocs = 0;
+}
+
+void GetBignumAllocStats(uint64_t& nAllocs, uint64_t& nMallocs) {
+  LimbPool* p = GetPool();
+  nAllocs = p ? p->nAllocs : 0;
+  nMallocs = p ? p->nMallocs : 0;
+}
@@ -8,6 +8,7 @@
 
 
 #include <stdexcept>
+#include <utility>
 #include <vector>
 #include <gmp.h>
 
@@ -38,6 +39,19 @@ public:
         return (*this);
     }
 
+    // Moves hand over the limbs; mpz_init does not allocate, so the source stays cheap to destroy
+    CBigNum(CBigNum&& b) noexcept
+    {
+        mpz_init(bn);
+        mpz_swap(bn, b.bn);
+    }
+
+    CBigNum& operator=(CBigNum&& b) noexcept
+    {
+        mpz_swap(bn, b.bn);
+        return (*this);
+    }
+
     ~CBigNum()
     {
         mpz_clear(bn);
@@ -94,7 +108,7 @@ public:
     int getint() const
     {
         unsigned long n = getulong();
-        if (mpz_cmp(bn, CBigNum(0).bn) >= 0) {
+        if (mpz_sgn(bn) >= 0) {
             return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : n);
         } else {
             return (n > (unsigned long)std::numeric_limits<int>::max() ? std::numeric_limits<int>::min() : -(int)n);
@@ -135,7 +149,7 @@ public:
 
     std::vector<unsigned char> getvch() const
     {
-        if (mpz_cmp(bn, CBigNum(0).bn) == 0) {
+        if (mpz_sgn(bn) == 0) {
             return std::vector<unsigned char>(0);
         }
         size_t size = (mpz_sizeinbase (bn, 2) + CHAR_BIT-1) / CHAR_BIT;
@@ -180,6 +194,10 @@ public:
     {
         char* c_str = mpz_get_str(NULL, nBase, bn);
         std::string str(c_str);
+        // The string comes from GMP's allocator and has to go back to it
+        void (*pfnFree)(void*, size_t);
+        mp_get_memory_functions(NULL, NULL, &pfnFree);
+        pfnFree(c_str, str.size() + 1);
         return str;
     }
 
@@ -292,12 +310,12 @@ public:
 
     bool isOne() const
     {
-        return mpz_cmp(bn, CBigNum(1).bn) == 0;
+        return mpz_cmp_ui(bn, 1) == 0;
     }
 
     bool operator!() const
     {
-        return mpz_cmp(bn, CBigNum(0).bn) == 0;
+        return mpz_sgn(bn) == 0;
     }
 
     CBigNum& operator+=(const CBigNum& b)
@@ -320,13 +338,13 @@ public:
 
     CBigNum& operator/=(const CBigNum& b)
     {
-        *this = *this / b;
+        mpz_tdiv_q(bn, bn, b.bn);
         return *this;
     }
 
     CBigNum& operator%=(const CBigNum& b)
     {
-        *this = *this % b;
+        mpz_mmod(bn, bn, b.bn);
         return *this;
     }
 
@@ -346,11 +364,11 @@ public:
     CBigNum& operator++()
     {
         // prefix operator
-        mpz_add(bn, bn, CBigNum(1).bn);
+        mpz_add_ui(bn, bn, 1);
         return *this;
     }
 
-    const CBigNum operator++(int)
+    CBigNum operator++(int)
     {
         // postfix operator
         const CBigNum ret = *this;
@@ -361,11 +379,11 @@ public:
     CBigNum& operator--()
     {
         // prefix operator
-        mpz_sub(bn, bn, CBigNum(1).bn);
+        mpz_sub_ui(bn, bn, 1);
         return *this;
     }
 
-    const CBigNum operator--(int)
+    CBigNum operator--(int)
     {
         // postfix operator
         const CBigNum ret = *this;
@@ -373,13 +391,13 @@ public:
         return ret;
     }
 
-    friend inline const CBigNum operator+(const CBigNum& a, const CBigNum& b);
-    friend inline const CBigNum operator-(const CBigNum& a, const CBigNum& b);
-    friend inline const CBigNum operator/(const CBigNum& a, const CBigNum& b);
-    friend inline const CBigNum operator%(const CBigNum& a, const CBigNum& b);
-    friend inline const CBigNum operator*(const CBigNum& a, const CBigNum& b);
-    friend inline const CBigNum operator<<(const CBigNum& a, unsigned int shift);
-    friend inline const CBigNum operator-(const CBigNum& a);
+    friend inline CBigNum operator+(const CBigNum& a, const CBigNum& b);
+    friend inline CBigNum operator-(const CBigNum& a, const CBigNum& b);
+    friend inline CBigNum operator/(const CBigNum& a, const CBigNum& b);
+    friend inline CBigNum operator%(const CBigNum& a, const CBigNum& b);
+    friend inline CBigNum operator*(const CBigNum& a, const CBigNum& b);
+    friend inline CBigNum operator<<(const CBigNum& a, unsigned int shift);
+    friend inline CBigNum operator-(const CBigNum& a);
     friend inline bool operator==(const CBigNum& a, const CBigNum& b);
     friend inline bool operator!=(const CBigNum& a, const CBigNum& b);
     friend inline bool operator<=(const CBigNum& a, const CBigNum& b);
@@ -388,62 +406,93 @@ public:
     friend inline bool operator>(const CBigNum& a, const CBigNum& b);
 };
 
-inline const CBigNum operator+(const CBigNum& a, const CBigNum& b)
+inline CBigNum operator+(const CBigNum& a, const CBigNum& b)
 {
     CBigNum r;
     mpz_add(r.bn, a.bn, b.bn);
     return r;
 }
 
-inline const CBigNum operator-(const CBigNum& a, const CBigNum& b)
+inline CBigNum operator-(const CBigNum& a, const CBigNum& b)
 {
     CBigNum r;
     mpz_sub(r.bn, a.bn, b.bn);
     return r;
 }
 
-inline const CBigNum operator-(const CBigNum& a)
+inline CBigNum operator-(const CBigNum& a)
 {
     CBigNum r;
     mpz_neg(r.bn, a.bn);
     return r;
 }
 
-inline const CBigNum operator*(const CBigNum& a, const CBigNum& b)
+inline CBigNum operator*(const CBigNum& a, const CBigNum& b)
 {
     CBigNum r;
     mpz_mul(r.bn, a.bn, b.bn);
     return r;
 }
 
-inline const CBigNum operator/(const CBigNum& a, const CBigNum& b)
+inline CBigNum operator/(const CBigNum& a, const CBigNum& b)
 {
     CBigNum r;
     mpz_tdiv_q(r.bn, a.bn, b.bn);
     return r;
 }
 
-inline const CBigNum operator%(const CBigNum& a, const CBigNum& b)
+inline CBigNum operator%(const CBigNum& a, const CBigNum& b)
 {
     CBigNum r;
     mpz_mmod(r.bn, a.bn, b.bn);
     return r;
 }
 
-inline const CBigNum operator<<(const CBigNum& a, unsigned int shift)
+inline CBigNum operator<<(const CBigNum& a, unsigned int shift)
 {
     CBigNum r;
     mpz_mul_2exp(r.bn, a.bn, shift);
     return r;
 }
 
-inline const CBigNum operator>>(const CBigNum& a, unsigned int shift)
+inline CBigNum operator>>(const CBigNum& a, unsigned int shift)
 {
     CBigNum r = a;
     r >>= shift;
     return r;
 }
 
+// A temporary left operand is reused for the result instead of initializing a new one
+inline CBigNum operator+(CBigNum&& a, const CBigNum& b)
+{
+    mpz_add(a.bn, a.bn, b.bn);
+    return std::move(a);
+}
+
+inline CBigNum operator-(CBigNum&& a, const CBigNum& b)
+{
+    mpz_sub(a.bn, a.bn, b.bn);
+    return std::move(a);
+}
+
+inline CBigNum operator*(CBigNum&& a, const CBigNum& b)
+{
+    mpz_mul(a.bn, a.bn, b.bn);
+    return std::move(a);
+}
+
+inline CBigNum operator%(CBigNum&& a, const CBigNum& b)
+{
+    mpz_mmod(a.bn, a.bn, b.bn);
+    return std::move(a);
+}
+
+inline CBigNum operator>>(CBigNum&& a, unsigned int shift)
+{
+    a >>= shift;
+    return std::move(a);
+}
+
 inline bool operator==(const CBigNum& a, const CBigNum& b) { return (mpz_cmp(a.bn, b.bn) == 0); }
 inline bool operator!=(const CBigNum& a, const CBigNum& b) { return (mpz_cmp(a.bn, b.bn) != 0); }
 inline bool operator<=(const CBigNum& a, const CBigNum& b) { return (mpz_cmp(a.bn, b.bn) <= 0); }
@@ -454,3 +503,13 @@ inline std::ostream& operator<<(std::ostream &strm, const CBigNum &b) { return s
 
 typedef CBigNum Bignum;
 
+/**
+ * Route GMP's memory through a per-thread cache of freed blocks, keyed by
+ * their exact size, or back to plain malloc. Blocks GMP allocated before the
+ * first call stay valid, so this may be called at any time.
+ */
+void SetBignumPooling(bool fEnable);
+
+/** GMP allocations made by the calling thread since SetBignumPooling(), and how many of them reached malloc */
+void GetBignumAllocStats(uint64_t& nAllocs, uint64_t& nMallocs);
+
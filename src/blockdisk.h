@@ -24,8 +24,10 @@ bool IsInitialBlockDownload();
 bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& coins,
                   bool fJustCheck, bool fAlreadyChecked = false);
 
+/** Context-independent block checks. fZerocoinCacheStore keeps the verified zerocoin spends cached
+ *  (block templates); otherwise cached spends are consumed as the block is connected. */
 bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW = true, bool fCheckMerkleRoot = true,
-                bool fCheckSig = true);
+                bool fCheckSig = true, bool fZerocoinCacheStore = false);
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  In case pfClean is provided, operation will try to be tolerant about errors, and *pfClean
@@ -141,6 +141,7 @@ class CBlockIndex {
     BLOCK_PROOF_OF_STAKE = (1 << 0),  // is proof-of-stake block
     BLOCK_STAKE_ENTROPY = (1 << 1),   // entropy bit for stake modifier
     BLOCK_STAKE_MODIFIER = (1 << 2),  // regenerated stake modifier
+    BLOCK_HASH_STORED = (1 << 3),     // (disk only) index record carries the block hash
   };
 
   // proof-of-stake specific fields
@@ -365,14 +366,18 @@ class CDiskBlockIndex : public CBlockIndex {
  public:
   uint256 hashPrev;
   uint256 hashNext;
+  //! hash of the block header, only present on disk when BLOCK_HASH_STORED is set in nFlags
+  uint256 hashBlock;
 
   CDiskBlockIndex() {
     hashPrev = uint256();
     hashNext = uint256();
+    hashBlock = uint256();
   }
 
   explicit CDiskBlockIndex(CBlockIndex* pindex) : CBlockIndex(*pindex) {
     hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
+    SetStoredHash(pindex->GetBlockHash());
   }
 
   ADD_SERIALIZE_METHODS
@@ -413,9 +418,25 @@ class CDiskBlockIndex : public CBlockIndex {
     READWRITE(nAccumulatorCheckpoint);
     READWRITE(mapZerocoinSupply);
     READWRITE(vMintDenominationsInBlock);
+    // Records written before the hash was persisted end here, so the flag doubles as the format version
+    if (nFlags & BLOCK_HASH_STORED) READWRITE(hashBlock);
   }
 
+  bool HasStoredHash() const { return (nFlags & BLOCK_HASH_STORED); }
+
+  void SetStoredHash(const uint256& hash) {
+    hashBlock = hash;
+    nFlags |= BLOCK_HASH_STORED;
+  }
+
+  //! Returns the persisted hash if the record carries one, otherwise re-derives it from the header
   uint256 GetBlockHash() const {
+    if (HasStoredHash()) return hashBlock;
+    return ComputeBlockHash();
+  }
+
+  //! Hash the header fields; under Argon2d PoW this is a full memory-hard hash
+  uint256 ComputeBlockHash() const {
     CBlockHeader block;
     block.nHeaderVersion = nHeaderVersion;
     block.hashPrevBlock = hashPrev;
@@ -5,7 +5,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "coins.h"
+#include "primitives/block.h"
 #include "random.h"
+#include <algorithm>
 #include <cassert>
 
 /**
@@ -53,6 +55,12 @@ bool CCoins::Spend(int nPos) {
 }
 
 bool CCoinsView::GetCoins(const uint256& txid, CCoins& coins) const { return false; }
+void CCoinsView::GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                              std::vector<bool>& vFound) const {
+  vCoins.assign(vTxid.size(), CCoins());
+  vFound.assign(vTxid.size(), false);
+  for (size_t i = 0; i < vTxid.size(); i++) vFound[i] = GetCoins(vTxid[i], vCoins[i]);
+}
 bool CCoinsView::HaveCoins(const uint256& txid) const { return false; }
 uint256 CCoinsView::GetBestBlock() const { return uint256(); }
 bool CCoinsView::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) { return false; }
@@ -60,6 +68,10 @@ bool CCoinsView::GetStats(CCoinsStats& stats) const { return false; }
 
 CCoinsViewBacked::CCoinsViewBacked(CCoinsView* viewIn) : base(viewIn) {}
 bool CCoinsViewBacked::GetCoins(const uint256& txid, CCoins& coins) const { return base->GetCoins(txid, coins); }
+void CCoinsViewBacked::GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                                    std::vector<bool>& vFound) const {
+  base->GetCoinsMany(vTxid, vCoins, vFound);
+}
 bool CCoinsViewBacked::HaveCoins(const uint256& txid) const { return base->HaveCoins(txid); }
 uint256 CCoinsViewBacked::GetBestBlock() const { return base->GetBestBlock(); }
 void CCoinsViewBacked::SetBackend(CCoinsView& viewIn) { base = &viewIn; }
@@ -91,6 +103,26 @@ CCoinsMap::const_iterator CCoinsViewCache::FetchCoins(const uint256& txid) const
   return ret;
 }
 
+size_t CCoinsViewCache::FetchCoinsMany(const std::vector<uint256>& vTxid) const {
+  std::vector<uint256> vMissing;
+  for (const uint256& txid : vTxid)
+    if (!cacheCoins.count(txid)) vMissing.push_back(txid);
+  if (vMissing.empty()) return 0;
+
+  std::vector<CCoins> vCoins;
+  std::vector<bool> vFound;
+  base->GetCoinsMany(vMissing, vCoins, vFound);
+  for (size_t i = 0; i < vMissing.size(); i++) {
+    if (!vFound[i]) continue;
+    auto ret = cacheCoins.insert(std::make_pair(vMissing[i], CCoinsCacheEntry()));
+    if (!ret.second) continue;
+    vCoins[i].swap(ret.first->second.coins);
+    // Same as FetchCoins: a pruned parent entry lets us treat ours as fresh
+    if (ret.first->second.coins.IsPruned()) ret.first->second.flags = CCoinsCacheEntry::FRESH;
+  }
+  return vMissing.size();
+}
+
 bool CCoinsViewCache::GetCoins(const uint256& txid, CCoins& coins) const {
   auto it = FetchCoins(txid);
   if (it != cacheCoins.end()) {
@@ -100,6 +132,43 @@ bool CCoinsViewCache::GetCoins(const uint256& txid, CCoins& coins) const {
   return false;
 }
 
+void CCoinsViewCache::GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                                   std::vector<bool>& vFound) const {
+  FetchCoinsMany(vTxid);
+  vCoins.assign(vTxid.size(), CCoins());
+  vFound.assign(vTxid.size(), false);
+  for (size_t i = 0; i < vTxid.size(); i++) {
+    auto it = cacheCoins.find(vTxid[i]);
+    if (it == cacheCoins.end()) continue;
+    vCoins[i] = it->second.coins;
+    vFound[i] = true;
+  }
+}
+
+size_t CCoinsViewCache::PrefetchInputs(const CBlock& block) {
+  std::vector<uint256> vCreated, vTxid;
+  vCreated.reserve(block.vtx.size());
+  for (const CTransaction& tx : block.vtx) {
+    vCreated.push_back(tx.GetHash());
+    if (tx.IsCoinBase()) continue;
+    for (const CTxIn& txin : tx.vin) {
+      if (txin.scriptSig.IsZerocoinSpend()) continue;
+      vTxid.push_back(txin.prevout.hash);
+    }
+  }
+  std::sort(vTxid.begin(), vTxid.end());
+  vTxid.erase(std::unique(vTxid.begin(), vTxid.end()), vTxid.end());
+
+  // Outputs created earlier in the same block are never in the base view
+  std::sort(vCreated.begin(), vCreated.end());
+  vTxid.erase(std::remove_if(vTxid.begin(), vTxid.end(),
+                             [&vCreated](const uint256& txid) {
+                               return std::binary_search(vCreated.begin(), vCreated.end(), txid);
+                             }),
+              vTxid.end());
+  return FetchCoinsMany(vTxid);
+}
+
 CCoinsModifier CCoinsViewCache::ModifyCoins(const uint256& txid) {
   assert(!hasModifier);
   auto ret = cacheCoins.insert(std::make_pair(txid, CCoinsCacheEntry()));
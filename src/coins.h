@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 /**
 
@@ -297,6 +298,10 @@ class CCoinsView {
   //! Retrieve the CCoins (unspent transaction outputs) for a given txid
   virtual bool GetCoins(const uint256& txid, CCoins& coins) const;
 
+  //! Retrieve the CCoins for several txids at once; vFound[i] tells whether vCoins[i] was found
+  virtual void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                            std::vector<bool>& vFound) const;
+
   //! Just check whether we have data for a given txid.
   //! This may (but cannot always) return true for fully spent transactions
   virtual bool HaveCoins(const uint256& txid) const;
@@ -323,6 +328,8 @@ class CCoinsViewBacked : public CCoinsView {
  public:
   CCoinsViewBacked(CCoinsView* viewIn);
   bool GetCoins(const uint256& txid, CCoins& coins) const;
+  //! Forwards the whole batch to base, so a subclass that overrides GetCoins must override this too
+  void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins, std::vector<bool>& vFound) const;
   bool HaveCoins(const uint256& txid) const;
   uint256 GetBestBlock() const;
   void SetBackend(CCoinsView& viewIn);
@@ -330,6 +337,7 @@ class CCoinsViewBacked : public CCoinsView {
   bool GetStats(CCoinsStats& stats) const;
 };
 
+class CBlock;
 class CCoinsViewCache;
 
 /** Flags for nSequence and nLockTime locks  -already in consensus.h */
@@ -374,6 +382,7 @@ class CCoinsViewCache : public CCoinsViewBacked {
 
   // Standard CCoinsView methods
   bool GetCoins(const uint256& txid, CCoins& coins) const;
+  void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins, std::vector<bool>& vFound) const;
   bool HaveCoins(const uint256& txid) const;
   uint256 GetBestBlock() const;
   void SetBestBlock(const uint256& hashBlock);
@@ -393,6 +402,13 @@ class CCoinsViewCache : public CCoinsViewBacked {
    */
   CCoinsModifier ModifyCoins(const uint256& txid);
 
+  /**
+   * Pull the inputs spent by a block into the cache with one batched lookup against
+   * the base view, so the per-input lookups during validation are served from memory.
+   * Returns the number of txids that had to be fetched.
+   */
+  size_t PrefetchInputs(const CBlock& block);
+
   /**
    * Push the modifications applied to this cache to its base.
    * Failure to call this method before destruction will cause the changes to be forgotten.
@@ -426,4 +442,6 @@ class CCoinsViewCache : public CCoinsViewBacked {
  private:
   CCoinsMap::iterator FetchCoins(const uint256& txid);
   CCoinsMap::const_iterator FetchCoins(const uint256& txid) const;
+  //! Pull every txid not yet cached from the base in one batched call; returns how many were requested
+  size_t FetchCoinsMany(const std::vector<uint256>& vTxid) const;
 };
@@ -0,0 +1,70 @@
+// Copyright (c) 2018 The TessaChain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/hashargon2d.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+//! Arena backing the argon2 allocation callbacks for the hash running on this thread
+thread_local std::vector<uint8_t>* pmemoryActive = nullptr;
+}
+
+CArgon2dContext::CArgon2dContext() : vMemory((size_t)M_COST * BLOCK_SIZE)
+{
+}
+
+int CArgon2dContext::Allocate(uint8_t** memory, size_t bytes_to_allocate)
+{
+    // parallelism is 1, so argon2 never calls back from a thread other than the hashing one
+    if (pmemoryActive->size() < bytes_to_allocate) pmemoryActive->resize(bytes_to_allocate);
+    *memory = pmemoryActive->data();
+    return ARGON2_OK;
+}
+
+void CArgon2dContext::Deallocate(uint8_t* memory, size_t bytes_to_allocate)
+{
+    // The arena is owned by the context and reused by the next hash
+}
+
+uint256 CArgon2dContext::Hash(const unsigned char* data, size_t len)
+{
+    uint256 hash;
+
+    argon2_context context;
+    context.out = hash.begin();
+    context.outlen = (uint32_t)hash.size();
+    context.pwd = const_cast<uint8_t*>(data);
+    context.pwdlen = (uint32_t)len;
+    context.salt = const_cast<uint8_t*>(data);
+    context.saltlen = (uint32_t)len;
+    context.secret = nullptr;
+    context.secretlen = 0;
+    context.ad = nullptr;
+    context.adlen = 0;
+    context.t_cost = T_COST;
+    context.m_cost = M_COST;
+    context.lanes = PARALLELISM;
+    context.threads = PARALLELISM;
+    context.allocate_cbk = &CArgon2dContext::Allocate;
+    context.free_cbk = &CArgon2dContext::Deallocate;
+    context.flags = ARGON2_DEFAULT_FLAGS;
+    context.version = ARGON2_VERSION_NUMBER;
+
+    pmemoryActive = &vMemory;
+    int result = argon2_ctx(&context, Argon2_d);
+    pmemoryActive = nullptr;
+
+    if (result != ARGON2_OK)
+        throw std::runtime_error(std::string("Argon2d hashing failed: ") + argon2_error_message(result));
+    return hash;
+}
+
+CArgon2dContext& CArgon2dContext::ThreadLocal()
+{
+    static thread_local CArgon2dContext context;
+    return context;
+}
@@ -9,22 +9,40 @@
 #include "argon2/argon2.h"
 #include <vector>
 
+/**
+ * Argon2d hasher with the PoW parameters that keeps its block memory between calls,
+ * so repeated header hashes don't pay a 4MB allocation and the page faults on it each time.
+ */
+class CArgon2dContext
+{
+private:
+    std::vector<uint8_t> vMemory;
+
+    static int Allocate(uint8_t** memory, size_t bytes_to_allocate);
+    static void Deallocate(uint8_t* memory, size_t bytes_to_allocate);
+
+    CArgon2dContext(const CArgon2dContext&);
+    CArgon2dContext& operator=(const CArgon2dContext&);
+
+public:
+    static const uint32_t T_COST = 1;      // 1 iteration
+    static const uint32_t M_COST = 4096;   // use 4MB
+    static const uint32_t PARALLELISM = 1; // 1 thread, 1 lane
+    static const size_t BLOCK_SIZE = 1024; // bytes per argon2 memory block
+
+    CArgon2dContext();
+
+    uint256 Hash(const unsigned char* data, size_t len);
+
+    //! The calling thread's context, created on first use and kept until the thread exits
+    static CArgon2dContext& ThreadLocal();
+};
+
 template<typename T1>
 inline uint256 HashArgon2d(const T1 pbegin, const T1 pend)
 {
-    uint32_t t_cost = 1; // 1 iteration
-    uint32_t m_cost = 4096; // use 4MB
-    uint32_t parallelism = 1; // 1 thread, 2 lanes
-    
     static unsigned char pblank[1];
     size_t pwdlen = (pend - pbegin) * sizeof(pbegin[0]);
-    
-    uint256 hash;
-    size_t hashlen = 32;
-    
-    argon2d_hash_raw(t_cost, m_cost, parallelism, (pbegin == pend ? pblank : (unsigned char*)&pbegin[0]), pwdlen,
-                    (pbegin == pend ? pblank : (unsigned char*)&pbegin[0]), pwdlen, (unsigned char*)&hash, hashlen);
-    
-    return hash;
-}
 
+    return CArgon2dContext::ThreadLocal().Hash((pbegin == pend ? pblank : (unsigned char*)&pbegin[0]), pwdlen);
+}
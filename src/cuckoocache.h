@@ -0,0 +1,159 @@
+// Copyright (c) 2016 Jeremy Rubin
+// Copyright (c) 2018 The TessaChain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "uint256.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * One "may be overwritten" bit per table slot, packed eight to a byte.
+ * The bits are atomic so that readers holding only a shared lock can mark
+ * entries for collection while other readers are looking them up.
+ */
+class bit_packed_atomic_flags {
+ private:
+  std::unique_ptr<std::atomic<uint8_t>[]> mem;
+
+ public:
+  explicit bit_packed_atomic_flags(uint32_t size = 0) { setup(size); }
+
+  //! Resize to hold size bits, all set: every slot starts out free
+  void setup(uint32_t size) {
+    uint32_t bytes = (size + 7) / 8;
+    mem.reset(new std::atomic<uint8_t>[bytes]);
+    for (uint32_t i = 0; i < bytes; ++i) mem[i].store(0xFF, std::memory_order_relaxed);
+  }
+
+  void bit_set(uint32_t s) { mem[s >> 3].fetch_or(uint8_t(1 << (s & 7)), std::memory_order_relaxed); }
+  void bit_unset(uint32_t s) { mem[s >> 3].fetch_and(uint8_t(~(1 << (s & 7))), std::memory_order_relaxed); }
+  bool bit_is_set(uint32_t s) const { return (mem[s >> 3].load(std::memory_order_relaxed) >> (s & 7)) & 1; }
+};
+
+/**
+ * Hasher for keys that already are salted 256-bit hashes: the eight cuckoo
+ * hashes are just consecutive 32-bit words of the key.
+ */
+class uint256_word_hasher {
+ public:
+  template <uint8_t hash_select> uint32_t operator()(const uint256& key) const {
+    static_assert(hash_select < 8, "uint256_word_hasher only has 8 hashes available.");
+    uint32_t u;
+    std::memcpy(&u, key.begin() + 4 * hash_select, 4);
+    return u;
+  }
+};
+
+/**
+ * Fixed-size set of hashable elements, laid out as a cuckoo hash table where
+ * every element may live in one of eight slots chosen by Hash::operator()<0..7>.
+ *
+ * Memory use is decided once by setup() and never grows: when all eight slots
+ * of a new element are taken, residents are kicked to their other slots for at
+ * most log2(size) moves, after which the last displaced element is dropped.
+ *
+ * contains() is safe to call concurrently from many threads as long as insert()
+ * and setup() are serialized against it, for example with a shared_mutex.
+ */
+template <typename Element, typename Hash> class cuckoocache {
+ private:
+  std::vector<Element> table;
+  uint32_t size;
+  //! Slots that are free or whose element was erased
+  mutable bit_packed_atomic_flags collection_flags;
+  //! Number of displacements before insert() gives up and drops an element
+  uint8_t depth_limit;
+  const Hash hash_function;
+
+  //! Map a 32-bit hash onto [0, size) without a division
+  uint32_t reduce(uint32_t h) const { return uint32_t((uint64_t(h) * uint64_t(size)) >> 32); }
+
+  std::array<uint32_t, 8> compute_hashes(const Element& e) const {
+    return {{reduce(hash_function.template operator()<0>(e)), reduce(hash_function.template operator()<1>(e)),
+             reduce(hash_function.template operator()<2>(e)), reduce(hash_function.template operator()<3>(e)),
+             reduce(hash_function.template operator()<4>(e)), reduce(hash_function.template operator()<5>(e)),
+             reduce(hash_function.template operator()<6>(e)), reduce(hash_function.template operator()<7>(e))}};
+  }
+
+ public:
+  cuckoocache() : table(), size(0), collection_flags(0), depth_limit(0), hash_function() {}
+
+  //! Allocate room for new_size elements (at least 2); returns the number of slots
+  uint32_t setup(uint32_t new_size) {
+    size = std::max<uint32_t>(2, new_size);
+    depth_limit = 0;
+    for (uint32_t n = size; n > 1; n >>= 1) ++depth_limit;
+    table.assign(size, Element());
+    collection_flags.setup(size);
+    return size;
+  }
+
+  //! Allocate as many slots as fit in the given number of bytes
+  uint32_t setup_bytes(size_t bytes) {
+    return setup(uint32_t(std::min<size_t>(bytes / sizeof(Element), UINT32_MAX)));
+  }
+
+  uint32_t capacity() const { return size; }
+
+  //! Drop every element. Requires exclusive access.
+  void clear() {
+    std::fill(table.begin(), table.end(), Element());
+    collection_flags.setup(size);
+  }
+
+  //! Add e to the cache, possibly evicting another element. Requires exclusive access.
+  void insert(Element e) {
+    if (table.empty()) return;
+    std::array<uint32_t, 8> locs = compute_hashes(e);
+    for (uint32_t loc : locs) {
+      if (collection_flags.bit_is_set(loc) || table[loc] == e) {
+        table[loc] = std::move(e);
+        collection_flags.bit_unset(loc);
+        return;
+      }
+    }
+
+    uint32_t loc = locs[0];
+    for (uint8_t depth = 0; depth < depth_limit; ++depth) {
+      // Take the slot; e now holds the resident we displaced
+      std::swap(table[loc], e);
+      locs = compute_hashes(e);
+      for (uint32_t next : locs) {
+        if (collection_flags.bit_is_set(next)) {
+          table[next] = std::move(e);
+          collection_flags.bit_unset(next);
+          return;
+        }
+      }
+      // Move on to the slot after the one the displaced element came from
+      uint32_t i = uint32_t(std::find(locs.begin(), locs.end(), loc) - locs.begin());
+      loc = locs[(i + 1) & 7];
+    }
+    // Out of moves: the last displaced element is dropped
+  }
+
+  /**
+   * Check whether e is in the cache. With erase set a hit also frees the slot
+   * for reuse by a later insert(); the element stays visible until then.
+   */
+  bool contains(const Element& e, bool erase) const {
+    if (table.empty()) return false;
+    for (uint32_t loc : compute_hashes(e)) {
+      if (table[loc] == e) {
+        if (erase) collection_flags.bit_set(loc);
+        return true;
+      }
+    }
+    return false;
+  }
+};
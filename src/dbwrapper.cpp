@@ -7,23 +7,30 @@
 #include "dbwrapper.h"
 #include "util.h"
 #include <cstdint>
+#include <map>
 
 #ifndef WIN32
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include <boost/thread.hpp>
 
+namespace {
+//! Read txns each thread holds per database, nested reads must not take cs_map again
+thread_local std::map<const void*, int> mapReadersHeld;
+}
+
 // Assuming same path as Environment
-bool CDbWrapper::init(const fs::path& wallet_dir, const char* pszMode) {
+bool CDbWrapper::init(const fs::path& wallet_dir, const char* pszMode, size_t nMapSizeIn) {
   if (env) return 0;  // Already setup
   // check?
   if (mdb_env_create(&env)) throw std::runtime_error("Failed on creating Db Env");
   fDbEnvInit = false;
-  return open(wallet_dir, pszMode);
+  return open(wallet_dir, pszMode, nMapSizeIn);
 }
 
-bool CDbWrapper::open(const fs::path& wallet_dir, const char* pszMode) {
+bool CDbWrapper::open(const fs::path& wallet_dir, const char* pszMode, size_t nMapSizeIn) {
   if (fDbEnvInit) return 0;
 
   boost::this_thread::interruption_point();
@@ -33,18 +40,26 @@ bool CDbWrapper::open(const fs::path& wallet_dir, const char* pszMode) {
   LogPrintf("CDbWrapperEnv::Open: %s\n", wallet_dir.string());
   int dbr;
 
-  dbr = mdb_env_set_mapsize(env, 10485760);
+  // Not MDB_FIXEDMAP, the map has to be able to move when it grows
+  dbr = mdb_env_set_mapsize(env, nMapSizeIn);
   dbr |= mdb_env_set_maxdbs(env, 4);
 
-  dbr |= mdb_env_open(env, wallet_dir.c_str(), MDB_FIXEDMAP | MDB_NOSYNC, 0664);
+  dbr |= mdb_env_open(env, wallet_dir.c_str(), nEnvFlags | MDB_NOTLS, 0664);
 
   if (dbr != 0) {
-    LogPrintf("CDbWrapperEnv::Open : Error opening database environment:\n");
+    LogPrintf("CDbWrapperEnv::Open: Error opening database env %s\n", wallet_dir.string());
     Close();
-    return -1;
+    return dbr;
   }
 
+  // Preallocate() must not touch the file of a read-only open
   fReadOnly = (!strchr(pszMode, '+') && !strchr(pszMode, 'w'));
+
+  // An existing env keeps its own size when that is larger
+  MDB_envinfo info;
+  nMapSize = (mdb_env_info(env, &info) == 0) ? info.me_mapsize : nMapSizeIn;
+  Preallocate();
+
   bool fCreate = false;
 
   activeTxn = TxnBegin();
@@ -62,52 +77,229 @@ bool CDbWrapper::open(const fs::path& wallet_dir, const char* pszMode) {
       fCreate = true;
     }
     if (dbr != 0) {
-      LogPrintf("CDbWrapper : Error, can't open database dbi");
+      LogPrintf("CDbWrapperEnv::Open: Error opening database dbi %s\n", wallet_dir.string());
       Close();
-      return -1;
+      return dbr;
     }
 
-    // if (fCreate) WriteVersion(CLIENT_VERSION);
+    if (fCreate && fVersionOnCreate) WriteVersion(CLIENT_VERSION);
+
+    // The handle only becomes visible to the pooled read txns once committed
+    dbr = TxnCommit();
+    if (dbr != 0) {
+      LogPrintf("CDbWrapperEnv::Open: Error committing database dbi %s\n", wallet_dir.string());
+      Close();
+      return dbr;
+    }
   }
   fDbEnvInit = true;
   return 0;
 }
 
 MDB_cursor* CDbWrapper::GetCursor() const {
+  // The cursor keeps its read txn until cursor_close hands it back
   MDB_cursor* pcursor = nullptr;
-  MDB_txn* Txn = (activeTxn) ? activeTxn : ReadBegin();
-  int dbr = mdb_cursor_open(Txn, dbi, &pcursor);
-  if (dbr != 0) return nullptr;
+  MDB_txn* ptxn = ReadBegin();
+  int dbr = mdb_cursor_open(ptxn, dbi, &pcursor);
+  if (dbr != 0) {
+    ReadEnd(ptxn);
+    return nullptr;
+  }
   return pcursor;
 }
 
 MDB_txn* CDbWrapper::TxnBegin() {
   if (activeTxn) return activeTxn;
+
+  // Grow ahead of time once the map is three quarters used, so most writes never see MDB_MAP_FULL
+  MDB_envinfo info;
+  MDB_stat stat;
+  if (nMapSize && !fReadOnly && !mapReadersHeld.count(this) && mdb_env_info(env, &info) == 0 && mdb_env_stat(env, &stat) == 0 &&
+      (info.me_last_pgno + 1) * stat.ms_psize > nMapSize / 4 * 3)
+    GrowMap();
+
   MDB_txn* ptxn = nullptr;
   int dbr = mdb_txn_begin(env, nullptr, 0, &ptxn);
   if (!ptxn || dbr != 0) return nullptr;
   return ptxn;
 }
 MDB_txn* CDbWrapper::ReadBegin() const {
-  if (activeTxn) return activeTxn;
+  // Inside a batch its owner reads its own uncommitted writes
+  if (idBatchOwner.load() == std::this_thread::get_id()) return activeTxn;
+
+  // Keeps the map in place until ReadEnd
+  int& nHeld = mapReadersHeld[this];
+  if (nHeld++ == 0) cs_map.lock_shared();
+
   MDB_txn* ptxn = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(cs_readers);
+    if (!vReadTxnPool.empty()) {
+      ptxn = vReadTxnPool.back();
+      vReadTxnPool.pop_back();
+    }
+  }
+  if (ptxn) {
+    if (mdb_txn_renew(ptxn) == 0) return ptxn;
+    mdb_txn_abort(ptxn);
+    ptxn = nullptr;
+  }
   int dbr = mdb_txn_begin(env, nullptr, MDB_RDONLY, &ptxn);
-  if (!ptxn || dbr != 0) return nullptr;
+  if (!ptxn || dbr != 0) {
+    if (--nHeld == 0) {
+      mapReadersHeld.erase(this);
+      cs_map.unlock_shared();
+    }
+    return nullptr;
+  }
   return ptxn;
 }
 
-// Cursor only currently used in read only situations, not used
+void CDbWrapper::ReadEnd(MDB_txn* ptxn) const {
+  if (!ptxn) return;
+  if (idBatchOwner.load() == std::this_thread::get_id() && ptxn == activeTxn) return;
+
+  // Resetting releases the snapshot but keeps the reader slot for the next renew
+  mdb_txn_reset(ptxn);
+  {
+    std::lock_guard<std::mutex> lock(cs_readers);
+    if (vReadTxnPool.size() < MAX_POOLED_READERS) {
+      vReadTxnPool.push_back(ptxn);
+      ptxn = nullptr;
+    }
+  }
+  if (ptxn) mdb_txn_abort(ptxn);
+
+  auto it = mapReadersHeld.find(this);
+  if (it != mapReadersHeld.end() && --it->second == 0) {
+    mapReadersHeld.erase(it);
+    cs_map.unlock_shared();
+  }
+}
+
+int CDbWrapper::Apply(MDB_val& datKey, MDB_val* pdatValue, unsigned int nFlags) {
+  if (!activeTxn) return EINVAL;
+  if (!pdatValue) return mdb_del(activeTxn, dbi, &datKey, nullptr);
+  return mdb_put(activeTxn, dbi, &datKey, pdatValue, nFlags);
+}
+
+int CDbWrapper::Put(MDB_val& datKey, MDB_val* pdatValue, unsigned int nFlags) {
+  if (nBatchDepth) {
+    CBatchOp op;
+    op.vchKey.assign((char*)datKey.mv_data, (char*)datKey.mv_data + datKey.mv_size);
+    if (pdatValue) op.vchValue.assign((char*)pdatValue->mv_data, (char*)pdatValue->mv_data + pdatValue->mv_size);
+    op.fErase = !pdatValue;
+    op.nFlags = nFlags;
+    vBatchOps.push_back(op);
+
+    activeTxn = TxnBegin();
+    int dbr = Apply(datKey, pdatValue, nFlags);
+    if (dbr == MDB_MAP_FULL) dbr = ReplayBatch();
+    return dbr;
+  }
+
+  int dbr;
+  do {
+    activeTxn = TxnBegin();
+    dbr = Apply(datKey, pdatValue, nFlags);
+    if (!activeTxn) break;
+    if (dbr == MDB_MAP_FULL) {
+      TxnAbort();
+      continue;
+    }
+    int dbrCommit = mdb_txn_commit(activeTxn);
+    activeTxn = nullptr;
+    if (dbrCommit) dbr = dbrCommit;
+  } while (dbr == MDB_MAP_FULL && GrowMap());
+  return dbr;
+}
+
+int CDbWrapper::ReplayBatch() {
+  int dbr = MDB_MAP_FULL;
+  while (dbr == MDB_MAP_FULL) {
+    // A txn that hit MDB_MAP_FULL is unusable, start over in a larger map
+    if (activeTxn) TxnAbort();
+    if (!GrowMap()) return MDB_MAP_FULL;
+    activeTxn = TxnBegin();
+    dbr = 0;
+    for (CBatchOp& op : vBatchOps) {
+      MDB_val datKey, datValue;
+      datKey.mv_data = op.vchKey.data();
+      datKey.mv_size = op.vchKey.size();
+      datValue.mv_data = op.vchValue.data();
+      datValue.mv_size = op.vchValue.size();
+      dbr = Apply(datKey, op.fErase ? nullptr : &datValue, op.nFlags);
+      if (dbr == MDB_MAP_FULL) break;
+    }
+  }
+  return dbr;
+}
+
+int CDbWrapper::CommitBatch() {
+  int dbr = 0;
+  if (activeTxn) {
+    dbr = mdb_txn_commit(activeTxn);
+    activeTxn = nullptr;
+  }
+  while (dbr == MDB_MAP_FULL) {
+    if (ReplayBatch() == MDB_MAP_FULL) break;
+    dbr = mdb_txn_commit(activeTxn);
+    activeTxn = nullptr;
+  }
+  vBatchOps.clear();
+  return dbr;
+}
+
+bool CDbWrapper::GrowMap() {
+  // Waiting for our own read txn to end would never return
+  if (mapReadersHeld.count(this)) return error("%s : cannot resize map while this thread holds a read txn", __func__);
+
+  // Wait for open read txns, bounded in case one of them is itself waiting on cs_db
+  for (int i = 0; !cs_map.try_lock(); i++) {
+    if (i >= 500) return error("%s : timed out waiting for readers to resize map", __func__);
+    MilliSleep(10);
+  }
+  size_t nNewSize = nMapSize * 2;
+  int dbr = mdb_env_set_mapsize(env, nNewSize);
+  if (dbr == 0) nMapSize = nNewSize;
+  cs_map.unlock();
+
+  if (dbr != 0) return error("%s : mdb_env_set_mapsize failed: %s", __func__, mdb_strerror(dbr));
+  Preallocate();
+  LogPrintf("%s : map grown to %u MiB\n", __func__, nMapSize >> 20);
+  return true;
+}
+
+void CDbWrapper::Preallocate() {
+#ifndef WIN32
+  // A sparse extension reserves the size without writing any blocks
+  mdb_filehandle_t fd;
+  struct stat st;
+  if (fReadOnly || mdb_env_get_fd(env, &fd) != 0 || fstat(fd, &st) != 0) return;
+  if ((size_t)st.st_size < nMapSize && ftruncate(fd, nMapSize) != 0)
+    LogPrintf("%s : could not extend data file to %u MiB\n", __func__, nMapSize >> 20);
+#endif
+}
+
+// Cursors only run on read txns, so there is nothing to commit
 bool CDbWrapper::cursor_commit(MDB_cursor* pcursor) {
+  cursor_close(pcursor);
+  return false;
+}
+void CDbWrapper::cursor_close(MDB_cursor* pcursor) {
+  MDB_txn* ptxn = mdb_cursor_txn(pcursor);
   mdb_cursor_close(pcursor);
-  int dbr = mdb_txn_commit(activeTxn);
-  activeTxn = nullptr;
-  return dbr;
+  ReadEnd(ptxn);
 }
-void CDbWrapper::cursor_close(MDB_cursor* pcursor) { mdb_cursor_close(pcursor); }
 
 void CDbWrapper::Close() {
   fDbEnvInit = false;
   if (activeTxn) mdb_txn_abort(activeTxn);
+  {
+    std::lock_guard<std::mutex> lock(cs_readers);
+    for (MDB_txn* ptxn : vReadTxnPool) mdb_txn_abort(ptxn);
+    vReadTxnPool.clear();
+  }
   if (dbi) mdb_dbi_close(env, dbi);
   if (env) mdb_env_close(env);
   env = nullptr;
@@ -150,7 +342,7 @@ int CDbWrapper::ReadAtCursor(MDB_cursor* pcursor, CDataStream& ssKey, CDataStrea
     datValue.mv_size = ssValue.size();
   }
 
-  int dbr = mdb_cursor_get(pcursor, &datKey, &datValue, MDB_NEXT);
+  int dbr = mdb_cursor_get(pcursor, &datKey, &datValue, (MDB_cursor_op)fFlags);
 
   if (dbr) return dbr;
 
@@ -176,9 +368,8 @@ bool CDbWrapper::Write(CDataStream& key, CDataStream& value, bool fOverwrite) {
   datValue.mv_size = value.size();
 
   // Write
-  activeTxn = TxnBegin();
-  int dbr = mdb_put(activeTxn, dbi, &datKey, &datValue, (fOverwrite ? 0 : MDB_NOOVERWRITE));
-  dbr |= TxnCommit();
+  LOCK(cs_db);
+  int dbr = Put(datKey, &datValue, (fOverwrite ? 0 : MDB_NOOVERWRITE));
 
   // Clear memory in case it was a private key
   memset(datKey.mv_data, 0, datKey.mv_size);
@@ -191,9 +382,9 @@ bool CDbWrapper::Exists(CDataStream& key) {
   datKey.mv_size = key.size();
 
   // Exists
-  activeTxn = TxnBegin();
-  int dbr = mdb_get(activeTxn, dbi, &datKey, 0);
-  dbr |= TxnCommit();
+  MDB_val datValue;
+  CReadTxn txn(*this);
+  int dbr = mdb_get(txn.get(), dbi, &datKey, &datValue);
 
   // if non-zero, it doesn't exist!
   return (dbr == 0);
@@ -206,9 +397,8 @@ bool CDbWrapper::Erase(CDataStream& key) {
   datKey.mv_size = key.size();
 
   // Erase
-  activeTxn = TxnBegin();
-  int dbr = mdb_del(activeTxn, dbi, &datKey, 0);
-  dbr |= TxnCommit();
+  LOCK(cs_db);
+  int dbr = Put(datKey, nullptr, 0);
   return (dbr == 0 || dbr == MDB_NOTFOUND);
 }
 bool CDbWrapper::Read(CDataStream& key, CDataStream& value) {
@@ -219,9 +409,8 @@ bool CDbWrapper::Read(CDataStream& key, CDataStream& value) {
 
   // Read
   MDB_val datValue;
-  activeTxn = TxnBegin();
-  int dbr = mdb_get(activeTxn, dbi, &datKey, &datValue);
-  dbr |= TxnCommit();
+  CReadTxn txn(*this);
+  int dbr = mdb_get(txn.get(), dbi, &datKey, &datValue);
 
   if (dbr) return false;
   // Throw if ret ! = 0!!!!
@@ -232,3 +421,42 @@ bool CDbWrapper::Read(CDataStream& key, CDataStream& value) {
   } catch (const std::exception&) { return false; }
   return (dbr == 0);
 }
+
+CDbWrapperBatch::CDbWrapperBatch(CDbWrapper& dbIn) : db(dbIn), fDone(false) {
+  ENTER_CRITICAL_SECTION(db.cs_db);
+  if (db.nBatchDepth++ == 0) {
+    db.fBatchAborted = false;
+    db.activeTxn = db.TxnBegin();
+    db.idBatchOwner = std::this_thread::get_id();
+  }
+}
+
+CDbWrapperBatch::~CDbWrapperBatch() {
+  if (!fDone) Abort();
+  LEAVE_CRITICAL_SECTION(db.cs_db);
+}
+
+bool CDbWrapperBatch::Commit() {
+  if (fDone) return false;
+  fDone = true;
+  if (--db.nBatchDepth > 0) return true;
+  db.idBatchOwner = std::thread::id();
+  if (db.fBatchAborted) {
+    if (db.activeTxn) db.TxnAbort();
+    db.vBatchOps.clear();
+    return false;
+  }
+  return db.CommitBatch() == 0;
+}
+
+void CDbWrapperBatch::Abort() {
+  if (fDone) return;
+  fDone = true;
+  if (--db.nBatchDepth > 0) {
+    db.fBatchAborted = true;
+    return;
+  }
+  db.idBatchOwner = std::thread::id();
+  if (db.activeTxn) db.TxnAbort();
+  db.vBatchOps.clear();
+}
@@ -13,28 +13,98 @@
 #include "sync.h"
 #include "version.h"
 
+#include <atomic>
+#include <boost/thread/shared_mutex.hpp>
 #include <lmdb.h>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+//! Initial size of the LMDB map in MiB, it doubles whenever it fills up
+static const int64_t DEFAULT_DB_MAPSIZE = 64;
+
+class CDbWrapperBatch;
 
 class CDbWrapper {
+  friend class CDbWrapperBatch;
+
  protected:
   const int KEY_RESERVE = 100;
   MDB_dbi dbi = 0;
   MDB_txn* activeTxn = nullptr;
   MDB_env* env = nullptr;
-  bool fReadOnly;
-  bool fDbEnvInit;
+  bool fReadOnly = false;
+  bool fDbEnvInit = false;
+  //! Extra mdb_env_open flags, MDB_NOTLS is always added for the read txn pool
+  const unsigned int nEnvFlags;
+  //! Stamp a newly created database with the client version
+  const bool fVersionOnCreate;
+  //! Nesting depth of the open CDbWrapperBatch, Write/Erase only commit at depth 0
+  int nBatchDepth = 0;
+  //! Set when an inner batch was abandoned so the outer one cannot commit it
+  bool fBatchAborted = false;
+  //! Thread that opened the batch, only it may read through activeTxn
+  std::atomic<std::thread::id> idBatchOwner{std::thread::id()};
+
+  /** One Write/Erase of the open batch, kept so it can be replayed after the map grows */
+  struct CBatchOp {
+    CSerializeData vchKey;
+    CSerializeData vchValue;
+    bool fErase;
+    unsigned int nFlags;
+  };
+  std::vector<CBatchOp> vBatchOps;
+
+  //! Current map size in bytes
+  size_t nMapSize = 0;
+  //! Held shared by every read txn and exclusively while the map is resized
+  mutable boost::shared_mutex cs_map;
+
+  //! Most reset read-only txns kept around for renewal
+  static const size_t MAX_POOLED_READERS = 16;
+  //! Reset read-only txns, the env is opened with MDB_NOTLS so any thread can renew them
+  mutable std::vector<MDB_txn*> vReadTxnPool;
+  mutable std::mutex cs_readers;
+
+  /** Read txn borrowed from the pool for the duration of one lookup */
+  class CReadTxn {
+   private:
+    const CDbWrapper& db;
+    MDB_txn* ptxn;
+
+   public:
+    explicit CReadTxn(const CDbWrapper& dbIn) : db(dbIn), ptxn(dbIn.ReadBegin()) {}
+    ~CReadTxn() { db.ReadEnd(ptxn); }
+    MDB_txn* get() const { return ptxn; }
+  };
 
  public:
-  CDbWrapper() {}
-  ~CDbWrapper() { Close(); }
+  explicit CDbWrapper(unsigned int nEnvFlagsIn = MDB_NOSYNC, bool fVersionOnCreateIn = false)
+      : nEnvFlags(nEnvFlagsIn), fVersionOnCreate(fVersionOnCreateIn) {}
+  virtual ~CDbWrapper() { Close(); }
   mutable CCriticalSection cs_db;
-  bool init(const fs::path& wallet_dir, const char* pszMode = "r+");
-  bool open(const fs::path& wallet_dir, const char* pszMode = "r+");
+  bool init(const fs::path& wallet_dir, const char* pszMode = "r+", size_t nMapSizeIn = DEFAULT_DB_MAPSIZE << 20);
+  bool open(const fs::path& wallet_dir, const char* pszMode = "r+", size_t nMapSizeIn = DEFAULT_DB_MAPSIZE << 20);
   void Close();
 
   MDB_txn* TxnBegin();
+  //! Borrow a read txn, which must be handed back with ReadEnd
   MDB_txn* ReadBegin() const;
+  void ReadEnd(MDB_txn* ptxn) const;
+
+ protected:
+  //! Apply a put, or an erase when pdatValue is null, growing the map and retrying on MDB_MAP_FULL
+  int Put(MDB_val& datKey, MDB_val* pdatValue, unsigned int nFlags);
+  int Apply(MDB_val& datKey, MDB_val* pdatValue, unsigned int nFlags);
+  //! Redo the open batch in a fresh txn after growing the map
+  int ReplayBatch();
+  int CommitBatch();
+  bool GrowMap();
+  //! Extend the data file to the map size without allocating the blocks
+  void Preallocate();
+
+ public:
 
   template <typename K, typename T> bool Read(const K& key, T& value) const {
     // Key
@@ -45,10 +115,10 @@ class CDbWrapper {
     datKey.mv_data = &ssKey[0];
     datKey.mv_size = ssKey.size();
 
-    // Read
+    // Read, datValue points into the map and is only valid while txn is live
     MDB_val datValue;
-    MDB_txn* Txn = ReadBegin();
-    int dbr = mdb_get(Txn, dbi, &datKey, &datValue);
+    CReadTxn txn(*this);
+    int dbr = mdb_get(txn.get(), dbi, &datKey, &datValue);
     if (dbr) return false;
     // Throw if ret ! = 0!!!!
 
@@ -74,16 +144,15 @@ class CDbWrapper {
 
     // Value
     CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-    ssValue.reserve(10000);
+    ssValue.reserve(ssValue.GetSerializeSize(value));
     ssValue << value;
     MDB_val datValue;
     datValue.mv_data = &ssValue[0];
     datValue.mv_size = ssValue.size();
 
     // Write
-    activeTxn = TxnBegin();
-    int ret = mdb_put(activeTxn, dbi, &datKey, &datValue, (fOverwrite ? 0 : MDB_NOOVERWRITE));
-    ret |= TxnCommit();
+    LOCK(cs_db);
+    int ret = Put(datKey, &datValue, (fOverwrite ? 0 : MDB_NOOVERWRITE));
 
     // Clear memory in case it was a private key
     memset(datKey.mv_data, 0, datKey.mv_size);
@@ -103,9 +172,8 @@ class CDbWrapper {
     datKey.mv_size = ssKey.size();
 
     // Erase
-    activeTxn = TxnBegin();
-    int ret = mdb_del(activeTxn, dbi, &datKey, 0);
-    ret |= TxnCommit();
+    LOCK(cs_db);
+    int ret = Put(datKey, nullptr, 0);
     return (ret == 0 || ret == MDB_NOTFOUND);
   }
 
@@ -119,8 +187,9 @@ class CDbWrapper {
     datKey.mv_size = ssKey.size();
 
     // Exists
-    MDB_txn* Txn = ReadBegin();
-    int ret = mdb_get(Txn, dbi, &datKey, 0);
+    MDB_val datValue;
+    CReadTxn txn(*this);
+    int ret = mdb_get(txn.get(), dbi, &datKey, &datValue);
     // if non-zero, it doesn't exist!
     return (ret == 0);
   }
@@ -145,3 +214,24 @@ class CDbWrapper {
   bool Exists(CDataStream& key);
   bool Erase(CDataStream& key);
 };
+
+/**
+ * Groups every Write/Erase made on the database while it is in scope into a
+ * single LMDB transaction. cs_db is held for the lifetime of the batch so other
+ * writers wait instead of joining it. Nothing is written unless Commit() is
+ * called; a batch opened inside another one joins the outer transaction.
+ */
+class CDbWrapperBatch {
+ private:
+  CDbWrapper& db;
+  bool fDone;
+
+ public:
+  explicit CDbWrapperBatch(CDbWrapper& dbIn);
+  ~CDbWrapperBatch();
+
+  //! Commit the grouped writes, returns false if LMDB rejected them
+  bool Commit();
+  //! Discard the grouped writes
+  void Abort();
+};
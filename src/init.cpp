@@ -22,12 +22,15 @@
 #include "httprpc.h"
 #include "httpserver.h"
 #include "ecdsa/key.h"
+#include "libzerocoin/ParallelFor.h"
+#include "libzerocoin/ZerocoinParams.h"
 #include "main.h"
 #include "miner.h"
 #include "net.h"
 #include "reverse_iterate.h"
 #include "rpc/server.h"
 #include "scheduler.h"
+#include "script/sigcache.h"
 #include "script/standard.h"
 #include "spork.h"
 #include "sporkdb.h"
@@ -149,6 +152,16 @@ class CCoinsViewErrorCatcher : public CCoinsViewBacked {
       abort();
     }
   }
+  void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins, std::vector<bool>& vFound) const {
+    try {
+      CCoinsViewBacked::GetCoinsMany(vTxid, vCoins, vFound);
+    } catch (const std::runtime_error& e) {
+      uiInterface.ThreadSafeMessageBox(_("Error reading from database, shutting down."), "",
+                                       CClientUIInterface::MSG_ERROR);
+      LogPrintf("Error reading from database: %s\n", e.what());
+      abort();
+    }
+  }
   // Writes do not need similar protection, as failure to write is handled by the caller.
 };
 
@@ -246,6 +259,7 @@ void Shutdown() {
   pwalletMain = nullptr;
   if (zwalletMain) delete zwalletMain;
   zwalletMain = nullptr;
+  libzerocoin::SetProofThreads(1);
   globalVerifyHandle.reset();
   ECC_Stop();
   LogPrintf("%s: done\n", __func__);
@@ -322,6 +336,11 @@ std::string HelpMessage(HelpMessageMode mode) {
                                                nMinDbCache, nMaxDbCache, nDefaultDbCache));
   strUsage +=
       HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
+  strUsage += HelpMessageOpt(
+      "-loadindexthreads=<n>",
+      strprintf(_("Set the number of threads decoding the block index on startup (%u to %d, 0 = auto, <0 = leave "
+                  "that many cores free, default: %d)"),
+                -(int)boost::thread::hardware_concurrency(), MAX_LOADINDEX_THREADS, DEFAULT_LOADINDEX_THREADS));
   strUsage += HelpMessageOpt("-maxreorg=<n>", strprintf(_("Set the Maximum reorg depth (default: %u)"),
                                                         Params(CBaseChainParams::MAIN).MaxReorganizationDepth()));
   strUsage += HelpMessageOpt("-maxorphantx=<n>",
@@ -331,6 +350,11 @@ std::string HelpMessage(HelpMessageMode mode) {
                                                      "auto, <0 = leave that many cores free, default: %d)"),
                                                    -(int)boost::thread::hardware_concurrency(), MAX_SCRIPTCHECK_THREADS,
                                                    DEFAULT_SCRIPTCHECK_THREADS));
+  strUsage += HelpMessageOpt(
+      "-zkpthreads=<n>",
+      strprintf(_("Set the number of threads evaluating one zerocoin serial number proof (%u to %d, 0 = auto, <0 = "
+                  "leave that many cores free, default: %d)"),
+                -(int)boost::thread::hardware_concurrency(), libzerocoin::MAX_PROOF_THREADS, DEFAULT_ZKP_THREADS));
 #ifndef WIN32
   strUsage += HelpMessageOpt("-pid=<file>", strprintf(_("Specify pid file (default: %s)"), "tessad.pid"));
 #endif
@@ -441,6 +465,10 @@ std::string HelpMessage(HelpMessageMode mode) {
                                          1));
     strUsage += HelpMessageOpt("-wallet=<file>", _("Specify wallet directory (within data directory)") + " " +
                                                      strprintf(_("(default: %s)"), "wallet"));
+    strUsage += HelpMessageOpt("-walletmapsize=<n>",
+                               strprintf(_("Initial size of the wallet database map in megabytes, it grows "
+                                           "automatically when full (default: %u)"),
+                                         DEFAULT_WALLET_MAPSIZE));
     strUsage += HelpMessageOpt("-walletnotify=<cmd>",
                                _("Execute command when a wallet transaction changes (%s in cmd is replaced by TxID)"));
     if (mode == HMM_BITCOIN_QT) strUsage += HelpMessageOpt("-windowtitle=<name>", _("Wallet window title"));
@@ -468,7 +496,8 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage +=
         HelpMessageOpt("-checkblockindex",
                        strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive "
-                                 "and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)",
+                                 "and mapBlocksUnlinked occasionally, and re-derive stored block hashes at startup. "
+                                 "Also sets -checkmempool (default: %u)",
                                  Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
     strUsage +=
         HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)",
@@ -520,8 +549,8 @@ std::string HelpMessage(HelpMessageMode mode) {
     strUsage +=
         HelpMessageOpt("-relaypriority",
                        strprintf(_("Require high priority for relaying free or low-fee transactions (default:%u)"), 1));
-    strUsage += HelpMessageOpt("-maxsigcachesize=<n>",
-                               strprintf(_("Limit size of signature cache to <n> entries (default: %u)"), 50000));
+    strUsage += HelpMessageOpt("-sigcachemaxsize=<n>", strprintf(_("Limit size of signature cache to <n> MiB (default: %u)"),
+                                                                  DEFAULT_MAX_SIG_CACHE_SIZE));
   }
   strUsage += HelpMessageOpt(
       "-minrelaytxfee=<amt>",
@@ -808,6 +837,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
   signal(SIGPIPE, SIG_IGN);
 #endif
 
+  // Recycle the limbs of GMP temporaries per thread instead of going through malloc each time
+  SetBignumPooling(true);
+
   // ********************************************************* Step 2: parameter interactions
   // Set this early so that parameter interactions go to console
   fLogIPs = GetBoolArg("-logips", false);
@@ -909,6 +941,19 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
   if (GetBoolArg("-benchmark", false))
     InitWarning(_("Warning: Unsupported argument -benchmark ignored, use -debug=bench."));
 
+  // -maxsigcachesize counted entries, the cache is sized in MiB of 32 byte entries now
+  if (gArgs.IsArgSet("-maxsigcachesize")) {
+    int64_t nEntries = std::min(std::max(GetArg("-maxsigcachesize", 0), (int64_t)0),
+                                (MAX_MAX_SIG_CACHE_SIZE << 20) / (int64_t)sizeof(uint256));
+    int64_t nMiB = (nEntries * (int64_t)sizeof(uint256) + (1 << 20) - 1) >> 20;
+    if (SoftSetArg("-sigcachemaxsize", std::to_string(nMiB)))
+      InitWarning(strprintf(
+          _("Warning: -maxsigcachesize is deprecated, using -sigcachemaxsize=%d (MiB) for its %d entries."), nMiB,
+          nEntries));
+    else
+      InitWarning(_("Warning: Unsupported argument -maxsigcachesize ignored, use -sigcachemaxsize."));
+  }
+
   // Checkmempool and checkblockindex default to true in regtest mode
   mempool.setSanityCheck(GetBoolArg("-checkmempool", Params().DefaultConsistencyChecks()));
   fCheckBlockIndex = GetBoolArg("-checkblockindex", Params().DefaultConsistencyChecks());
@@ -922,6 +967,14 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
   else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
     nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+  // -loadindexthreads=0 means autodetect, a single thread decodes inline on the loading thread
+  nLoadIndexThreads = GetArg("-loadindexthreads", DEFAULT_LOADINDEX_THREADS);
+  if (nLoadIndexThreads <= 0) nLoadIndexThreads += boost::thread::hardware_concurrency();
+  if (nLoadIndexThreads < 1)
+    nLoadIndexThreads = 1;
+  else if (nLoadIndexThreads > MAX_LOADINDEX_THREADS)
+    nLoadIndexThreads = MAX_LOADINDEX_THREADS;
+
   bool fServer = gArgs.GetBoolArg("-server", false);
   setvbuf(stdout, nullptr, _IOLBF, 0);  /// ***TODO*** do we still need this after -printtoconsole is gone?
 
@@ -979,6 +1032,9 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
   if (sodium_init() < 0) { throw string("Libsodium initialization failed."); }
   ECC_Start();
   globalVerifyHandle.reset(new ECCVerifyHandle());
+  InitSignatureCache();
+  // Powers of the zerocoin group generators, shared by every proof we create or verify
+  libzerocoin::gpZerocoinParams->Precompute();
 
   // Sanity check
   if (!InitSanityCheck()) return InitError(_("Initialization sanity check failed. Tessa Core is shutting down."));
@@ -1031,8 +1087,14 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
   LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
   if (nScriptCheckThreads) {
     for (int i = 0; i < nScriptCheckThreads - 1; i++) threadGroup.create_thread(&ThreadScriptCheck);
+    for (int i = 0; i < nScriptCheckThreads - 1; i++) threadGroup.create_thread(&ThreadZerocoinCheck);
   }
 
+  int nZkpThreads = GetArg("-zkpthreads", DEFAULT_ZKP_THREADS);
+  if (nZkpThreads <= 0) nZkpThreads += boost::thread::hardware_concurrency();
+  libzerocoin::SetProofThreads(std::max(nZkpThreads, 1));
+  LogPrintf("Using %u threads per zerocoin serial number proof\n", libzerocoin::GetProofThreads());
+
   if (gArgs.IsArgSet("-sporkkey"))  // spork priv key
   {
     if (!gSporkManager.SetPrivKey(GetArg("-sporkkey", "")))
@@ -1150,7 +1212,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
     LogPrintf("Using wallet %s\n", strWalletDir);
     uiInterface.InitMessage(_("Verifying wallet..."));
 
-    if (gWalletDB.init(strWalletPath)) {
+    size_t nWalletMapSize = (size_t)std::max(GetArg("-walletmapsize", DEFAULT_WALLET_MAPSIZE), (int64_t)1) << 20;
+    if (gWalletDB.init(strWalletPath, "r+", nWalletMapSize)) {
       // try moving env out of the way
       fs::path pathDatabaseBak = GetDataDir() / strprintf("wallet.%d.bak", GetTime());
       try {
@@ -1161,7 +1224,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
       }
 
       // try again
-      if (gWalletDB.init(strWalletPath)) {
+      if (gWalletDB.init(strWalletPath, "r+", nWalletMapSize)) {
         // if it still fails, it probably means we can't even create the database env
         string msg = strprintf(_("Error initializing wallet database environment %s!"), strDataDir);
         return InitError(msg);
@@ -1539,6 +1602,12 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler) {
     pwalletMain->setZWallet(zwalletMain);
 
     RegisterValidationInterface(pwalletMain);
+    // Keep the mint witnesses current away from the validation thread
+    scheduler.scheduleEvery(
+        [] {
+          if (pwalletMain) pwalletMain->UpdateMintWitnesses();
+        },
+        WITNESS_UPDATE_INTERVAL);
 
     CBlockIndex* pindexRescan = chainActive.Tip();
     if (GetBoolArg("-rescan", false))
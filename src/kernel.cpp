@@ -7,16 +7,23 @@
 #include "kernel.h"
 #include "chainparams.h"
 #include "db.h"
+#include "libzerocoin/ParallelFor.h"
 #include "script/interpreter.h"
 #include "stakeinput.h"
 #include "timedata.h"
+#include "txdb.h"
 #include "util.h"
 
+#include <atomic>
+
 using namespace std;
 
 // Hard checkpoints of stake modifiers to ensure they are deterministic
 static std::map<int, unsigned int> mapStakeModifierCheckpoints = {{0, 0xfd11f4e7u}};
 
+// Timestamps after nTimeTx a staker tries for each input
+static const int STAKE_HASH_DRIFT = 30;
+
 // Get time weight
 int64_t GetWeight(int64_t nIntervalBeginning, int64_t nIntervalEnd) {
   return nIntervalEnd - nIntervalBeginning - Params().StakeMinAge();
@@ -211,6 +218,13 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
 bool GetKernelStakeModifier(uint256 hashBlockFrom, uint64_t& nStakeModifier, int& nStakeModifierHeight,
                             int64_t& nStakeModifierTime, bool fPrintProofOfStake) {
   nStakeModifier = 0;
+  CStakeModifierEntry entry;
+  if (stakeModifierCache.Get(hashBlockFrom, entry)) {
+    nStakeModifier = entry.nStakeModifier;
+    nStakeModifierHeight = entry.nStakeModifierHeight;
+    nStakeModifierTime = entry.nStakeModifierTime;
+    return true;
+  }
   if (!mapBlockIndex.count(hashBlockFrom)) return error("GetKernelStakeModifier() : block not indexed");
   const CBlockIndex* pindexFrom = mapBlockIndex[hashBlockFrom];
   nStakeModifierHeight = pindexFrom->nHeight;
@@ -238,74 +252,192 @@ bool GetKernelStakeModifier(uint256 hashBlockFrom, uint64_t& nStakeModifier, int
     }
   }
   nStakeModifier = pindex->nStakeModifier;
+
+  // Only a walk that got a full selection interval ahead is final
+  if (pindexNext) {
+    entry.nStakeModifier = nStakeModifier;
+    entry.nStakeModifierHeight = nStakeModifierHeight;
+    entry.nStakeModifierTime = nStakeModifierTime;
+    entry.nHeightLast = pindexNext->nHeight;
+    entry.hashLast = pindexNext->GetBlockHash();
+    stakeModifierCache.Put(hashBlockFrom, entry);
+  }
+  return true;
+}
+
+CStakeModifierCache stakeModifierCache;
+
+bool CStakeModifierCache::Get(const uint256& hashBlockFrom, CStakeModifierEntry& entry) {
+  LOCK(cs);
+  auto it = mapEntries.find(hashBlockFrom);
+  if (it == mapEntries.end()) return false;
+
+  // The staker walks and Puts without cs_main, so an entry can land after
+  // DisconnectBlock has already purged its height
+  const CBlockIndex* pindexLast = chainActive[it->second.nHeightLast];
+  if (!pindexLast || pindexLast->GetBlockHash() != it->second.hashLast) {
+    auto range = mapByHeight.equal_range(it->second.nHeightLast);
+    for (auto itHeight = range.first; itHeight != range.second; ++itHeight) {
+      if (itHeight->second != hashBlockFrom) continue;
+      mapByHeight.erase(itHeight);
+      break;
+    }
+    mapEntries.erase(it);
+    setDirty.insert(hashBlockFrom);
+    return false;
+  }
+  entry = it->second;
+  return true;
+}
+
+void CStakeModifierCache::Put(const uint256& hashBlockFrom, const CStakeModifierEntry& entry) {
+  LOCK(cs);
+  if (!mapEntries.emplace(hashBlockFrom, entry).second) return;
+  mapByHeight.emplace(entry.nHeightLast, hashBlockFrom);
+  setDirty.insert(hashBlockFrom);
+}
+
+void CStakeModifierCache::DisconnectBlock(int nHeight) {
+  LOCK(cs);
+  auto itFirst = mapByHeight.lower_bound(nHeight);
+  for (auto it = itFirst; it != mapByHeight.end(); ++it) {
+    mapEntries.erase(it->second);
+    setDirty.insert(it->second);
+  }
+  mapByHeight.erase(itFirst, mapByHeight.end());
+}
+
+bool CStakeModifierCache::Flush(CBlockTreeDB& db) {
+  LOCK(cs);
+  if (setDirty.empty()) return true;
+  std::vector<std::pair<uint256, CStakeModifierEntry> > vWrite;
+  std::vector<uint256> vErase;
+  for (const uint256& hash : setDirty) {
+    auto it = mapEntries.find(hash);
+    if (it != mapEntries.end())
+      vWrite.push_back(*it);
+    else
+      vErase.push_back(hash);
+  }
+  if (!db.WriteStakeModifiers(vWrite, vErase)) return false;
+  setDirty.clear();
   return true;
 }
 
-// test hash vs target
-bool stakeTargetHit(uint256 hashProofOfStake, int64_t nValueIn, arith_uint256 bnTargetPerCoinDay) {
+bool CStakeModifierCache::Load(CBlockTreeDB& db) {
+  std::vector<std::pair<uint256, CStakeModifierEntry> > vEntries;
+  if (!db.ReadStakeModifiers(vEntries)) return false;
+
+  LOCK(cs);
+  for (const std::pair<uint256, CStakeModifierEntry>& item : vEntries) {
+    // A chain that moved on while the entry was not yet flushed away leaves it stale
+    const CBlockIndex* pindexLast = chainActive[item.second.nHeightLast];
+    if (!mapBlockIndex.count(item.first) || !pindexLast || pindexLast->GetBlockHash() != item.second.hashLast) {
+      setDirty.insert(item.first);
+      continue;
+    }
+    if (mapEntries.emplace(item.first, item.second).second) mapByHeight.emplace(item.second.nHeightLast, item.first);
+  }
+  LogPrintf("%s : %u stake modifiers, %u stale\n", __func__, mapEntries.size(), setDirty.size());
+  return true;
+}
+
+void CStakeModifierCache::Clear() {
+  LOCK(cs);
+  mapEntries.clear();
+  mapByHeight.clear();
+  setDirty.clear();
+}
+
+CStakeKernel::CStakeKernel(const CDataStream& ssUniqueID, CAmount nValueInIn, uint64_t nStakeModifier,
+                           unsigned int nTimeBlockFromIn)
+    : nValueIn(nValueInIn), nTimeBlockFrom(nTimeBlockFromIn) {
+  ssPrefix << nStakeModifier << nTimeBlockFrom << ssUniqueID;
+}
+
+uint256 CStakeKernel::GetHash(unsigned int nTimeTx) const {
+  CHashWriter ss(ssPrefix);
+  ss << nTimeTx;
+  return ss.GetHash();
+}
+
+arith_uint256 CStakeKernel::GetTarget(const arith_uint256& bnTargetPerCoinDay) const {
   // get the stake weight - weight is equal to coin amount
   arith_uint256 bnCoinDayWeight = arith_uint256(nValueIn) / 100;
+  return bnCoinDayWeight * bnTargetPerCoinDay;
+}
 
-  // Now check if proof-of-stake hash meets target protocol
-  return UintToArith256(hashProofOfStake) < (bnCoinDayWeight * bnTargetPerCoinDay);
+bool CStakeKernel::Search(const arith_uint256& bnTargetPerCoinDay, unsigned int nTimeTx, unsigned int& nTimeHit,
+                          uint256& hashProofOfStake) const {
+  if (nTimeTx < nTimeBlockFrom) return error("CheckStakeKernelHash() : nTime violation");
+
+  if (nTimeBlockFrom + Params().StakeMinAge() > nTimeTx)  // Min age requirement
+    return error("CheckStakeKernelHash() : min age violation - nTimeBlockFrom=%d nStakeMinAge=%d nTimeTx=%d",
+                 nTimeBlockFrom, Params().StakeMinAge(), nTimeTx);
+
+  const arith_uint256 bnTarget = GetTarget(bnTargetPerCoinDay);
+  for (int i = 0; i < STAKE_HASH_DRIFT; i++) {
+    const unsigned int nTryTime = nTimeTx + STAKE_HASH_DRIFT - i;
+    const uint256 hash = GetHash(nTryTime);
+    if (UintToArith256(hash) < bnTarget) {
+      nTimeHit = nTryTime;
+      hashProofOfStake = hash;
+      return true;
+    }
+  }
+  return false;
 }
 
 bool CheckStake(const CDataStream& ssUniqueID, CAmount nValueIn, const uint64_t nStakeModifier,
                 const arith_uint256& bnTarget, unsigned int nTimeBlockFrom, unsigned int& nTimeTx,
                 uint256& hashProofOfStake) {
-  CDataStream ss(SER_GETHASH);
-  ss << nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx;
-  hashProofOfStake = Hash(ss.begin(), ss.end());
+  const CStakeKernel kernel(ssUniqueID, nValueIn, nStakeModifier, nTimeBlockFrom);
+  hashProofOfStake = kernel.GetHash(nTimeTx);
   // LogPrintf("%s: modifier:%d nTimeBlockFrom:%d nTimeTx:%d hash:%s\n", __func__, nStakeModifier, nTimeBlockFrom,
   // nTimeTx, hashProofOfStake.GetHex());
 
-  return stakeTargetHit(hashProofOfStake, nValueIn, bnTarget);
+  return UintToArith256(hashProofOfStake) < kernel.GetTarget(bnTarget);
 }
 
-bool Stake(CStakeInput* stakeInput, unsigned int nBits, unsigned int nTimeBlockFrom, unsigned int& nTimeTx,
-           uint256& hashProofOfStake) {
-  if (nTimeTx < nTimeBlockFrom) return error("CheckStakeKernelHash() : nTime violation");
-
-  if (nTimeBlockFrom + Params().StakeMinAge() > nTimeTx)  // Min age requirement
-    return error("CheckStakeKernelHash() : min age violation - nTimeBlockFrom=%d nStakeMinAge=%d nTimeTx=%d",
-                 nTimeBlockFrom, Params().StakeMinAge(), nTimeTx);
-
+int FindStakeKernel(const std::vector<CStakeKernel>& vKernels, size_t nStart, unsigned int nBits,
+                    unsigned int& nTimeTx, uint256& hashProofOfStake) {
   // grab difficulty
   arith_uint256 bnTargetPerCoinDay;
   bnTargetPerCoinDay.SetCompact(nBits);
 
-  // grab stake modifier
-  uint64_t nStakeModifier = 0;
-  if (!stakeInput->GetModifier(nStakeModifier)) return error("failed to get kernel stake modifier");
-
-  bool fSuccess = false;
-  unsigned int nTryTime = 0;
-  int nHeightStart = chainActive.Height();
-  int nHashDrift = 30;
-  CDataStream ssUniqueID = stakeInput->GetUniqueness();
-  CAmount nValueIn = stakeInput->GetValue();
-  for (int i = 0; i < nHashDrift; i++)  // iterate the hashing
-  {
+  const int nHeightStart = chainActive.Height();
+  const size_t nCount = nStart < vKernels.size() ? vKernels.size() - nStart : 0;
+  // Timestamp of each input's hit, 0 if it missed or was never searched
+  std::vector<unsigned int> vTimeHit(nCount, 0);
+  std::vector<uint256> vHash(nCount);
+  // Lowest input with a hit so far, nCount while there is none
+  std::atomic<size_t> nLowestHit(nCount);
+  std::atomic<bool> fTipChanged(false);
+
+  // Only inputs above the lowest hit are skipped, so every input below the one
+  // returned has been searched in full, whatever order the workers ran in
+  libzerocoin::ParallelFor(nCount, [&](size_t i) {
+    if (fTipChanged || i > nLowestHit) return;
     // new block came in, move on
-    if (chainActive.Height() != nHeightStart) break;
-
-    // hash this iteration
-    nTryTime = nTimeTx + nHashDrift - i;
-
-    // if stake hash does not meet the target then continue to next iteration
-    if (!CheckStake(ssUniqueID, nValueIn, nStakeModifier, bnTargetPerCoinDay, nTimeBlockFrom, nTryTime,
-                    hashProofOfStake))
-      continue;
-
-    fSuccess = true;  // if we make it this far then we have successfully created a stake hash
-    // LogPrintf("%s: hashproof=%s\n", __func__, hashProofOfStake.GetHex());
-    nTimeTx = nTryTime;
-    break;
-  }
+    if (chainActive.Height() != nHeightStart) {
+      fTipChanged = true;
+      return;
+    }
+    if (!vKernels[nStart + i].Search(bnTargetPerCoinDay, nTimeTx, vTimeHit[i], vHash[i])) return;
+    size_t nLowest = nLowestHit;
+    while (i < nLowest && !nLowestHit.compare_exchange_weak(nLowest, i)) {
+    }
+  });
 
   mapHashedBlocks.clear();
   mapHashedBlocks[chainActive.Tip()->nHeight] = GetTime();  // store a time stamp of when we last hashed on this block
-  return fSuccess;
+  if (fTipChanged) return -1;
+
+  const size_t i = nLowestHit;
+  if (i == nCount) return -1;
+  nTimeTx = vTimeHit[i];
+  hashProofOfStake = vHash[i];
+  return nStart + i;
 }
 
 // Check kernel hash target and coinstake signature
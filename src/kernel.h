@@ -5,9 +5,19 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 #pragma once
 
+#include "arith_uint256.h"
+#include "hash.h"
 #include "main.h"
 #include "stakeinput.h"
 #include "staker.h"
+#include "sync.h"
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class CBlockTreeDB;
 
 bool GetCoinAge(const CTransaction& tx, const unsigned int nTxTime, uint64_t& nCoinAge);
 
@@ -16,12 +26,101 @@ bool GetKernelStakeModifier(uint256 hashBlockFrom, uint64_t& nStakeModifier, int
                             int64_t& nStakeModifierTime, bool fPrintProofOfStake);
 bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeModifier, bool& fGeneratedStakeModifier);
 
+/** What GetKernelStakeModifier() found for one block, and the last block of chainActive it looked at */
+struct CStakeModifierEntry {
+  uint64_t nStakeModifier;
+  int nStakeModifierHeight;
+  int64_t nStakeModifierTime;
+  int nHeightLast;
+  uint256 hashLast;
+
+  CStakeModifierEntry() : nStakeModifier(0), nStakeModifierHeight(0), nStakeModifierTime(0), nHeightLast(0) {}
+
+  ADD_SERIALIZE_METHODS
+
+  template <typename Stream, typename Operation> inline void SerializationOp(Stream& s, Operation ser_action) {
+    READWRITE(nStakeModifier);
+    READWRITE(VARINT(nStakeModifierHeight));
+    READWRITE(nStakeModifierTime);
+    READWRITE(VARINT(nHeightLast));
+    READWRITE(hashLast);
+  }
+};
+
+/**
+ * GetKernelStakeModifier() results by hashBlockFrom.
+ *
+ * The walk only reads chainActive up to nHeightLast, so an entry holds until a
+ * block at or below that height is disconnected. Entries are written to the
+ * block tree database along with the block index, and read back only if
+ * chainActive still has hashLast at nHeightLast.
+ */
+class CStakeModifierCache {
+ public:
+  //! Finds the entry, dropping it instead if chainActive no longer has hashLast at nHeightLast
+  bool Get(const uint256& hashBlockFrom, CStakeModifierEntry& entry);
+  void Put(const uint256& hashBlockFrom, const CStakeModifierEntry& entry);
+
+  //! Drop everything that depends on the block at nHeight, which is leaving chainActive
+  void DisconnectBlock(int nHeight);
+
+  //! Write the entries added or dropped since the last flush
+  bool Flush(CBlockTreeDB& db);
+  //! Read the persisted entries that still match chainActive, once its tip is loaded
+  bool Load(CBlockTreeDB& db);
+  void Clear();
+
+ private:
+  mutable CCriticalSection cs;
+  std::unordered_map<uint256, CStakeModifierEntry, BlockHasher> mapEntries;
+  //! hashBlockFrom of each entry by its nHeightLast
+  std::multimap<int, uint256> mapByHeight;
+  std::set<uint256> setDirty;
+};
+
+extern CStakeModifierCache stakeModifierCache;
+
 bool CheckStake(const CDataStream& ssUniqueID, CAmount nValueIn, const uint64_t nStakeModifier,
                 const arith_uint256& bnTarget, unsigned int nTimeBlockFrom, unsigned int& nTimeTx,
                 uint256& hashProofOfStake);
 
-bool Stake(CStakeInput* stakeInput, unsigned int nBits, unsigned int nTimeBlockFrom, unsigned int& nTimeTx,
-           uint256& hashProofOfStake);
+/**
+ * The kernel hash of one stake input, nStakeModifier || nTimeBlockFrom || ssUniqueID || nTimeTx.
+ * Everything but nTimeTx is fixed for the input, so it is hashed once and each
+ * timestamp tried only adds its own four bytes to a copy of that SHA256 state.
+ */
+class CStakeKernel {
+ public:
+  CStakeKernel(const CDataStream& ssUniqueID, CAmount nValueInIn, uint64_t nStakeModifier,
+               unsigned int nTimeBlockFromIn);
+
+  uint256 GetHash(unsigned int nTimeTx) const;
+  //! Most a kernel hash may be at difficulty bnTargetPerCoinDay, which scales with the input's value
+  arith_uint256 GetTarget(const arith_uint256& bnTargetPerCoinDay) const;
+
+  /**
+   * Try the timestamps a staker may use for a block at nTimeTx, latest first.
+   * Sets nTimeHit and hashProofOfStake on the first one that meets the target.
+   */
+  bool Search(const arith_uint256& bnTargetPerCoinDay, unsigned int nTimeTx, unsigned int& nTimeHit,
+              uint256& hashProofOfStake) const;
+
+ private:
+  CHashWriter ssPrefix;
+  CAmount nValueIn;
+  unsigned int nTimeBlockFrom;
+};
+
+/**
+ * Search the kernels of vKernels[nStart..] for a block at nTimeTx, spread over the
+ * proof worker threads. Inputs above a hit are skipped, inputs below it are always
+ * searched, and everything stops as soon as a new block comes in. Returns the lowest
+ * index that hit, with nTimeTx and hashProofOfStake set to its kernel, so searching
+ * again from that index + 1 goes on where this left off.
+ * Returns -1 if nothing hit or the tip moved.
+ */
+int FindStakeKernel(const std::vector<CStakeKernel>& vKernels, size_t nStart, unsigned int nBits,
+                    unsigned int& nTimeTx, uint256& hashProofOfStake);
 
 // Check kernel hash target and coinstake signature
 // Sets hashProofOfStake on success return
@@ -10,7 +10,9 @@
 #include <rocksdb/cache.h>
 #include <rocksdb/env.h>
 #include <rocksdb/filter_policy.h>
-#include <rocksdb/utilities/leveldb_options.h>
+#include <rocksdb/table.h>
+
+#include <boost/thread/mutex.hpp>
 
 void HandleError(const rocksdb::Status& status) {
   if (status.ok()) return;
@@ -21,24 +23,129 @@ void HandleError(const rocksdb::Status& status) {
   throw leveldb_error("Unknown database error");
 }
 
-static rocksdb::Options GetOptions(size_t nCacheSize) {
-  rocksdb::LevelDBOptions opt;
-  // opt.block_cache = rocksdb::NewLRUCache(nCacheSize / 2);
-  opt.write_buffer_size = nCacheSize / 4;  // up to two write buffers may be held in memory simultaneously
-  opt.filter_policy = rocksdb::NewBloomFilterPolicy(10);
-  opt.compression = rocksdb::kNoCompression;
-  opt.max_open_files = 64;
-  rocksdb::Options rocksdb_options = ConvertOptions(opt);
-  return rocksdb_options;
+//! Guards the capacity of the shared block cache while databases open and close
+static boost::mutex csBlockCache;
+
+/**
+ * Block cache shared by every database in the process. Each database adds half of its
+ * -dbcache share to the capacity, so a small database can use room a busy one leaves free.
+ * Index and filter blocks go to the high priority pool so data blocks can't push them out.
+ */
+static std::shared_ptr<rocksdb::Cache> GetBlockCache() {
+  static std::shared_ptr<rocksdb::Cache> cache = rocksdb::NewLRUCache(0, -1, false, 0.1);
+  return cache;
+}
+
+static rocksdb::Options GetOptions(size_t nCacheSize, bool fCompress) {
+  rocksdb::Options options;
+  options.write_buffer_size = nCacheSize / 4;  // up to two write buffers may be held in memory simultaneously
+  options.max_open_files = 64;
+
+  rocksdb::BlockBasedTableOptions table;
+  table.block_cache = GetBlockCache();
+  table.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+  table.cache_index_and_filter_blocks = true;
+  table.cache_index_and_filter_blocks_with_high_priority = true;
+  table.pin_l0_filter_and_index_blocks_in_cache = true;
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table));
+
+  if (fCompress) {
+    // The two freshest levels are rewritten most often and stay uncompressed, LZ4 below them and
+    // ZSTD for the bottom level that holds most of the data
+    options.compression_per_level.assign(options.num_levels, rocksdb::kLZ4Compression);
+    options.compression_per_level[0] = rocksdb::kNoCompression;
+    options.compression_per_level[1] = rocksdb::kNoCompression;
+    options.bottommost_compression = rocksdb::kZSTD;
+  } else {
+    options.compression = rocksdb::kNoCompression;
+    options.bottommost_compression = rocksdb::kDisableCompressionOption;
+  }
+  return options;
+}
+
+//! The open failed only because RocksDB was built without LZ4 or ZSTD, not for any other bad option or file
+static bool IsCompressionUnsupported(const rocksdb::Status& status) {
+  return status.IsInvalidArgument() && status.ToString().find("is not linked with the binary") != std::string::npos;
+}
+
+void CLevelDBBatch::Put(const rocksdb::Slice& slKey, const rocksdb::Slice& slValue) {
+  if (parent)
+    batch.Put(parent->GetFamily(slKey), slKey, slValue);
+  else
+    batch.Put(slKey, slValue);
+}
+
+void CLevelDBBatch::Delete(const rocksdb::Slice& slKey) {
+  if (parent)
+    batch.Delete(parent->GetFamily(slKey), slKey);
+  else
+    batch.Delete(slKey);
+}
+
+/**
+ * Move the records with this key prefix out of the default family, for databases written before it existed.
+ * Each batch moves its records atomically, so a sweep cut short by a crash leaves the rest where they were
+ * and the next open picks them up.
+ */
+static void MoveToFamily(rocksdb::DB* pdb, rocksdb::ColumnFamilyHandle* pfamily, char chPrefix) {
+  static const int nBatchSize = 10000;
+  rocksdb::ReadOptions readoptions;
+  readoptions.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> pcursor(pdb->NewIterator(readoptions));
+  rocksdb::WriteBatch batch;
+  size_t nMoved = 0;
+  for (pcursor->Seek(rocksdb::Slice(&chPrefix, 1)); pcursor->Valid(); pcursor->Next()) {
+    rocksdb::Slice slKey = pcursor->key();
+    if (slKey.size() == 0 || slKey.data()[0] != chPrefix) break;
+    batch.Put(pfamily, slKey, pcursor->value());
+    batch.Delete(slKey);
+    if (++nMoved % nBatchSize == 0) {
+      HandleError(pdb->Write(rocksdb::WriteOptions(), &batch));
+      batch.Clear();
+      LogPrintf("Moving '%c' records to column family %s... (%u)\n", chPrefix, pfamily->GetName(), nMoved);
+    }
+  }
+  HandleError(pcursor->status());
+  if (!nMoved) return;
+  // Synced so the moved records are durable before anything new is written to the family
+  rocksdb::WriteOptions syncoptions;
+  syncoptions.sync = true;
+  HandleError(pdb->Write(syncoptions, &batch));
+  LogPrintf("Moved %u '%c' records to column family %s\n", nMoved, chPrefix, pfamily->GetName());
 }
 
-CLevelDBWrapper::CLevelDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe) {
+rocksdb::Status CLevelDBWrapper::Open(const fs::path& path, const std::vector<CLevelDBFamily>& vFamilies) {
+  std::vector<rocksdb::ColumnFamilyDescriptor> vDescriptors;
+  vDescriptors.push_back(rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, options));
+  for (const CLevelDBFamily& family : vFamilies)
+    vDescriptors.push_back(rocksdb::ColumnFamilyDescriptor(family.strName, options));
+  options.create_missing_column_families = true;
+
+  std::vector<rocksdb::ColumnFamilyHandle*> vHandles;
+  rocksdb::Status status = rocksdb::DB::Open(options, path.string(), vDescriptors, &vHandles, &pdb);
+  if (!status.ok()) return status;
+
+  // Prefixes without a family of their own stay in the default one, vHandles[0]
+  vFamilyHandles = vHandles;
+  for (unsigned int i = 0; i < 256; i++) vFamilyByPrefix[i] = vHandles[0];
+  for (unsigned int i = 0; i < vFamilies.size(); i++)
+    vFamilyByPrefix[(unsigned char)vFamilies[i].chPrefix] = vHandles[i + 1];
+
+  // The family may already exist from an interrupted migration, so the default family is swept on
+  // every open. Once it holds no routed records this is a single seek per family.
+  for (unsigned int i = 0; i < vFamilies.size(); i++) MoveToFamily(pdb, vHandles[i + 1], vFamilies[i].chPrefix);
+  return status;
+}
+
+CLevelDBWrapper::CLevelDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe,
+                                 const std::vector<CLevelDBFamily>& vFamilies) {
   penv = nullptr;
+  pdb = nullptr;
   readoptions.verify_checksums = true;
   iteroptions.verify_checksums = true;
   iteroptions.fill_cache = false;
   syncoptions.sync = true;
-  options = GetOptions(nCacheSize);
+  options = GetOptions(nCacheSize, true);
   options.create_if_missing = true;
   if (fMemory) {
     penv = rocksdb::NewMemEnv(rocksdb::Env::Default());
@@ -51,12 +158,30 @@ CLevelDBWrapper::CLevelDBWrapper(const fs::path& path, size_t nCacheSize, bool f
     TryCreateDirectory(path);
     LogPrintf("Opening Rocksdb in %s\n", path.string());
   }
-  rocksdb::Status status = rocksdb::DB::Open(options, path.string(), &pdb);
+
+  {
+    boost::mutex::scoped_lock lock(csBlockCache);
+    nBlockCacheShare = nCacheSize / 2;
+    GetBlockCache()->SetCapacity(GetBlockCache()->GetCapacity() + nBlockCacheShare);
+  }
+
+  rocksdb::Status status = Open(path, vFamilies);
+  if (IsCompressionUnsupported(status)) {
+    // RocksDB built without LZ4/ZSTD refuses the options, keep the data uncompressed instead
+    LogPrintf("Rocksdb lacks LZ4/ZSTD (%s), opening %s without compression\n", status.ToString(), path.string());
+    rocksdb::Env* penvKeep = options.env;
+    options = GetOptions(nCacheSize, false);
+    options.create_if_missing = true;
+    options.env = penvKeep;
+    status = Open(path, vFamilies);
+  }
   HandleError(status);
   LogPrintf("Opened Rocksdb successfully\n");
 }
 
 CLevelDBWrapper::~CLevelDBWrapper() {
+  for (rocksdb::ColumnFamilyHandle* phandle : vFamilyHandles) pdb->DestroyColumnFamilyHandle(phandle);
+  vFamilyHandles.clear();
   delete pdb;
   pdb = nullptr;
   // delete options.filter_policy;
@@ -65,9 +190,14 @@ CLevelDBWrapper::~CLevelDBWrapper() {
   //  options.block_cache = nullptr;
   delete penv;
   options.env = nullptr;
+
+  boost::mutex::scoped_lock lock(csBlockCache);
+  GetBlockCache()->SetCapacity(GetBlockCache()->GetCapacity() - nBlockCacheShare);
 }
 
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch& batch, bool fSync) {
+  // A batch built without this database would put every record in the default family
+  assert(batch.parent == this || vFamilyHandles.size() <= 1);
   rocksdb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
   HandleError(status);
   return true;
@@ -14,6 +14,8 @@
 #include <rocksdb/db.h>
 #include <rocksdb/write_batch.h>
 
+#include <vector>
+
 class leveldb_error : public std::runtime_error {
  public:
   leveldb_error(const std::string& msg) : std::runtime_error(msg) {}
@@ -21,14 +23,30 @@ class leveldb_error : public std::runtime_error {
 
 void HandleError(const rocksdb::Status& status);
 
+class CLevelDBWrapper;
+
+/** Column family holding every record whose serialized key starts with chPrefix */
+struct CLevelDBFamily {
+  char chPrefix;
+  std::string strName;
+};
+
 /** Batch of changes queued to be written to a CLevelDBWrapper */
 class CLevelDBBatch {
   friend class CLevelDBWrapper;
 
  private:
   rocksdb::WriteBatch batch;
+  //! database whose column families the records are routed to, nullptr for the default family only
+  const CLevelDBWrapper* parent;
+
+  void Put(const rocksdb::Slice& slKey, const rocksdb::Slice& slValue);
+  void Delete(const rocksdb::Slice& slKey);
 
  public:
+  CLevelDBBatch() : parent(nullptr) {}
+  explicit CLevelDBBatch(const CLevelDBWrapper& parentIn) : parent(&parentIn) {}
+
   template <typename K, typename V> void Write(const K& key, const V& value) {
     CDataStream ssKey(SER_DISK, CLIENT_VERSION);
     ssKey.reserve(ssKey.GetSerializeSize(key));
@@ -40,7 +58,7 @@ class CLevelDBBatch {
     ssValue << value;
     rocksdb::Slice slValue(&ssValue[0], ssValue.size());
 
-    batch.Put(slKey, slValue);
+    Put(slKey, slValue);
   }
 
   template <typename K> void Erase(const K& key) {
@@ -49,8 +67,10 @@ class CLevelDBBatch {
     ssKey << key;
     rocksdb::Slice slKey(&ssKey[0], ssKey.size());
 
-    batch.Delete(slKey);
+    Delete(slKey);
   }
+
+  void Clear() { batch.Clear(); }
 };
 
 class CLevelDBWrapper {
@@ -76,10 +96,26 @@ class CLevelDBWrapper {
   //! the database itself
   rocksdb::DB* pdb;
 
+  //! handles of the open column families, the default one first
+  std::vector<rocksdb::ColumnFamilyHandle*> vFamilyHandles;
+
+  //! column family for each possible first key byte
+  rocksdb::ColumnFamilyHandle* vFamilyByPrefix[256];
+
+  //! capacity this database added to the shared block cache
+  size_t nBlockCacheShare;
+
+  rocksdb::Status Open(const fs::path& path, const std::vector<CLevelDBFamily>& vFamilies);
+
  public:
-  CLevelDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+  CLevelDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false,
+                  const std::vector<CLevelDBFamily>& vFamilies = std::vector<CLevelDBFamily>());
   ~CLevelDBWrapper();
 
+  rocksdb::ColumnFamilyHandle* GetFamily(const rocksdb::Slice& slKey) const {
+    return vFamilyByPrefix[slKey.size() ? (unsigned char)slKey.data()[0] : 0];
+  }
+
   template <typename K, typename V> bool Read(const K& key, V& value) const {
     CDataStream ssKey(SER_DISK, CLIENT_VERSION);
     ssKey.reserve(ssKey.GetSerializeSize(key));
@@ -87,7 +123,7 @@ class CLevelDBWrapper {
     rocksdb::Slice slKey(&ssKey[0], ssKey.size());
 
     std::string strValue;
-    rocksdb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    rocksdb::Status status = pdb->Get(readoptions, GetFamily(slKey), slKey, &strValue);
     if (!status.ok()) {
       if (status.IsNotFound()) return false;
       LogPrintf("Rocksdb read failure: %s\n", status.ToString());
@@ -100,8 +136,49 @@ class CLevelDBWrapper {
     return true;
   }
 
+  //! Look up several keys in one MultiGet; vFound[i] tells whether vValues[i] was read
+  template <typename K, typename V>
+  void ReadMany(const std::vector<K>& vKeys, std::vector<V>& vValues, std::vector<bool>& vFound) const {
+    vValues.assign(vKeys.size(), V());
+    vFound.assign(vKeys.size(), false);
+    if (vKeys.empty()) return;
+
+    std::vector<CDataStream> vssKey;
+    std::vector<rocksdb::Slice> vslKey;
+    std::vector<rocksdb::ColumnFamilyHandle*> vFamilies;
+    vssKey.reserve(vKeys.size());
+    vslKey.reserve(vKeys.size());
+    vFamilies.reserve(vKeys.size());
+    for (const K& key : vKeys) {
+      vssKey.emplace_back(SER_DISK, CLIENT_VERSION);
+      CDataStream& ssKey = vssKey.back();
+      ssKey.reserve(ssKey.GetSerializeSize(key));
+      ssKey << key;
+    }
+    for (const CDataStream& ssKey : vssKey) {
+      vslKey.emplace_back(&ssKey[0], ssKey.size());
+      vFamilies.push_back(GetFamily(vslKey.back()));
+    }
+
+    std::vector<std::string> vstrValue;
+    std::vector<rocksdb::Status> vStatus = pdb->MultiGet(readoptions, vFamilies, vslKey, &vstrValue);
+    for (size_t i = 0; i < vKeys.size(); i++) {
+      if (!vStatus[i].ok()) {
+        if (vStatus[i].IsNotFound()) continue;
+        LogPrintf("Rocksdb read failure: %s\n", vStatus[i].ToString());
+        HandleError(vStatus[i]);
+      }
+      try {
+        CDataStream ssValue(vstrValue[i].data(), vstrValue[i].data() + vstrValue[i].size(), SER_DISK,
+                            CLIENT_VERSION);
+        ssValue >> vValues[i];
+        vFound[i] = true;
+      } catch (const std::exception&) {}
+    }
+  }
+
   template <typename K, typename V> bool Write(const K& key, const V& value, bool fSync = false) {
-    CLevelDBBatch batch;
+    CLevelDBBatch batch(*this);
     batch.Write(key, value);
     return WriteBatch(batch, fSync);
   }
@@ -113,7 +190,7 @@ class CLevelDBWrapper {
     rocksdb::Slice slKey(&ssKey[0], ssKey.size());
 
     std::string strValue;
-    rocksdb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    rocksdb::Status status = pdb->Get(readoptions, GetFamily(slKey), slKey, &strValue);
     if (!status.ok()) {
       if (status.IsNotFound()) return false;
       LogPrintf("Rocksdb read failure: %s\n", status.ToString());
@@ -123,7 +200,7 @@ class CLevelDBWrapper {
   }
 
   template <typename K> bool Erase(const K& key, bool fSync = false) {
-    CLevelDBBatch batch;
+    CLevelDBBatch batch(*this);
     batch.Erase(key);
     return WriteBatch(batch, fSync);
   }
@@ -134,10 +211,15 @@ class CLevelDBWrapper {
   bool Flush() { return true; }
 
   bool Sync() {
-    CLevelDBBatch batch;
+    CLevelDBBatch batch(*this);
     return WriteBatch(batch, true);
   }
 
   // not exactly clean encapsulation, but it's easiest for now
   rocksdb::Iterator* NewIterator() { return pdb->NewIterator(iteroptions); }
+
+  //! Iterator over the column family holding the records with this key prefix
+  rocksdb::Iterator* NewIterator(char chPrefix) {
+    return pdb->NewIterator(iteroptions, vFamilyByPrefix[(unsigned char)chPrefix]);
+  }
 };
@@ -13,11 +13,28 @@
 // Copyright (c) 2018 The Tessacoin developers
 
 #include "Accumulator.h"
+#include "ParallelFor.h"
 #include "ZerocoinDefines.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 
 namespace libzerocoin {
+
+namespace {
+
+// Product of vValues[nBegin, nEnd), split in halves so that operands stay of similar size
+CBigNum ProductTree(const std::vector<CBigNum>& vValues, size_t nBegin, size_t nEnd) {
+  if (nEnd - nBegin == 1) return vValues[nBegin];
+  const size_t nMid = nBegin + (nEnd - nBegin) / 2;
+  CBigNum product;
+  mpz_mul(product.bn, ProductTree(vValues, nBegin, nMid).bn, ProductTree(vValues, nMid, nEnd).bn);
+  return product;
+}
+
+}  // namespace
+
 // Accumulator class
 Accumulator::Accumulator(const AccumulatorAndProofParams* p, const CoinDenomination d, int iterations) : params(p) {
   assert(p);
@@ -48,6 +65,13 @@ void Accumulator::increment(const CBigNum& bnValue) {
   this->value = this->value.pow_mod(bnValue, this->params->accumulatorModulus);
 }
 
+void Accumulator::increment(const std::vector<CBigNum>& vValues) {
+  for (size_t i = 0; i < vValues.size(); i += ACCUMULATOR_BATCH_MAX) {
+    const size_t nEnd = std::min(vValues.size(), i + ACCUMULATOR_BATCH_MAX);
+    increment(ProductTree(vValues, i, nEnd));
+  }
+}
+
 void Accumulator::accumulate(const PublicCoin& coin) {
   if (this->denomination != coin.getDenomination()) {
     std::cout << "Wrong denomination for coin. Expected coins of denomination: ";
@@ -66,6 +90,33 @@ void Accumulator::accumulate(const PublicCoin& coin) {
   }
 }
 
+void Accumulator::accumulate(const std::vector<PublicCoin>& vCoins) {
+  for (const PublicCoin& coin : vCoins) {
+    if (this->denomination != coin.getDenomination()) {
+      std::cout << "Wrong denomination for coin. Expected coins of denomination: ";
+      std::cout << this->denomination;
+      std::cout << ". Instead, got a coin of denomination: ";
+      std::cout << coin.getDenomination();
+      std::cout << "\n";
+      throw std::runtime_error("Wrong denomination for coin");
+    }
+  }
+
+  std::atomic<bool> fValid(true);
+  ParallelFor(vCoins.size(), [&](size_t i) {
+    if (fValid && !vCoins[i].validate(params, zkp_iterations)) fValid = false;
+  });
+  if (!fValid) {
+    std::cout << "Coin not valid\n";
+    throw std::runtime_error("Coin is not valid");
+  }
+
+  std::vector<CBigNum> vValues;
+  vValues.reserve(vCoins.size());
+  for (const PublicCoin& coin : vCoins) vValues.push_back(coin.getValue());
+  increment(vValues);
+}
+
 Accumulator& Accumulator::operator+=(const PublicCoin& c) {
   this->accumulate(c);
   return *this;
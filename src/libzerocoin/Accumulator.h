@@ -16,6 +16,8 @@
 #include "PublicCoin.h"
 #include "ZerocoinDefines.h"
 
+#include <vector>
+
 namespace libzerocoin {
 /**
  * \brief Implementation of the RSA-based accumulator.
@@ -63,6 +65,26 @@ class Accumulator {
   void accumulate(const PublicCoin& coin);
   void increment(const CBigNum& bnValue);
 
+  /**
+   * Accumulate several coins at once, with the same result as adding
+   * them one by one. The coins are validated in parallel.
+   *
+   * @param vCoins	PublicCoins of this accumulator's denomination.
+   *
+   * @throw		Zerocoin exception if any coin is not valid.
+   *
+   **/
+  void accumulate(const std::vector<PublicCoin>& vCoins);
+
+  /**
+   * Raise the accumulator to the product of vValues. Values are
+   * multiplied together in chunks of ACCUMULATOR_BATCH_MAX, so each chunk
+   * costs one exponentiation instead of one per value.
+   *
+   * @param vValues	the values to add, in any order
+   **/
+  void increment(const std::vector<CBigNum>& vValues);
+
   CoinDenomination getDenomination() const { return this->denomination; }
   /** Get the accumulator result
    *
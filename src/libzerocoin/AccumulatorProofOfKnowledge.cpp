@@ -28,8 +28,10 @@ AccumulatorProofOfKnowledge::AccumulatorProofOfKnowledge(const AccumulatorAndPro
    **/
   const CBigNum& PoKmod = IntegerModModulus<ACCUMULATOR_POK_COMMITMENT_MODULUS>::getModulus();
 
-  const IntegerMod<ACCUMULATOR_MODULUS> g_n(params->accumulatorQRNCommitmentGroup.g);
-  const IntegerMod<ACCUMULATOR_MODULUS> h_n(params->accumulatorQRNCommitmentGroup.h);
+  const IntegerGroupParams& qrn = params->accumulatorQRNCommitmentGroup;
+  const IntegerGroupParams& pok = params->accumulatorPoKCommitmentGroup;
+  const IntegerMod<ACCUMULATOR_MODULUS> g_n(qrn.g);
+  const IntegerMod<ACCUMULATOR_MODULUS> h_n(qrn.h);
 
   const CBigNum& e = commitmentToCoin.getSerial();
   const CBigNum& r = commitmentToCoin.getRandomness();
@@ -43,11 +45,11 @@ AccumulatorProofOfKnowledge::AccumulatorProofOfKnowledge(const AccumulatorAndPro
   /// Auxiliary commitments
   ///
   /// \f$ C_e = h^{r_1} g^e \f$
-  C_e = (g_n ^ e) * (h_n ^ r_1);
+  C_e = qrn.mulPowGH<ACCUMULATOR_MODULUS>({}, {}, e, r_1.getValue());
   /// \f$ C_u = witness * h^{r_2} \f$
-  C_u = witness.getValue() * (h_n ^ r_2);
+  C_u = witness.getValue() * qrn.mulPowGH<ACCUMULATOR_MODULUS>({}, {}, 0, r_2.getValue());
   /// \f$ C_r = h^{r_3} g^{r_2} \f$
-  C_r = (g_n ^ r_2) * (h_n ^ r_3);
+  C_r = qrn.mulPowGH<ACCUMULATOR_MODULUS>({}, {}, r_2.getValue(), r_3.getValue());
 
   const CBigNum power_value = CBigNum(2).pow(params->k_prime + params->k_dprime);
 
@@ -78,27 +80,27 @@ AccumulatorProofOfKnowledge::AccumulatorProofOfKnowledge(const AccumulatorAndPro
   const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> sh(params->accumulatorPoKCommitmentGroup.h);
 
   /// \f$ st_1 = g^{r_&alpha;} * h^{r_&phi;} \f$
-  this->st_1 = (sg ^ r_alpha) * (sh ^ r_phi);
+  this->st_1 = pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({}, {}, r_alpha, r_phi);
 
   const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> gmp5 = commitmentToCoin.getCommitmentValue() * sg.inverse();
   const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> gmp6 = commitmentToCoin.getCommitmentValue() * sg;
 
   /// \f$ st_2 = (C/g)^{r_&alpha;} * h^{r_&psi;} \f$
-  this->st_2 = (gmp5 ^ r_gamma) * (sh ^ r_psi);
+  this->st_2 = pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({gmp5}, {r_gamma}, 0, r_psi);
 
   /// \f$ st_2 = (g*C)^{r_&sigma;} * h^{r_&xi;} \f$
-  this->st_3 = (gmp6 ^ r_sigma) * (sh ^ r_xi);
+  this->st_3 = pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({gmp6}, {r_sigma}, 0, r_xi);
 
   /// The prover computes...
   ///
   /// \f$ t_1 = h^{r_&zeta;} * g^{r_&epsilon;} \f$
-  this->t_1 = ((h_n ^ r_zeta) * (g_n ^ r_epsilon));
+  this->t_1 = qrn.mulPowGH<ACCUMULATOR_MODULUS>({}, {}, r_epsilon, r_zeta);
   /// \f$ t_2 = h^{r_&eta;} * g^{r_&alpha;} \f$
-  this->t_2 = ((h_n ^ r_eta) * (g_n ^ r_alpha));
+  this->t_2 = qrn.mulPowGH<ACCUMULATOR_MODULUS>({}, {}, r_alpha, r_eta);
   /// \f$ t_3 = C_u^{r_&alpha;} * (1/h)^{r_&beta;} \f$
-  this->t_3 = ((C_u ^ r_alpha) * (h_n.inverse() ^ r_beta));
+  this->t_3 = qrn.mulPowGH<ACCUMULATOR_MODULUS>({C_u}, {r_alpha}, 0, 0 - r_beta);
   /// \f$ t_4 = C_r^{r_&alpha;} * (1/h)^{r_&delta;} * (1/g)^{r_&beta;} \f$
-  this->t_4 = ((C_r ^ r_alpha) * (h_n.inverse() ^ r_delta) * (g_n.inverse() ^ r_beta));
+  this->t_4 = qrn.mulPowGH<ACCUMULATOR_MODULUS>({C_r}, {r_alpha}, 0 - r_beta, 0 - r_delta);
 
   CHashWriter hasher;
   hasher << *params << sg.getValue() << sh.getValue() << g_n.getValue() << h_n.getValue()
@@ -147,11 +149,13 @@ AccumulatorProofOfKnowledge::AccumulatorProofOfKnowledge(const AccumulatorAndPro
 
 /** Verifies that a commitment c is accumulated in accumulator a */
 bool AccumulatorProofOfKnowledge::Verify(const Accumulator& a, const CBigNum& valueOfCommitmentToCoin) const {
-  const IntegerMod<ACCUMULATOR_MODULUS> g_n(params->accumulatorQRNCommitmentGroup.g);
-  const IntegerMod<ACCUMULATOR_MODULUS> h_n(params->accumulatorQRNCommitmentGroup.h);
+  const IntegerGroupParams& qrn = params->accumulatorQRNCommitmentGroup;
+  const IntegerGroupParams& pok = params->accumulatorPoKCommitmentGroup;
+  const IntegerMod<ACCUMULATOR_MODULUS> g_n(qrn.g);
+  const IntegerMod<ACCUMULATOR_MODULUS> h_n(qrn.h);
 
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> sg(params->accumulatorPoKCommitmentGroup.g);
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> sh(params->accumulatorPoKCommitmentGroup.h);
+  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> sg(pok.g);
+  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> sh(pok.h);
   const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> commitment(valueOfCommitmentToCoin);
 
   CHashWriter hasher;
@@ -161,23 +165,27 @@ bool AccumulatorProofOfKnowledge::Verify(const Accumulator& a, const CBigNum& va
   const CBigNum c = CBigNum(hasher.GetHash());  // this hash should be of length k_prime bits
 
   /// \f$ S_1 \f$ = \f$ commitment^c * g^{s_&alpha;} * h^{s_&phi;} \f$
-  const CBigNum st_1_prime = ((commitment ^ c) * (sg ^ s_alpha) * (sh ^ s_phi)).getValue();
+  const CBigNum st_1_prime =
+      pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({commitment}, {c}, s_alpha, s_phi).getValue();
   /// \f$ S_2 \f$ = \f$ g^c * (commitment/g)^{s_&gamma;} * h^{s_&phi;} \f$
-  const CBigNum st_2_prime = ((sg ^ c) * ((commitment / sg) ^ s_gamma) * (sh ^ s_psi)).getValue();
+  const CBigNum st_2_prime =
+      pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({commitment / sg}, {s_gamma}, c, s_psi).getValue();
   /// \f$ S_2 \f$ = \f$ g^c * (commitment*g)^{s_&sigma;} * h^{s_&xi;} \f$
-  const CBigNum st_3_prime = ((sg ^ c) * ((sg * commitment) ^ s_sigma) * (sh ^ s_xi)).getValue();
+  const CBigNum st_3_prime =
+      pok.mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({sg * commitment}, {s_sigma}, c, s_xi).getValue();
 
   // Note change of Modulus
   const IntegerMod<ACCUMULATOR_MODULUS> A(a.getValue());
 
   /// \f$ T_1 \f$ = \f$ C_r^c * h^{s_&zeta;} * g^{s_&epsilon;} \f$
-  const CBigNum t_1_prime = ((C_r ^ c) * (h_n ^ s_zeta) * (g_n ^ s_epsilon)).getValue();
+  const CBigNum t_1_prime = qrn.mulPowGH<ACCUMULATOR_MODULUS>({C_r}, {c}, s_epsilon, s_zeta).getValue();
   /// \f$ T_2 \f$ = \f$ C_e^c * h^{s_&eta;} * g^{s_&alpha;} \f$
-  const CBigNum t_2_prime = ((C_e ^ c) * (h_n ^ s_eta) * (g_n ^ s_alpha)).getValue();
+  const CBigNum t_2_prime = qrn.mulPowGH<ACCUMULATOR_MODULUS>({C_e}, {c}, s_alpha, s_eta).getValue();
   /// \f$ T_3 \f$ = \f$ A^c * C_u^{s_&alpha;} * (1/h)^{s_&beta;} \f$
-  const CBigNum t_3_prime = ((A ^ c) * (C_u ^ s_alpha) * (h_n.inverse() ^ s_beta)).getValue();
+  const CBigNum t_3_prime = qrn.mulPowGH<ACCUMULATOR_MODULUS>({A, C_u}, {c, s_alpha}, 0, 0 - s_beta).getValue();
   /// \f$ T_4 \f$ = \f$ C_r^{s_&alpha;} * (1/h)^{s_&delta;} * (1/g)^{s_&beta;} \f$
-  const CBigNum t_4_prime = ((C_r ^ s_alpha) * (h_n.inverse() ^ s_delta) * (g_n.inverse() ^ s_beta)).getValue();
+  const CBigNum t_4_prime =
+      qrn.mulPowGH<ACCUMULATOR_MODULUS>({C_r}, {s_alpha}, 0 - s_beta, 0 - s_delta).getValue();
 
   bool result = false;
 
@@ -0,0 +1,25 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BatchVerifier.h"
+#include "ParallelFor.h"
+
+namespace libzerocoin {
+
+bool BatchVerifier::Verify(std::vector<size_t>* pvInvalid) const {
+  if (pvInvalid) pvInvalid->clear();
+
+  std::vector<char> vPassed(vSpends.size());
+  ParallelFor(vSpends.size(), [&](size_t i) { vPassed[i] = vSpends[i].first->Verify(*vSpends[i].second); });
+
+  bool fAllPassed = true;
+  for (size_t i = 0; i < vSpends.size(); i++) {
+    if (vPassed[i]) continue;
+    fAllPassed = false;
+    if (pvInvalid) pvInvalid->push_back(i);
+  }
+  return fAllPassed;
+}
+
+} /* namespace libzerocoin */
@@ -0,0 +1,45 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include "Accumulator.h"
+#include "CoinSpend.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace libzerocoin {
+
+/**
+ * Verifies many CoinSpend proofs together, spread over the proof threads.
+ *
+ * Verify() gives exactly the answer of CoinSpend::Verify() for every queued
+ * spend. Nothing is folded across proofs: the commitment equality proof and
+ * the serial number signature of knowledge do not send their commitments,
+ * and a random linear combination of the accumulator proof equations cannot
+ * see the sign of a t_i, so it could only reject and never spare the full
+ * check of a valid spend.
+ */
+class BatchVerifier {
+ public:
+  explicit BatchVerifier(const ZerocoinParams* p) : params(p) {}
+
+  //! Queue spend for verification against a. Both must stay alive until Verify() returns.
+  void Add(const CoinSpend& spend, const Accumulator& a) { vSpends.emplace_back(&spend, &a); }
+  size_t size() const { return vSpends.size(); }
+  void clear() { vSpends.clear(); }
+
+  /**
+   * True when every queued spend verifies. Otherwise the positions of the bad
+   * ones, in the order they were added, go to pvInvalid when given.
+   */
+  bool Verify(std::vector<size_t>* pvInvalid = nullptr) const;
+
+ private:
+  const ZerocoinParams* params;
+  std::vector<std::pair<const CoinSpend*, const Accumulator*>> vSpends;
+};
+
+} /* namespace libzerocoin */
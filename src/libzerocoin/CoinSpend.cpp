@@ -59,15 +59,13 @@ CoinSpend::CoinSpend(const ZerocoinParams* p, const PrivateCoin& coin, Accumulat
   // to be the same as the modulus of the upper group. The Accumulator proof requires a
   // group with a significantly larger order.
   Commitment fullCommitmentToCoinUnderSerialParams =
-      commit<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS, SERIAL_NUMBER_SOK_COMMITMENT_GROUP>(
-          p->serialNumberSoKCommitmentGroup.g, p->serialNumberSoKCommitmentGroup.h, coin.getPublicCoin().getValue());
+      commit<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>(p->serialNumberSoKCommitmentGroup, coin.getPublicCoin().getValue());
 
   this->serialCommitmentToCoinValue = fullCommitmentToCoinUnderSerialParams.getCommitmentValue();
 
   Commitment fullCommitmentToCoinUnderAccParams =
-      commit<ACCUMULATOR_POK_COMMITMENT_MODULUS, ACCUMULATOR_POK_COMMITMENT_GROUP>(
-          p->accumulatorParams.accumulatorPoKCommitmentGroup.g, p->accumulatorParams.accumulatorPoKCommitmentGroup.h,
-          coin.getPublicCoin().getValue());
+      commit<ACCUMULATOR_POK_COMMITMENT_MODULUS>(p->accumulatorParams.accumulatorPoKCommitmentGroup,
+                                                 coin.getPublicCoin().getValue());
 
   this->accCommitmentToCoinValue = fullCommitmentToCoinUnderAccParams.getCommitmentValue();
 
@@ -39,5 +39,13 @@ template <ModulusType T, ModulusType G> Commitment commit(const CBigNum& g1, con
   Commitment commit(r, value, commitmentValue);
   return commit;
 }
+// Same as above, using the group's precomputed generator tables
+template <ModulusType T, typename GroupParams> Commitment commit(const GroupParams& group, const CBigNum& value) {
+  CBigNum r = randBignum(IntegerModModulus<T>::getModulus());
+  /// \f$ commitment = g^{value} * h^{randomness} \f$
+  CBigNum commitmentValue = group.template mulPowGH<T>({}, {}, value, r).getValue();
+  Commitment commit(r, value, commitmentValue);
+  return commit;
+}
 
 } /* namespace libzerocoin */
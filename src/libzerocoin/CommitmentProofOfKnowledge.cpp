@@ -51,18 +51,15 @@ CommitmentProofOfKnowledge::CommitmentProofOfKnowledge(const SerialNumberGroupPa
   const CBigNum r2 = randBignum(maxRange);
   const CBigNum r3 = randBignum(maxRange);
 
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> g1(ap->g);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> h1(ap->h);
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> g2(bp->g);
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> h2(bp->h);
-
   // Generate two random, ephemeral commitments "T1, T2"
   // of the form:
   // T1 = g1^r1 * h1^r2 mod p1
   // T2 = g2^r1 * h2^r3 mod p2
   // Where (g1, h1, p1) are from "aParams" and (g2, h2, p2) are from "bParams".
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> T1 = (g1 ^ r1) * (h1 ^ r2);  // ap->modulus
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> T2 = (g2 ^ r1) * (h2 ^ r3);    // bp->modulus
+  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> T1 =
+      ap->mulPowGH<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>({}, {}, r1, r2);  // ap->modulus
+  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> T2 =
+      bp->mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({}, {}, r1, r3);  // bp->modulus
 
   // Now hash commitment "A" with commitment "B" as well as the
   // parameters and the two ephemeral commitments "T1, T2" we just generated
@@ -105,19 +102,16 @@ bool CommitmentProofOfKnowledge::Verify(const CBigNum& A, const CBigNum& B) cons
   }
 
   const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> A1(A);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> chal(challenge);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> g1(ap->g);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> h1(ap->h);
-
   const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> B2(B);
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> g2(bp->g);
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> h2(bp->h);
+  const CBigNum negChallenge = 0 - challenge;
 
   // Compute T1 = g1^S1 * h1^S2 / (A^{challenge}) mod p1
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> T1((g1 ^ S1) * (h1 ^ S2) / (A1 ^ challenge));
+  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> T1(
+      ap->mulPowGH<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>({A1}, {negChallenge}, S1, S2));
 
   // Compute T2 = g2^S1 * h2^S3 / (B^{challenge}) mod p2
-  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> T2((g2 ^ S1) * (h2 ^ S3) / (B2 ^ challenge));
+  const IntegerMod<ACCUMULATOR_POK_COMMITMENT_MODULUS> T2(
+      bp->mulPowGH<ACCUMULATOR_POK_COMMITMENT_MODULUS>({B2}, {negChallenge}, S1, S3));
 
   // Hash T1 and T2 along with all of the public parameters
   const CBigNum computedChallenge = calculateChallenge(A, B, T1.getValue(), T2.getValue());
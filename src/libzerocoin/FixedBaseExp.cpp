@@ -0,0 +1,107 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "FixedBaseExp.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace libzerocoin {
+
+FixedBaseExp::FixedBaseExp(const CBigNum& baseIn, const CBigNum& modulusIn, unsigned int nMaxBitsIn,
+                           unsigned int nWindowIn)
+    : base(baseIn), modulus(modulusIn), nWindow(nWindowIn), nLimbs(0), m0inv(0) {
+  // Digits must not straddle GMP limbs
+  if (nWindow == 0 || nWindow > 8 || GMP_NUMB_BITS % nWindow != 0)
+    throw std::runtime_error("FixedBaseExp: unsupported window width");
+
+  const unsigned int nWindows = (nMaxBitsIn + nWindow - 1) / nWindow;
+  const unsigned int nDigits = (1u << nWindow) - 1;
+  nMaxBits = nWindows * nWindow;
+
+  // Montgomery form needs an odd modulus; anything else always goes through pow_mod
+  if (mpz_sgn(modulus.bn) <= 0 || mpz_even_p(modulus.bn)) return;
+  nLimbs = mpz_size(modulus.bn);
+  vModulus.resize(nLimbs);
+  for (size_t i = 0; i < nLimbs; i++) vModulus[i] = mpz_getlimbn(modulus.bn, i);
+  m0inv = MontgomeryInverse(vModulus[0]);
+
+  // x * R mod modulus for a canonical x
+  CBigNum tmp;
+  auto toMont = [&](mp_limb_t* r, const CBigNum& x) {
+    mpz_mul_2exp(tmp.bn, x.bn, nLimbs * GMP_NUMB_BITS);
+    mpz_mod(tmp.bn, tmp.bn, modulus.bn);
+    for (size_t i = 0; i < nLimbs; i++) r[i] = mpz_getlimbn(tmp.bn, i);
+  };
+  std::vector<mp_limb_t> vScratch(2 * nLimbs);
+  auto mul = [&](mp_limb_t* r, const mp_limb_t* a, const mp_limb_t* b) {
+    mpn_mul_n(vScratch.data(), a, b, nLimbs);
+    MontgomeryRedc(r, vScratch.data(), vModulus.data(), nLimbs, m0inv);
+  };
+
+  vOne.resize(nLimbs);
+  toMont(vOne.data(), CBigNum(1));
+  vTable.resize((size_t)nWindows * nDigits * nLimbs);
+  std::vector<mp_limb_t> vWindowBase(nLimbs);
+  toMont(vWindowBase.data(), base % modulus);
+  for (unsigned int i = 0; i < nWindows; i++) {
+    mp_limb_t* pRow = &vTable[(size_t)i * nDigits * nLimbs];
+    std::copy(vWindowBase.begin(), vWindowBase.end(), pRow);
+    for (unsigned int d = 1; d < nDigits; d++) mul(pRow + d * nLimbs, pRow + (d - 1) * nLimbs, vWindowBase.data());
+    // Next window base is this one raised to 2^w
+    mul(vWindowBase.data(), pRow + (nDigits - 1) * nLimbs, vWindowBase.data());
+  }
+}
+
+void FixedBaseExp::PowLimbs(mp_limb_t* r, mp_limb_t* t, const CBigNum& e) const {
+  const unsigned int nDigits = (1u << nWindow) - 1;
+  const unsigned int nPerLimb = GMP_NUMB_BITS / nWindow;
+  const mp_limb_t nMask = nDigits;
+
+  std::copy(vOne.begin(), vOne.end(), r);
+  const size_t nExpLimbs = mpz_size(e.bn);
+  for (size_t l = 0; l < nExpLimbs; l++) {
+    mp_limb_t limb = mpz_getlimbn(e.bn, l);
+    for (unsigned int k = 0; k < nPerLimb && limb; k++, limb >>= nWindow) {
+      const unsigned int d = (unsigned int)(limb & nMask);
+      if (d == 0) continue;
+      mpn_mul_n(t, r, &vTable[((l * nPerLimb + k) * nDigits + d - 1) * nLimbs], nLimbs);
+      MontgomeryRedc(r, t, vModulus.data(), nLimbs, m0inv);
+    }
+  }
+}
+
+CBigNum FixedBaseExp::pow(const CBigNum& e) const {
+  if (!UsesTable(e)) return PowModSigned(base, e, modulus);
+
+  std::vector<mp_limb_t> vLimbs(3 * nLimbs);
+  mp_limb_t* r = vLimbs.data();
+  mp_limb_t* t = r + nLimbs;
+  PowLimbs(r, t, e);
+
+  // Out of Montgomery form: reduce r * 1
+  std::copy(r, r + nLimbs, t);
+  std::fill(t + nLimbs, t + 2 * nLimbs, 0);
+  CBigNum result;
+  MontgomeryRedc(mpz_limbs_write(result.bn, nLimbs), t, vModulus.data(), nLimbs, m0inv);
+  mpz_limbs_finish(result.bn, nLimbs);
+
+  if (mpz_sgn(e.bn) < 0) mpz_invert(result.bn, result.bn, modulus.bn);
+  return result;
+}
+
+CBigNum PowModSigned(const CBigNum& base, const CBigNum& e, const CBigNum& m) {
+  CBigNum ret;
+  if (mpz_sgn(e.bn) < 0) {
+    // g^-x = (g^-1)^x
+    CBigNum posE;
+    mpz_neg(posE.bn, e.bn);
+    mpz_powm(ret.bn, base.inverse(m).bn, posE.bn, m.bn);
+  } else {
+    mpz_powm(ret.bn, base.bn, e.bn, m.bn);
+  }
+  return ret;
+}
+
+} /* namespace libzerocoin */
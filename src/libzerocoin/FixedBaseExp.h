@@ -0,0 +1,69 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include "Montgomery.h"
+#include "bignum.h"
+
+#include <vector>
+
+namespace libzerocoin {
+
+/**
+ * Precomputed powers of a fixed base for fast modular exponentiation.
+ *
+ * With window width w the table holds base^(d * 2^(w*i)) for every digit
+ * d in [1, 2^w) and every window i of an exponent up to nMaxBits wide. base^e
+ * is then the product of one table entry per non-zero digit of e, about
+ * nMaxBits / w multiplications and no squarings. Entries are kept in
+ * Montgomery form, so those multiplications need no division.
+ */
+class FixedBaseExp {
+ public:
+  FixedBaseExp() : nWindow(0), nMaxBits(0), nLimbs(0), m0inv(0) {}
+  FixedBaseExp(const CBigNum& baseIn, const CBigNum& modulusIn, unsigned int nMaxBitsIn, unsigned int nWindowIn = 4);
+
+  /**
+   * base^e mod modulus. A negative exponent gives the inverse of base^|e|;
+   * exponents wider than the table fall back to pow_mod.
+   */
+  CBigNum pow(const CBigNum& e) const;
+
+  //! pow(e) in the Montgomery form of mont, straight from the table when mont works mod the same modulus
+  template <size_t N> typename Montgomery<N>::Elem powMont(const Montgomery<N>& mont, const CBigNum& e) const {
+    if (nLimbs != N || !UsesTable(e) || mpz_sgn(e.bn) < 0 || mont.getModulus() != modulus) return mont.ToMont(pow(e));
+    typename Montgomery<N>::Elem r;
+    mp_limb_t t[2 * N];
+    PowLimbs(r.data(), t, e);
+    return r;
+  }
+
+  const CBigNum& getBase() const { return base; }
+  const CBigNum& getModulus() const { return modulus; }
+  unsigned int getMaxBits() const { return nMaxBits; }
+
+ private:
+  CBigNum base;
+  CBigNum modulus;
+  unsigned int nWindow;
+  unsigned int nMaxBits;
+  //! Width of modulus in limbs, which fixes R = 2^(nLimbs * GMP_NUMB_BITS)
+  size_t nLimbs;
+  mp_limb_t m0inv;
+  std::vector<mp_limb_t> vModulus;
+  //! R mod modulus
+  std::vector<mp_limb_t> vOne;
+  //! base^(d * 2^(w*i)) * R mod modulus as nLimbs limbs at index (i * (2^w - 1) + d - 1) * nLimbs
+  std::vector<mp_limb_t> vTable;
+
+  bool UsesTable(const CBigNum& e) const { return !vTable.empty() && mpz_sizeinbase(e.bn, 2) <= nMaxBits; }
+
+  //! r = base^|e| in Montgomery form, r has nLimbs limbs and t 2 * nLimbs limbs of scratch
+  void PowLimbs(mp_limb_t* r, mp_limb_t* t, const CBigNum& e) const;
+};
+
+//! base^e mod m for any sign of e, without a table
+CBigNum PowModSigned(const CBigNum& base, const CBigNum& e, const CBigNum& m);
+
+} /* namespace libzerocoin */
@@ -13,9 +13,13 @@
 // Copyright (c) 2018 The TessaCoin developers
 #pragma once
 
+#include "FixedBaseExp.h"
+#include "IntegerMod.h"
 #include "ZerocoinDefines.h"
 #include "bignum.h"
 
+#include <memory>
+
 namespace libzerocoin {
 
 class IntegerGroupParams {
@@ -52,6 +56,42 @@ class IntegerGroupParams {
    */
   CBigNum groupOrder;
 
+  /**
+   * Precomputed powers of g and h, see ZerocoinParams::Precompute().
+   * Not serialized; empty until precomputed.
+   */
+  std::shared_ptr<const FixedBaseExp> gTable;
+  std::shared_ptr<const FixedBaseExp> hTable;
+
+  //! Build the g and h tables for exponents up to nMaxBits wide
+  void Precompute(unsigned int nMaxBits) { Precompute(nMaxBits, modulus); }
+
+  //! Same, for groups like the accumulator QRN group that leave modulus unset and work mod bnModulus
+  void Precompute(unsigned int nMaxBits, const CBigNum& bnModulus) {
+    gTable = std::make_shared<const FixedBaseExp>(g, bnModulus, nMaxBits);
+    hTable = std::make_shared<const FixedBaseExp>(h, bnModulus, nMaxBits);
+  }
+
+  //! g^e mod modulus, through the table once precomputed
+  CBigNum powG(const CBigNum& e) const { return gTable ? gTable->pow(e) : PowModSigned(g, e, modulus); }
+  //! h^e mod modulus, through the table once precomputed
+  CBigNum powH(const CBigNum& e) const { return hTable ? hTable->pow(e) : PowModSigned(h, e, modulus); }
+
+  /**
+   * prod(vBases[i]^vExps[i]) * g^eg * h^eh mod the modulus of T, as a single multi-exponentiation.
+   * g and h go through their tables once precomputed and are folded into the same pass otherwise.
+   */
+  template <ModulusType T>
+  IntegerMod<T> mulPowGH(std::vector<IntegerMod<T>> vBases, std::vector<CBigNum> vExps, const CBigNum& eg,
+                         const CBigNum& eh) const {
+    if (gTable && hTable) return IntegerMod<T>::multiPow(vBases, vExps, *gTable, eg, *hTable, eh);
+    vBases.emplace_back(g);
+    vBases.emplace_back(h);
+    vExps.push_back(eg);
+    vExps.push_back(eh);
+    return IntegerMod<T>::multiPow(vBases, vExps);
+  }
+
   ADD_SERIALIZE_METHODS
   template <typename Stream, typename Operation> inline void SerializationOp(Stream& s, Operation ser_action) {
     READWRITE(initialized);
@@ -8,33 +8,52 @@
 #include <stdexcept>
 #include <vector>
 
+#include "FixedBaseExp.h"
 #include "ModulusType.h"
+#include "Montgomery.h"
+#include "MultiExp.h"
 
 template <ModulusType T> class IntegerMod {
  public:
   CBigNum Value;
   static const CBigNum Mod;
 
+  //! Fixed-width Montgomery arithmetic mod Mod, which exponentiations run on
+  typedef libzerocoin::Montgomery<ModulusLimbs<T>::value> MontgomeryArith;
+  static const MontgomeryArith& GetMontgomery() {
+    static const MontgomeryArith mont(Mod);
+    return mont;
+  }
+
  public:
   IntegerMod() {}
-  IntegerMod(CBigNum val) {
-    Value = val % IntegerMod<T>::Mod;  // Make sure it's reduced at init
+  IntegerMod(const CBigNum& val) {
+    mpz_mmod(Value.bn, val.bn, Mod.bn);  // Make sure it's reduced at init
   }
 
+  IntegerMod(const IntegerMod& b) = default;
+  IntegerMod(IntegerMod&& b) = default;
+
   IntegerMod& operator=(const IntegerMod& b) {
-    Value = b.Value % Mod;  // Make sure it's reduced (shouldn't be needed)
+    mpz_mmod(Value.bn, b.Value.bn, Mod.bn);  // Make sure it's reduced (shouldn't be needed)
+    return *this;
+  }
+
+  IntegerMod& operator=(IntegerMod&& b) {
+    Value = std::move(b.Value);
+    mpz_mmod(Value.bn, Value.bn, Mod.bn);  // Make sure it's reduced (shouldn't be needed)
     return *this;
   }
 
   IntegerMod& operator=(const CBigNum& b) {
-    Value = b % Mod;  // Make sure it's modulo Modulus
+    mpz_mmod(Value.bn, b.bn, Mod.bn);  // Make sure it's modulo Modulus
     return *this;
   }
 
   ~IntegerMod() {}
 
-  void setValue(CBigNum b) {
-    Value = b % Mod;  // Make sure it's modulo Modulus
+  void setValue(const CBigNum& b) {
+    mpz_mmod(Value.bn, b.bn, Mod.bn);  // Make sure it's modulo Modulus
   }
 
   CBigNum getValue() const { return Value; }
@@ -51,51 +70,90 @@ template <ModulusType T> class IntegerMod {
   void SetHex(const std::string& str) { Value.SetHex(str); }
   std::string ToString(int nBase = 10) const { return Value.ToString(nBase); }
   std::string GetHex() const { return ToString(16); }
-  IntegerMod operator^(const IntegerMod& e) const {
-    IntegerMod ret(*this);
-    if (e.Value < 0) {
-      // g^-x = (g^-1)^x
-      CBigNum inv = Value.inverse(Mod);
-      CBigNum posE = e.Value * -1;
-      ret.Value = inv.pow_mod(posE, Mod);
-    } else {
-      ret.Value = Value.pow_mod(e.Value, Mod);
-    }
+  IntegerMod operator^(const IntegerMod& e) const { return *this ^ e.Value; }
+
+  /**
+   * Value^e in time that only shows how many limbs e spans, so secret
+   * exponents like commitment randomness don't leak through the timing.
+   */
+  IntegerMod operator^(const CBigNum& e) const {
+    const MontgomeryArith& mont = GetMontgomery();
+    IntegerMod ret;
+    CBigNum posE;
+    mpz_abs(posE.bn, e.bn);
+    // g^-x = (g^-1)^x
+    const typename MontgomeryArith::Elem b = mont.ToMont(mpz_sgn(e.bn) < 0 ? Value.inverse(Mod) : Value);
+    ret.Value = mont.FromMont(mont.Pow(b, posE, mpz_size(posE.bn) * GMP_NUMB_BITS));
     return ret;
   }
-  IntegerMod operator^(const CBigNum& e) const {
-    IntegerMod ret(*this);
-    if (e < 0) {
-      // g^-x = (g^-1)^x
-      CBigNum inv = Value.inverse(Mod);
-      CBigNum posE = e * -1;
-      ret.Value = inv.pow_mod(posE, Mod);
-    } else {
-      ret.Value = Value.pow_mod(e, Mod);
-    }
+
+  //! prod(vBases[i]^vExps[i]) in one pass over the exponents, see libzerocoin::MultiPowMod()
+  static IntegerMod multiPow(const std::vector<IntegerMod>& vBases, const std::vector<CBigNum>& vExps) {
+    IntegerMod ret;
+    ret.Value = GetMontgomery().FromMont(multiPowMont(vBases, vExps));
     return ret;
   }
 
+  //! Same, times g^eg * h^eh with g and h taken from their precomputed tables
+  static IntegerMod multiPow(const std::vector<IntegerMod>& vBases, const std::vector<CBigNum>& vExps,
+                             const libzerocoin::FixedBaseExp& gTable, const CBigNum& eg,
+                             const libzerocoin::FixedBaseExp& hTable, const CBigNum& eh) {
+    const MontgomeryArith& mont = GetMontgomery();
+    typename MontgomeryArith::Elem r = multiPowMont(vBases, vExps);
+    mont.Mul(r, r, gTable.powMont(mont, eg));
+    mont.Mul(r, r, hTable.powMont(mont, eh));
+    IntegerMod ret;
+    ret.Value = mont.FromMont(r);
+    return ret;
+  }
+
+  //! multiPow() in Montgomery form
+  static typename MontgomeryArith::Elem multiPowMont(const std::vector<IntegerMod>& vBases,
+                                                     const std::vector<CBigNum>& vExps) {
+    const MontgomeryArith& mont = GetMontgomery();
+    std::vector<CBigNum> vValues;
+    vValues.reserve(vBases.size());
+    for (const IntegerMod& b : vBases) vValues.push_back(b.Value);
+
+    std::vector<CBigNum> vPosBases;
+    std::vector<const mpz_t*> vPosExps;
+    std::vector<CBigNum> vNegExps;
+    const size_t nBits = libzerocoin::FoldExponentSigns(vValues, vExps, Mod, vPosBases, vPosExps, vNegExps);
+    if (vPosBases.empty()) return mont.One();
+    if (vPosBases.size() == 1) {
+      // A single chain is quicker through GMP's own exponentiation
+      CBigNum r;
+      mpz_powm(r.bn, vPosBases[0].bn, *vPosExps[0], Mod.bn);
+      return mont.ToMont(r);
+    }
+
+    std::vector<typename MontgomeryArith::Elem> vMontBases;
+    vMontBases.reserve(vPosBases.size());
+    for (const CBigNum& b : vPosBases) vMontBases.push_back(mont.ToMont(b));
+    return libzerocoin::MultiPow(mont, vMontBases, vPosExps, nBits);
+  }
+
   IntegerMod inverse() const {
-    IntegerMod ret(*this);
+    IntegerMod ret;
     mpz_invert(ret.Value.bn, Value.bn, Mod.bn);
     return ret;
   }
 
   IntegerMod& operator+=(const IntegerMod& b) {
-    Value += b.getValue();
-    Value = Value % Mod;
+    mpz_add(Value.bn, Value.bn, b.Value.bn);
+    mpz_mmod(Value.bn, Value.bn, Mod.bn);
     return *this;
   }
 
   IntegerMod& operator-=(const IntegerMod& b) {
-    Value -= b.getValue();
-    Value = Value % Mod;
+    mpz_sub(Value.bn, Value.bn, b.Value.bn);
+    mpz_mmod(Value.bn, Value.bn, Mod.bn);
     return *this;
   }
 
   IntegerMod& operator*=(const IntegerMod& b) {
-    Value = Value.mul_mod(b.Value, Mod);
+    mpz_mul(Value.bn, Value.bn, b.Value.bn);
+    mpz_mmod(Value.bn, Value.bn, Mod.bn);
     return *this;
   }
 
@@ -106,8 +164,8 @@ template <ModulusType T> class IntegerMod {
 
   IntegerMod& operator++() {
     // prefix operator
-    mpz_add(Value.bn, Value.bn, CBigNum(1).bn);
-    Value = Value % Mod;
+    mpz_add_ui(Value.bn, Value.bn, 1);
+    mpz_mmod(Value.bn, Value.bn, Mod.bn);
     return *this;
   }
 
@@ -144,50 +202,49 @@ template <ModulusType T> class IntegerMod {
   }
 };
 
-template <ModulusType T> inline const IntegerMod<T> operator+(const IntegerMod<T>& a, const IntegerMod<T>& b) {
-  IntegerMod<T> r(a);
-  CBigNum sum;
-  mpz_add(sum.bn, a.Value.bn, b.Value.bn);
-  mpz_mmod(r.Value.bn, sum.bn, a.Mod.bn);
+// Results are computed straight into the returned value, without copying an operand first
+template <ModulusType T> inline IntegerMod<T> operator+(const IntegerMod<T>& a, const IntegerMod<T>& b) {
+  IntegerMod<T> r;
+  mpz_add(r.Value.bn, a.Value.bn, b.Value.bn);
+  mpz_mmod(r.Value.bn, r.Value.bn, a.Mod.bn);
   return r;
 }
 
-template <ModulusType T> inline const IntegerMod<T> operator-(const IntegerMod<T>& a, const IntegerMod<T>& b) {
-  IntegerMod<T> r(a);
-  CBigNum sum;
-  mpz_sub(sum.bn, a.Value.bn, b.Value.bn);
-  mpz_mmod(r.Value.bn, sum.bn, a.Mod.bn);
+template <ModulusType T> inline IntegerMod<T> operator-(const IntegerMod<T>& a, const IntegerMod<T>& b) {
+  IntegerMod<T> r;
+  mpz_sub(r.Value.bn, a.Value.bn, b.Value.bn);
+  mpz_mmod(r.Value.bn, r.Value.bn, a.Mod.bn);
   return r;
 }
 
-template <ModulusType T> inline const IntegerMod<T> operator-(const IntegerMod<T>& a) {
-  IntegerMod<T> r(a);
+template <ModulusType T> inline IntegerMod<T> operator-(const IntegerMod<T>& a) {
+  IntegerMod<T> r;
   mpz_neg(r.Value.bn, a.Value.bn);
   return r;
 }
 
-template <ModulusType T> inline const IntegerMod<T> operator*(const IntegerMod<T>& a, const IntegerMod<T>& b) {
-  IntegerMod<T> r(a);
-  r.Value = (a.Value * b.Value) % r.Mod;
+template <ModulusType T> inline IntegerMod<T> operator*(const IntegerMod<T>& a, const IntegerMod<T>& b) {
+  IntegerMod<T> r;
+  mpz_mul(r.Value.bn, a.Value.bn, b.Value.bn);
+  mpz_mmod(r.Value.bn, r.Value.bn, r.Mod.bn);
   return r;
 }
-template <ModulusType T> inline const IntegerMod<T> operator*(const CBigNum& a, const IntegerMod<T>& b) {
-  IntegerMod<T> r(b);
-  r.Value = (a * b.Value) % r.Mod;
+template <ModulusType T> inline IntegerMod<T> operator*(const CBigNum& a, const IntegerMod<T>& b) {
+  IntegerMod<T> r;
+  mpz_mul(r.Value.bn, a.bn, b.Value.bn);
+  mpz_mmod(r.Value.bn, r.Value.bn, r.Mod.bn);
   return r;
 }
-template <ModulusType T> inline const IntegerMod<T> operator*(const IntegerMod<T>& a, const CBigNum& b) {
-  IntegerMod<T> r(a);
-  r.Value = (a.Value * b) % r.Mod;
+template <ModulusType T> inline IntegerMod<T> operator*(const IntegerMod<T>& a, const CBigNum& b) {
+  IntegerMod<T> r;
+  mpz_mul(r.Value.bn, a.Value.bn, b.bn);
+  mpz_mmod(r.Value.bn, r.Value.bn, r.Mod.bn);
   return r;
 }
 
-template <ModulusType T> inline const IntegerMod<T> operator/(const IntegerMod<T>& a, const IntegerMod<T>& b) {
-  IntegerMod<T> r(a);
-  CBigNum t = b.Value.inverse(a.Mod);
-  IntegerMod<T> ti(t);
-  IntegerMod<T> ret = r * ti;
-  return ret;
+template <ModulusType T> inline IntegerMod<T> operator/(const IntegerMod<T>& a, const IntegerMod<T>& b) {
+  IntegerMod<T> ti(b.Value.inverse(a.Mod));
+  return a * ti;
 }
 /*
 template <ModulusType T> inline const IntegerMod<T> operator%(const IntegerMod<T>& a, const IntegerMod<T>& b) {
@@ -58,3 +58,17 @@ template <> inline CBigNum IntegerModModulus<ACCUMULATOR_POK_COMMITMENT_MODULUS>
 template <> inline CBigNum IntegerModModulus<ACCUMULATOR_POK_COMMITMENT_GROUP>::getModulus() {
   return CBigNum("1723c6b5051557deef6da8dd8d3f3e48f68972cbbac1ca80d910777f72f38b25f");
 }
+
+/// Bit width of each modulus above, which fixes the limb arrays of its Montgomery backend at compile time
+template <ModulusType T> struct ModulusBits;
+template <> struct ModulusBits<ACCUMULATOR_MODULUS> { enum : size_t { value = 2048 }; };
+template <> struct ModulusBits<COIN_COMMITMENT_MODULUS> { enum : size_t { value = 1024 }; };
+template <> struct ModulusBits<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> { enum : size_t { value = 1033 }; };
+template <> struct ModulusBits<SERIAL_NUMBER_SOK_COMMITMENT_GROUP> { enum : size_t { value = 1024 }; };
+template <> struct ModulusBits<ACCUMULATOR_POK_COMMITMENT_MODULUS> { enum : size_t { value = 556 }; };
+template <> struct ModulusBits<ACCUMULATOR_POK_COMMITMENT_GROUP> { enum : size_t { value = 257 }; };
+
+/// Number of GMP limbs holding a modulus of type T
+template <ModulusType T> struct ModulusLimbs {
+  enum : size_t { value = (ModulusBits<T>::value + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS };
+};
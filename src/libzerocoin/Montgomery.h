@@ -0,0 +1,162 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include "bignum.h"
+
+#include <array>
+#include <stdexcept>
+
+namespace libzerocoin {
+
+//! -m0^-1 mod 2^GMP_NUMB_BITS for odd m0, by Newton's iteration where each step doubles the correct low bits
+inline mp_limb_t MontgomeryInverse(mp_limb_t m0) {
+  mp_limb_t inv = 1;
+  for (int i = 0; i < 7; i++) inv *= 2 - m0 * inv;
+  return -inv;
+}
+
+/**
+ * r = t / R mod m for t < m * R, with R = 2^(n * GMP_NUMB_BITS) and m0inv from
+ * MontgomeryInverse(m[0]). t holds 2n limbs and gets clobbered; r holds n limbs
+ * and must not overlap t.
+ */
+inline void MontgomeryRedc(mp_limb_t* r, mp_limb_t* t, const mp_limb_t* m, size_t n, mp_limb_t m0inv) {
+  // Clear one low limb per round; carries out of the top limb are collected in nCarry
+  mp_limb_t nCarry = 0;
+  for (size_t i = 0; i < n; i++) {
+    const mp_limb_t c = mpn_addmul_1(t + i, m, n, t[i] * m0inv);
+    const mp_limb_t s = t[i + n] + c;
+    const mp_limb_t s2 = s + nCarry;
+    nCarry = (mp_limb_t)(s < c) + (mp_limb_t)(s2 < nCarry);
+    t[i + n] = s2;
+  }
+
+  // The result is below 2m; subtract m once without branching on whether it was needed
+  const mp_limb_t nBorrow = mpn_sub_n(r, t + n, m, n);
+  const mp_limb_t nMask = -(nCarry | (nBorrow ^ 1));
+  for (size_t i = 0; i < n; i++) r[i] = (r[i] & nMask) | (t[n + i] & ~nMask);
+}
+
+/**
+ * Arithmetic mod a fixed odd modulus of exactly N limbs, on residues kept in
+ * Montgomery form a * R mod m with R = 2^(N * GMP_NUMB_BITS).
+ *
+ * Residues are plain limb arrays sized at compile time, so products live on
+ * the stack and are reduced without any division or allocation. Everything
+ * but the conversions from and to CBigNum runs in time that depends only on N.
+ */
+template <size_t N> class Montgomery {
+ public:
+  typedef std::array<mp_limb_t, N> Elem;
+
+  explicit Montgomery(const CBigNum& modulusIn) : modulus(modulusIn) {
+    if (mpz_sgn(modulus.bn) <= 0 || mpz_even_p(modulus.bn) || mpz_size(modulus.bn) != N)
+      throw std::runtime_error("Montgomery: modulus must be odd and exactly N limbs wide");
+    Export(m, modulus.bn);
+    m0inv = MontgomeryInverse(m[0]);
+
+    CBigNum t(1);
+    mpz_mul_2exp(t.bn, t.bn, N * GMP_NUMB_BITS);
+    mpz_mod(t.bn, t.bn, modulus.bn);
+    Export(one, t.bn);
+    mpz_mul_2exp(t.bn, t.bn, N * GMP_NUMB_BITS);
+    mpz_mod(t.bn, t.bn, modulus.bn);
+    Export(r2, t.bn);
+  }
+
+  const CBigNum& getModulus() const { return modulus; }
+
+  //! 1 in Montgomery form
+  const Elem& One() const { return one; }
+
+  //! r = a * b; r may alias a or b
+  void Mul(Elem& r, const Elem& a, const Elem& b) const {
+    mp_limb_t t[2 * N];
+    mpn_mul_n(t, a.data(), b.data(), N);
+    Redc(r, t);
+  }
+
+  //! r = a^2; r may alias a
+  void Sqr(Elem& r, const Elem& a) const {
+    mp_limb_t t[2 * N];
+    mpn_sqr(t, a.data(), N);
+    Redc(r, t);
+  }
+
+  //! Montgomery form of a, which may be negative or not reduced
+  Elem ToMont(const CBigNum& a) const {
+    Elem r;
+    if (mpz_sgn(a.bn) >= 0 && mpz_cmp(a.bn, modulus.bn) < 0) {
+      Export(r, a.bn);
+    } else {
+      CBigNum t;
+      mpz_mod(t.bn, a.bn, modulus.bn);
+      Export(r, t.bn);
+    }
+    Mul(r, r, r2);
+    return r;
+  }
+
+  //! Canonical value of a Montgomery form residue
+  CBigNum FromMont(const Elem& a) const {
+    mp_limb_t t[2 * N] = {};
+    for (size_t i = 0; i < N; i++) t[i] = a[i];
+    Elem r;
+    Redc(r, t);
+    CBigNum ret;
+    mp_limb_t* p = mpz_limbs_write(ret.bn, N);
+    for (size_t i = 0; i < N; i++) p[i] = r[i];
+    mpz_limbs_finish(ret.bn, N);
+    return ret;
+  }
+
+  /**
+   * base^e for 0 <= e < 2^nBits, base and result in Montgomery form.
+   *
+   * Fixed windows with a table lookup that touches every entry, so neither
+   * the sequence of operations nor the memory access pattern depends on e.
+   * Only nBits shows, pass a public bound rather than the size of e.
+   */
+  Elem Pow(const Elem& base, const CBigNum& e, size_t nBits) const {
+    if (mpz_sgn(e.bn) < 0) throw std::runtime_error("Montgomery::Pow: negative exponent");
+    if (mpz_sizeinbase(e.bn, 2) > nBits && mpz_sgn(e.bn) != 0)
+      throw std::runtime_error("Montgomery::Pow: exponent wider than nBits");
+
+    const unsigned int w = nBits > 512 ? 5 : 4;
+    Elem vTable[1 << 5];
+    vTable[0] = one;
+    vTable[1] = base;
+    for (unsigned int d = 2; d < (1u << w); d++) Mul(vTable[d], vTable[d - 1], base);
+
+    Elem r = one, entry;
+    const size_t nWindows = (nBits + w - 1) / w;
+    for (size_t k = nWindows; k-- > 0;) {
+      for (unsigned int j = 0; j < w; j++) Sqr(r, r);
+      unsigned int d = 0;
+      for (unsigned int j = 0; j < w; j++) d |= (unsigned int)mpz_tstbit(e.bn, k * w + j) << j;
+      mpn_sec_tabselect(entry.data(), vTable[0].data(), N, 1u << w, d);
+      Mul(r, r, entry);
+    }
+    return r;
+  }
+
+ private:
+  CBigNum modulus;
+  Elem m;
+  //! -m^-1 mod 2^GMP_NUMB_BITS
+  mp_limb_t m0inv;
+  //! R mod m
+  Elem one;
+  //! R^2 mod m, turns a canonical value into Montgomery form with one Mul
+  Elem r2;
+
+  static void Export(Elem& r, const mpz_t a) {
+    for (size_t i = 0; i < N; i++) r[i] = mpz_getlimbn(a, i);
+  }
+
+  void Redc(Elem& r, mp_limb_t* t) const { MontgomeryRedc(r.data(), t, m.data(), N, m0inv); }
+};
+
+} /* namespace libzerocoin */
@@ -0,0 +1,88 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MultiExp.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace libzerocoin {
+
+namespace {
+
+//! Plain mpz multiplication and division mod m, for moduli without a Montgomery backend
+class GmpModArith {
+ public:
+  typedef CBigNum Elem;
+
+  explicit GmpModArith(const CBigNum& mIn) : m(mIn), one(1) {}
+
+  const Elem& One() const { return one; }
+
+  void Mul(Elem& r, const Elem& a, const Elem& b) const {
+    mpz_mul(tmp.bn, a.bn, b.bn);
+    mpz_mod(r.bn, tmp.bn, m.bn);
+  }
+
+  void Sqr(Elem& r, const Elem& a) const {
+    mpz_mul(tmp.bn, a.bn, a.bn);
+    mpz_mod(r.bn, tmp.bn, m.bn);
+  }
+
+ private:
+  const CBigNum& m;
+  const CBigNum one;
+  mutable CBigNum tmp;
+};
+
+}  // namespace
+
+size_t FoldExponentSigns(const std::vector<CBigNum>& vBases, const std::vector<CBigNum>& vExps, const CBigNum& m,
+                         std::vector<CBigNum>& vPosBases, std::vector<const mpz_t*>& vPosExps,
+                         std::vector<CBigNum>& vNegExps) {
+  if (vBases.size() != vExps.size()) throw std::runtime_error("MultiPowMod: bases and exponents differ in number");
+
+  vPosBases.clear();
+  vPosExps.clear();
+  vNegExps.clear();
+  vPosBases.reserve(vBases.size());
+  vPosExps.reserve(vBases.size());
+  // vPosExps points into vNegExps, which must not reallocate
+  vNegExps.reserve(vBases.size());
+  size_t nBits = 0;
+  for (size_t i = 0; i < vBases.size(); i++) {
+    const int nSign = mpz_sgn(vExps[i].bn);
+    if (nSign == 0) continue;
+    if (nSign > 0) {
+      vPosBases.push_back(vBases[i] % m);
+      vPosExps.push_back(&vExps[i].bn);
+    } else {
+      vPosBases.push_back(vBases[i].inverse(m));
+      vNegExps.emplace_back();
+      mpz_neg(vNegExps.back().bn, vExps[i].bn);
+      vPosExps.push_back(&vNegExps.back().bn);
+    }
+    nBits = std::max(nBits, mpz_sizeinbase(vExps[i].bn, 2));
+  }
+  return nBits;
+}
+
+CBigNum MultiPowMod(const std::vector<CBigNum>& vBases, const std::vector<CBigNum>& vExps, const CBigNum& m) {
+  // Work on |e| and fold the sign into the base
+  std::vector<CBigNum> vPosBases;
+  std::vector<const mpz_t*> vPosExps;
+  std::vector<CBigNum> vNegExps;
+  const size_t nBits = FoldExponentSigns(vBases, vExps, m, vPosBases, vPosExps, vNegExps);
+
+  if (vPosBases.empty()) return CBigNum(1) % m;
+  if (vPosBases.size() == 1) {
+    CBigNum ret;
+    mpz_powm(ret.bn, vPosBases[0].bn, *vPosExps[0], m.bn);
+    return ret;
+  }
+
+  return MultiPow(GmpModArith(m), vPosBases, vPosExps, nBits);
+}
+
+} /* namespace libzerocoin */
@@ -0,0 +1,146 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include "bignum.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace libzerocoin {
+
+/**
+ * prod(vBases[i]^vExps[i]) mod m in a single pass over the exponent bits.
+ *
+ * All factors share one chain of squarings. Straus' interleaved windows are
+ * used while per-base tables pay off, Pippenger's bucket method once there are
+ * more bases than exponent bits, which is the shape of batch verification with
+ * short random coefficients. Negative exponents use the inverse of their base,
+ * which must then be invertible mod m.
+ */
+CBigNum MultiPowMod(const std::vector<CBigNum>& vBases, const std::vector<CBigNum>& vExps, const CBigNum& m);
+
+/**
+ * The preparation MultiPowMod() does before its single pass: drops factors
+ * with a zero exponent and replaces base^-e by (base^-1)^e. vPosExps points
+ * into vExps or into vNegExps, which keeps the negated exponents. Returns the
+ * width of the widest exponent.
+ */
+size_t FoldExponentSigns(const std::vector<CBigNum>& vBases, const std::vector<CBigNum>& vExps, const CBigNum& m,
+                         std::vector<CBigNum>& vPosBases, std::vector<const mpz_t*>& vPosExps,
+                         std::vector<CBigNum>& vNegExps);
+
+namespace multiexp {
+
+//! w-bit digit of |e| starting at bit nBit
+inline unsigned int GetDigit(const mpz_t e, size_t nBit, unsigned int w) {
+  unsigned int d = 0;
+  for (unsigned int j = 0; j < w; j++) d |= (unsigned int)mpz_tstbit(e, nBit + j) << j;
+  return d;
+}
+
+//! Multiplications Straus needs with w-bit windows: 2^w - 2 per base for the tables, then one per base and window
+inline double StrausCost(size_t nBases, size_t nBits, unsigned int w) {
+  return double(nBases) * ((1u << w) - 2) + double(nBases) * nBits / w;
+}
+
+//! Multiplications Pippenger needs with c-bit windows: one per base, plus two per bucket, in every window
+inline double PippengerCost(size_t nBases, size_t nBits, unsigned int c) {
+  return (double(nBases) + 2.0 * ((size_t(1) << c) - 1)) * nBits / c;
+}
+
+template <typename Arith>
+typename Arith::Elem Straus(const Arith& arith, const std::vector<typename Arith::Elem>& vBases,
+                            const std::vector<const mpz_t*>& vExps, size_t nBits, unsigned int w) {
+  typedef typename Arith::Elem Elem;
+  const unsigned int nDigits = (1u << w) - 1;
+
+  // vPowers[i * nDigits + d - 1] = base_i^d
+  std::vector<Elem> vPowers(vBases.size() * nDigits);
+  for (size_t i = 0; i < vBases.size(); i++) {
+    Elem* pRow = &vPowers[i * nDigits];
+    pRow[0] = vBases[i];
+    for (unsigned int d = 1; d < nDigits; d++) arith.Mul(pRow[d], pRow[d - 1], vBases[i]);
+  }
+
+  Elem result = arith.One();
+  const size_t nWindows = (nBits + w - 1) / w;
+  for (size_t k = nWindows; k-- > 0;) {
+    if (k + 1 < nWindows)
+      for (unsigned int j = 0; j < w; j++) arith.Sqr(result, result);
+    for (size_t i = 0; i < vBases.size(); i++) {
+      const unsigned int d = GetDigit(*vExps[i], k * w, w);
+      if (d) arith.Mul(result, result, vPowers[i * nDigits + d - 1]);
+    }
+  }
+  return result;
+}
+
+template <typename Arith>
+typename Arith::Elem Pippenger(const Arith& arith, const std::vector<typename Arith::Elem>& vBases,
+                               const std::vector<const mpz_t*>& vExps, size_t nBits, unsigned int c) {
+  typedef typename Arith::Elem Elem;
+  const size_t nBuckets = (size_t(1) << c) - 1;
+
+  std::vector<Elem> vBucket(nBuckets);
+  std::vector<bool> vUsed(nBuckets);
+  Elem result = arith.One();
+  const size_t nWindows = (nBits + c - 1) / c;
+  for (size_t k = nWindows; k-- > 0;) {
+    if (k + 1 < nWindows)
+      for (unsigned int j = 0; j < c; j++) arith.Sqr(result, result);
+
+    // Drop every base into the bucket of its digit
+    std::fill(vUsed.begin(), vUsed.end(), false);
+    for (size_t i = 0; i < vBases.size(); i++) {
+      const unsigned int d = GetDigit(*vExps[i], k * c, c);
+      if (!d) continue;
+      if (vUsed[d - 1]) {
+        arith.Mul(vBucket[d - 1], vBucket[d - 1], vBases[i]);
+      } else {
+        vBucket[d - 1] = vBases[i];
+        vUsed[d - 1] = true;
+      }
+    }
+
+    // prod(bucket_d^d) as a running product from the top bucket down
+    Elem running = arith.One(), window = arith.One();
+    bool fRunning = false;
+    for (size_t d = nBuckets; d > 0; d--) {
+      if (vUsed[d - 1]) {
+        arith.Mul(running, running, vBucket[d - 1]);
+        fRunning = true;
+      }
+      if (fRunning) arith.Mul(window, window, running);
+    }
+    arith.Mul(result, result, window);
+  }
+  return result;
+}
+
+}  // namespace multiexp
+
+/**
+ * The single pass of MultiPowMod() over reduced bases and non-negative
+ * exponents at most nBits wide, in whatever representation Arith works on:
+ * Arith::Elem is the residue type, One() the unit, Mul(r, a, b) and Sqr(r, a)
+ * must allow r to alias an operand. Montgomery<N> is one such arithmetic.
+ */
+template <typename Arith>
+typename Arith::Elem MultiPow(const Arith& arith, const std::vector<typename Arith::Elem>& vBases,
+                              const std::vector<const mpz_t*>& vExps, size_t nBits) {
+  using namespace multiexp;
+
+  // Pick whichever method and window width needs the fewest multiplications
+  const size_t n = vBases.size();
+  unsigned int w = 1, c = 1;
+  for (unsigned int i = 2; i <= 8; i++)
+    if (StrausCost(n, nBits, i) < StrausCost(n, nBits, w)) w = i;
+  for (unsigned int i = 2; i <= 16; i++)
+    if (PippengerCost(n, nBits, i) < PippengerCost(n, nBits, c)) c = i;
+  if (StrausCost(n, nBits, w) <= PippengerCost(n, nBits, c)) return Straus(arith, vBases, vExps, nBits, w);
+  return Pippenger(arith, vBases, vExps, nBits, c);
+}
+
+} /* namespace libzerocoin */
@@ -0,0 +1,145 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libzerocoin {
+
+namespace {
+
+//! One ParallelFor call: indices are handed out through nNext to whichever thread asks first
+struct Job {
+  const std::function<void(size_t)>* pfn;
+  size_t nCount;
+  std::atomic<size_t> nNext;
+  std::atomic<size_t> nDone;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::exception_ptr error;
+
+  Job(const std::function<void(size_t)>& fn, size_t nCountIn) : pfn(&fn), nCount(nCountIn), nNext(0), nDone(0) {}
+
+  //! Run indices until none are left
+  void Work() {
+    size_t nRan = 0;
+    for (size_t i = nNext++; i < nCount; i = nNext++) {
+      try {
+        (*pfn)(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+      }
+      nRan++;
+    }
+    if (nRan && (nDone += nRan) == nCount) {
+      std::lock_guard<std::mutex> lock(mutex);
+      cond.notify_all();
+    }
+  }
+};
+
+class WorkerPool {
+ public:
+  ~WorkerPool() { Resize(0); }
+
+  void Resize(unsigned int nWorkers) {
+    std::lock_guard<std::mutex> lockResize(mutexResize);
+    Stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    fStop = false;
+    for (unsigned int i = 0; i < nWorkers; i++) vThreads.emplace_back(&WorkerPool::Loop, this);
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return vThreads.size();
+  }
+
+  //! Let up to nHelpers workers join the job
+  void Post(const std::shared_ptr<Job>& job, size_t nHelpers) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < nHelpers; i++) queue.push_back(job);
+    cond.notify_all();
+  }
+
+ private:
+  std::mutex mutexResize;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<std::shared_ptr<Job>> queue;
+  std::vector<std::thread> vThreads;
+  bool fStop = false;
+
+  void Stop() {
+    std::vector<std::thread> vOld;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      fStop = true;
+      vOld.swap(vThreads);
+      cond.notify_all();
+    }
+    for (std::thread& t : vOld) t.join();
+  }
+
+  void Loop() {
+    while (true) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return fStop || !queue.empty(); });
+        if (fStop) return;
+        job = std::move(queue.front());
+        queue.pop_front();
+      }
+      job->Work();
+    }
+  }
+};
+
+WorkerPool& GetPool() {
+  static WorkerPool pool;
+  return pool;
+}
+
+std::atomic<unsigned int> nProofThreads(1);
+
+}  // namespace
+
+void SetProofThreads(unsigned int nThreads) {
+  nThreads = std::max(1u, std::min(nThreads, MAX_PROOF_THREADS));
+  nProofThreads = nThreads;
+  GetPool().Resize(nThreads - 1);
+}
+
+unsigned int GetProofThreads() { return nProofThreads; }
+
+void ParallelFor(size_t nCount, const std::function<void(size_t)>& fn) {
+  const size_t nHelpers = std::min<size_t>(GetPool().Size(), nCount > 0 ? nCount - 1 : 0);
+  if (nHelpers == 0) {
+    for (size_t i = 0; i < nCount; i++) fn(i);
+    return;
+  }
+
+  std::shared_ptr<Job> job = std::make_shared<Job>(fn, nCount);
+  GetPool().Post(job, nHelpers);
+  job->Work();
+  {
+    // Helpers still running an index keep fn in use
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cond.wait(lock, [&job] { return job->nDone == job->nCount; });
+  }
+  if (job->error) std::rethrow_exception(job->error);
+}
+
+} /* namespace libzerocoin */
@@ -0,0 +1,32 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace libzerocoin {
+
+//! Most threads that may work on a single proof
+static const unsigned int MAX_PROOF_THREADS = 64;
+
+/**
+ * Set how many threads may work on the independent iterations of a single
+ * proof, counting the thread that builds or verifies it. Starts or stops the
+ * shared worker threads accordingly; 0 and 1 both mean no workers, which is
+ * also the state before the first call.
+ */
+void SetProofThreads(unsigned int nThreads);
+unsigned int GetProofThreads();
+
+/**
+ * Call fn(i) for every i in [0, nCount), spread over the shared worker
+ * threads. The calling thread takes indices too, so this completes even when
+ * every worker is busy with other callers. fn must be safe to run
+ * concurrently for different i. An exception thrown by fn is rethrown here
+ * once the remaining calls have finished.
+ */
+void ParallelFor(size_t nCount, const std::function<void(size_t)>& fn);
+
+} /* namespace libzerocoin */
@@ -90,8 +90,7 @@ CBigNum PrivateCoin::CoinFromSeed(const uint512& seedZerocoin) {
 
   // convert state seed into a seed for the private key
   uint256 nSeedPrivKey = seedZerocoin.trim256();
-  const IntegerMod<COIN_COMMITMENT_MODULUS> g(this->params->coinCommitmentGroup.g);
-  const IntegerMod<COIN_COMMITMENT_MODULUS> h(this->params->coinCommitmentGroup.h);
+  const IntegerGroupParams& group = this->params->coinCommitmentGroup;
 
   bool isValidKey = false;
   CKey key = CKey();
@@ -113,7 +112,7 @@ CBigNum PrivateCoin::CoinFromSeed(const uint512& seedZerocoin) {
 
   /// Manually compute a Pedersen commitment to the serial number "s" under randomness "r"
   /// \f$ C = g^s * h^r (mod p) \f$
-  IntegerMod<COIN_COMMITMENT_MODULUS> C = (g ^ s) * (h ^ r);
+  IntegerMod<COIN_COMMITMENT_MODULUS> C = group.mulPowGH<COIN_COMMITMENT_MODULUS>({}, {}, s, r);
 
   CBigNum random;
   arith_uint256 attempts256 = 0;
@@ -137,7 +136,7 @@ CBigNum PrivateCoin::CoinFromSeed(const uint512& seedZerocoin) {
     /// \f$ r = r + r_delta mod q \f$
     /// \f$ C = C * h mod p \f$
     r = (r + random) % params->coinCommitmentGroup.groupOrder;
-    C *= (h ^ random);
+    C *= IntegerMod<COIN_COMMITMENT_MODULUS>(group.powH(random));
   }
 }
 
@@ -15,6 +15,7 @@
 
 #include "SerialNumberSignatureOfKnowledge.h"
 #include "IntegerMod.h"
+#include "ParallelFor.h"
 #include "rand_bignum.h"
 #include <streams.h>
 
@@ -76,17 +77,16 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Zerocoi
     }
   }
 
-  for (uint32_t i = 0; i < params->zkp_iterations; i++) {
-    // compute g^{ {a^x b^r} h^v} mod q
-    c[i] = challengeCalculation(coin.getSerialNumber(), r[i], v_expanded[i]);
-  }
+  // compute g^{ {a^x b^r} h^v} mod q, iterations are independent until hashed in order below
+  ParallelFor(params->zkp_iterations,
+              [&](size_t i) { c[i] = challengeCalculation(coin.getSerialNumber(), r[i], v_expanded[i]); });
 
   for (uint32_t i = 0; i < params->zkp_iterations; i++) { hasher << c[i]; }
 
   this->hash = hasher.GetHash();
   uint8_t* hashbytes = (uint8_t*)&hash;
 
-  for (uint32_t i = 0; i < params->zkp_iterations; i++) {
+  ParallelFor(params->zkp_iterations, [&](size_t i) {
     int bit = i % 8;
     int byte = i / 8;
 
@@ -96,50 +96,51 @@ SerialNumberSignatureOfKnowledge::SerialNumberSignatureOfKnowledge(const Zerocoi
       sprime[i] = v_seed[i];
     } else {
       s_notprime[i] = r[i] - coin.getRandomness();
-      sprime[i] = v_expanded[i] - (commitmentToCoin.getRandomness() * (b ^ (r[i] - coin.getRandomness())).getValue());
+      sprime[i] = v_expanded[i] - (commitmentToCoin.getRandomness() *
+                                     params->coinCommitmentGroup.powH(r[i] - coin.getRandomness()));
     }
-  }
+  });
 }
 
 inline CBigNum SerialNumberSignatureOfKnowledge::challengeCalculation(const CBigNum& a_exp, const CBigNum& b_exp,
                                                                       const CBigNum& h_exp) const {
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_GROUP> a(params->coinCommitmentGroup.g);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_GROUP> b(params->coinCommitmentGroup.h);
-
   // Extract as CBigNum as Modulus will change in next usage
-  CBigNum exponent = ((a ^ a_exp) * (b ^ b_exp)).getValue();
+  CBigNum exponent =
+      params->coinCommitmentGroup.mulPowGH<SERIAL_NUMBER_SOK_COMMITMENT_GROUP>({}, {}, a_exp, b_exp).getValue();
 
   // Note: Change of Modulus
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> g(params->serialNumberSoKCommitmentGroup.g);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> h(params->serialNumberSoKCommitmentGroup.h);
-
-  return (((g ^ exponent) * (h ^ h_exp)).getValue());
+  return params->serialNumberSoKCommitmentGroup.mulPowGH<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>({}, {}, exponent, h_exp)
+      .getValue();
 }
 
 bool SerialNumberSignatureOfKnowledge::Verify(const CBigNum& coinSerialNumber, const CBigNum& valueOfCommitmentToCoin,
                                               const uint256 msghash) const {
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_GROUP> b(params->coinCommitmentGroup.h);
-  const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> h(params->serialNumberSoKCommitmentGroup.h);
   const IntegerMod<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS> valueOfCoinCommitment(valueOfCommitmentToCoin);
 
   CHashWriter hasher;
   hasher << *params << valueOfCommitmentToCoin << coinSerialNumber << msghash;
 
-  uint8_t* hashbytes = (uint8_t*)&this->hash;
+  const uint8_t* hashbytes = (const uint8_t*)&this->hash;
 
-  for (uint32_t i = 0; i < params->zkp_iterations; i++) {
-    CBigNum tprime;
+  // A malformed proof with too few responses cannot verify
+  if (s_notprime.size() < params->zkp_iterations || sprime.size() < params->zkp_iterations) return false;
+
+  vector<CBigNum> tprime(params->zkp_iterations);
+  ParallelFor(params->zkp_iterations, [&](size_t i) {
     int bit = i % 8;
     int byte = i / 8;
     bool challenge_bit = ((hashbytes[byte] >> bit) & 0x01);
     if (challenge_bit) {
-      tprime = challengeCalculation(coinSerialNumber, s_notprime[i], SeedTo1024(sprime[i].getuint256()));
+      tprime[i] = challengeCalculation(coinSerialNumber, s_notprime[i], SeedTo1024(sprime[i].getuint256()));
     } else {
-      CBigNum exp = (b ^ s_notprime[i]).getValue();  // Convert to CBigNum because below is different Modulus
-      tprime = ((valueOfCoinCommitment ^ exp) * (h ^ sprime[i])).getValue();
+      CBigNum exp = params->coinCommitmentGroup.powH(s_notprime[i]);  // CBigNum because below is different Modulus
+      tprime[i] = params->serialNumberSoKCommitmentGroup
+                      .mulPowGH<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>({valueOfCoinCommitment}, {exp}, 0, sprime[i])
+                      .getValue();
     }
-    hasher << tprime;
-  }
+  });
+
+  for (uint32_t i = 0; i < params->zkp_iterations; i++) { hasher << tprime[i]; }
 
   return hasher.GetHash() == hash;
 }
@@ -18,6 +18,7 @@
 #define ZEROCOIN_MAX_SECURITY_LEVEL 80
 #define ACCPROOF_KPRIME 160
 #define ACCPROOF_KDPRIME 128
+#define ACCUMULATOR_BATCH_MAX 64
 #define MAX_COINMINT_ATTEMPTS 10000
 #define ZEROCOIN_MINT_PRIME_PARAM 20
 #define ZEROCOIN_PROTOCOL_VERSION "1"
@@ -8,6 +8,7 @@
 // Copyright (c) 2018 The Tessacoin developers
 #include "ZerocoinParams.h"
 #include "AccumulatorAndProofParams.h"
+#include "CommitmentProofOfKnowledge.h"
 #include "ModulusType.h"
 #include "ParamGeneration.h"
 
@@ -98,4 +99,19 @@ ZerocoinParams::ZerocoinParams(uint32_t securityLevel) {
   this->initialized = true;
 }
 
+void ZerocoinParams::Precompute() {
+  // Widest exponents each group sees: commitment randomness and serials for the coin group,
+  // the commitment equality proof responses for the serial and PoK groups, and the
+  // accumulator proof responses (modulus/4 * PoK modulus * 2^(k'+k'')) for the QRN group
+  const unsigned int nResponseBits = COMMITMENT_EQUALITY_CHALLENGE_SIZE + COMMITMENT_EQUALITY_SECMARGIN +
+                                     serialNumberSoKCommitmentGroup.modulus.bitSize() + HASH_OUTPUT_BITS;
+  coinCommitmentGroup.Precompute(coinCommitmentGroup.modulus.bitSize());
+  serialNumberSoKCommitmentGroup.Precompute(nResponseBits);
+  accumulatorParams.accumulatorPoKCommitmentGroup.Precompute(nResponseBits);
+  accumulatorParams.accumulatorQRNCommitmentGroup.Precompute(
+      accumulatorParams.accumulatorModulus.bitSize() + accumulatorParams.accumulatorPoKCommitmentGroup.modulus.bitSize() +
+          accumulatorParams.k_prime + accumulatorParams.k_dprime + HASH_OUTPUT_BITS,
+      accumulatorParams.accumulatorModulus);
+}
+
 } /* namespace libzerocoin */
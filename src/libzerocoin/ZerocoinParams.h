@@ -70,6 +70,14 @@ class ZerocoinParams {
    */
   uint32_t zkp_hash_len;
 
+  /**
+   * Build the fixed-base exponentiation tables for the generators of every
+   * group used by the proofs. Until this is called the proofs fall back to
+   * plain modular exponentiation. Not thread safe: call before the
+   * parameters are shared between threads.
+   */
+  void Precompute();
+
   ADD_SERIALIZE_METHODS
   template <typename Stream, typename Operation> inline void SerializationOp(Stream& s, Operation ser_action) {
     READWRITE(initialized);
@@ -71,6 +71,7 @@ int64_t nTimeBestReceived = 0;
 CWaitableCriticalSection csBestBlock;
 CConditionVariable cvBlockChange;
 int nScriptCheckThreads = 0;
+int nLoadIndexThreads = 1;
 bool fImporting = false;
 bool fReindex = false;
 bool fTxIndex = true;
@@ -687,7 +688,8 @@ int GetInputAge(CTxIn& vin) {
   }
 }
 
-bool CheckTransaction(const CTransaction& tx, bool fZerocoinActive, CValidationState& state) {
+bool CheckTransaction(const CTransaction& tx, bool fZerocoinActive, CValidationState& state,
+                      std::vector<CZerocoinSpendCheck>* pvZerocoinChecks, bool fZerocoinCacheStore) {
   // Basic checks that don't depend on any context
   if (tx.vin.empty())
     return state.DoS(10, error("CheckTransaction() : vin empty"), REJECT_INVALID, "bad-txns-vin-empty");
@@ -740,7 +742,7 @@ bool CheckTransaction(const CTransaction& tx, bool fZerocoinActive, CValidationS
       // Do not require signature verification if this is initial sync and a block over 24 hours old
       bool fVerifySignature =
           !IsInitialBlockDownload() && (GetTime() - chainActive.Tip()->GetBlockTime() < (60 * 60 * 24));
-      if (!CheckZerocoinSpend(tx, fVerifySignature, state))
+      if (!CheckZerocoinSpend(tx, fVerifySignature, state, pvZerocoinChecks, fZerocoinCacheStore))
         return state.DoS(100, error("CheckTransaction() : invalid zerocoin spend"));
     }
   }
@@ -828,12 +830,36 @@ CAmount GetMinRelayFee(const CTransaction& tx, unsigned int nBytes, bool fAllowF
   return nMinFee;
 }
 
+/**
+ * Each zerocoin spend proof takes tens of milliseconds, so they get their own queue
+ * (batch size 1) served by -par threads. CCheckQueueControl expects a single master,
+ * which cs_main does not guarantee for CheckBlock; callers that cannot take
+ * cs_zerocoincheckqueue verify inline instead.
+ */
+static CCheckQueue<CZerocoinSpendCheck> zerocoincheckqueue(1);
+static boost::mutex cs_zerocoincheckqueue;
+
+/**
+ * CheckTransaction for loose transactions: the zerocoin spend proofs are spread over the
+ * check threads when they are free, and remembered so the block carrying them skips them
+ */
+static bool CheckTransactionParallel(const CTransaction& tx, bool fZerocoinActive, CValidationState& state) {
+  boost::unique_lock<boost::mutex> lockQueue(cs_zerocoincheckqueue, boost::try_to_lock);
+  bool fParallel = nScriptCheckThreads && lockQueue.owns_lock() && tx.IsZerocoinSpend();
+  CCheckQueueControl<CZerocoinSpendCheck> control(fParallel ? &zerocoincheckqueue : nullptr);
+  std::vector<CZerocoinSpendCheck> vChecks;
+  if (!CheckTransaction(tx, fZerocoinActive, state, fParallel ? &vChecks : nullptr, true)) return false;
+  control.Add(vChecks);
+  if (!control.Wait()) return state.DoS(100, error("CheckTransaction() : invalid zerocoin spend"));
+  return true;
+}
+
 bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransaction& tx, bool fLimitFree,
                         bool* pfMissingInputs, bool fRejectInsaneFee, bool ignoreFees) {
   AssertLockHeld(cs_main);
   if (pfMissingInputs) *pfMissingInputs = false;
 
-  if (!CheckTransaction(tx, chainActive.Height() >= Params().Zerocoin_StartHeight(), state))
+  if (!CheckTransactionParallel(tx, chainActive.Height() >= Params().Zerocoin_StartHeight(), state))
     return state.DoS(100, error("AcceptToMemoryPool: : CheckTransaction failed"), REJECT_INVALID, "bad-tx");
 
   // Coinbase is only valid in a block, not as a loose transaction
@@ -1050,7 +1076,7 @@ bool AcceptableInputs(CTxMemPool& pool, CValidationState& state, const CTransact
   AssertLockHeld(cs_main);
   if (pfMissingInputs) *pfMissingInputs = false;
 
-  if (!CheckTransaction(tx, chainActive.Height() >= Params().Zerocoin_StartHeight(), state))
+  if (!CheckTransactionParallel(tx, chainActive.Height() >= Params().Zerocoin_StartHeight(), state))
     return error("AcceptableInputs: : CheckTransaction failed");
 
   // Coinbase is only valid in a block, not as a loose transaction
@@ -1558,11 +1584,15 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
   view.SetBestBlock(pindex->pprev->GetBlockHash());
 
   if (!fVerifyingBlocks) {
+    if (!zerocoinDB->EraseBlockMints(pindex->nHeight)) return error("DisconnectBlock(): failed to erase block mints");
+
     // if block is an accumulator checkpoint block, remove checkpoint and checksums from db
     uint256 nCheckpoint = pindex->nAccumulatorCheckpoint;
     if (nCheckpoint != pindex->pprev->nAccumulatorCheckpoint) {
       if (!EraseAccumulatorValues(nCheckpoint, pindex->pprev->nAccumulatorCheckpoint))
         return error("DisconnectBlock(): failed to erase checkpoint");
+      // spends verified against the erased accumulators must be proven again
+      ClearZerocoinSpendCache();
     }
   }
 
@@ -1603,6 +1633,11 @@ void ThreadScriptCheck() {
   scriptcheckqueue.Thread();
 }
 
+void ThreadZerocoinCheck() {
+  RenameThread("tessa-zerocoinch");
+  zerocoincheckqueue.Thread();
+}
+
 bool ReindexAccumulators(list<uint256>& listMissingCheckpoints, string& strError) {
   // Tessa: recalculate Accumulator Checkpoints that failed to database properly
   if (!listMissingCheckpoints.empty() && chainActive.Height() >= Params().Zerocoin_StartHeight()) {
@@ -1708,6 +1743,7 @@ bool UpdateZKPSupply(const CBlock& block, CBlockIndex* pindex) {
   return true;
 }
 
+static int64_t nTimePrefetchTotal = 0;
 static int64_t nTimeVerify = 0;
 static int64_t nTimeConnect = 0;
 static int64_t nTimeIndex = 0;
@@ -1718,7 +1754,7 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
                   bool fJustCheck, bool fAlreadyChecked) {
   AssertLockHeld(cs_main);
   // Check it again in case a previous version let a bad block in
-  if (!fAlreadyChecked && !CheckBlock(block, state, !fJustCheck, !fJustCheck)) return false;
+  if (!fAlreadyChecked && !CheckBlock(block, state, !fJustCheck, !fJustCheck, true, fJustCheck)) return false;
 
   // verify that the view's current state corresponds to the previous block
   uint256 hashPrevBlock = pindex->pprev == nullptr ? uint256() : pindex->pprev->GetBlockHash();
@@ -1766,6 +1802,12 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
   CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
 
   int64_t nTimeStart = GetTimeMicros();
+  // Fetch all inputs the block spends in one batched lookup instead of one database read per input
+  size_t nPrefetched = view.PrefetchInputs(block);
+  int64_t nTimePrefetch = GetTimeMicros() - nTimeStart;
+  nTimePrefetchTotal += nTimePrefetch;
+  LogPrint(TessaLog::BENCH, "      - Prefetch %u input txs: %.2fms [%.2fs]\n", (unsigned)nPrefetched,
+           0.001 * nTimePrefetch, nTimePrefetchTotal * 0.000001);
   CAmount nFees = 0;
   int nInputs = 0;
   unsigned int nSigOps = 0;
@@ -1982,7 +2024,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
   // Flush spend/mint info to disk
   // if (!zerocoinDB->WriteCoinSpendBatch(vSpends)) return state.Abort(("Failed to record coin serials to database"));
-  if (!zerocoinDB->WriteCoinMintBatch(vMints)) return state.Abort(("Failed to record new mints to database"));
+  if (!zerocoinDB->WriteCoinMintBatch(vMints, pindex->GetBlockHash(), pindex->nHeight))
+    return state.Abort(("Failed to record new mints to database"));
 
   // Record accumulator checksums
   DatabaseChecksums(mapAccumulators);
@@ -2056,6 +2099,7 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode) {
         }
         setDirtyBlockIndex.erase(it++);
       }
+      if (!stakeModifierCache.Flush(*pblocktree)) return state.Abort("Failed to write to block index");
       pblocktree->Sync();
       // Finally flush the chainstate (which may refer to block index entries).
       if (!pcoinsTip->Flush()) return state.Abort("Failed to write to coin database");
@@ -2118,6 +2162,7 @@ bool static DisconnectTip(CValidationState& state) {
       return error("DisconnectTip() : DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
     assert(view.Flush());
   }
+  stakeModifierCache.DisconnectBlock(pindexDelete->nHeight);
   LogPrint(TessaLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
   // Write the chain state to disk, if necessary.
   if (!FlushStateToDisk(state, FLUSH_STATE_ALWAYS)) return false;
@@ -2774,7 +2819,8 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, bool f
   return true;
 }
 
-bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bool fCheckMerkleRoot, bool fCheckSig) {
+bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bool fCheckMerkleRoot, bool fCheckSig,
+                bool fZerocoinCacheStore) {
   // These are checks that are independent of context.
 
   // Check that the header is valid (particularly PoW).  This is mostly
@@ -2836,8 +2882,15 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
 #warning "Check zerocoin start here"
   bool fZerocoinActive = true;  // FOR NOW XXXX
   vector<CBigNum> vBlockSerials;
+  boost::unique_lock<boost::mutex> lockQueue(cs_zerocoincheckqueue, boost::try_to_lock);
+  bool fParallel = nScriptCheckThreads && lockQueue.owns_lock();
+  CCheckQueueControl<CZerocoinSpendCheck> control(fParallel ? &zerocoincheckqueue : nullptr);
   for (const CTransaction& tx : block.vtx) {
-    if (!CheckTransaction(tx, fZerocoinActive, state)) { return error("CheckBlock() : CheckTransaction failed"); }
+    std::vector<CZerocoinSpendCheck> vZerocoinChecks;
+    if (!CheckTransaction(tx, fZerocoinActive, state, fParallel ? &vZerocoinChecks : nullptr, fZerocoinCacheStore)) {
+      return error("CheckBlock() : CheckTransaction failed");
+    }
+    control.Add(vZerocoinChecks);
 
     // double check that there are no double spent ZKP spends in this block
     if (tx.IsZerocoinSpend()) {
@@ -2853,6 +2906,9 @@ bool CheckBlock(const CBlock& block, CValidationState& state, bool fCheckPOW, bo
     }
   }
 
+  if (!control.Wait())
+    return state.DoS(100, error("CheckBlock() : zerocoin spend did not verify"), REJECT_INVALID, "bad-zerocoinspend");
+
   unsigned int nSigOps = 0;
   for (const CTransaction& tx : block.vtx) { nSigOps += GetLegacySigOpCount(tx); }
   unsigned int nMaxBlockSigOps = fZerocoinActive ? MAX_BLOCK_SIGOPS_CURRENT : MAX_BLOCK_SIGOPS_LEGACY;
@@ -3174,6 +3230,8 @@ void CBlockIndex::BuildSkip() {
 }
 
 bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp) {
+  uint64_t nHeaderHashStart = CBlockHeader::ThreadHashCount();
+
   // Preliminary checks
   // int64_t nStartTime = GetTimeMillis();
   bool checked = CheckBlock(*pblock, state);
@@ -3219,6 +3277,9 @@ bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDis
 
   if (!ActivateBestChain(state, pblock, checked)) return error("%s : ActivateBestChain failed", __func__);
 
+  LogPrint(TessaLog::BENCH, "%s : %u header hash evaluations for block %s\n", __func__,
+           CBlockHeader::ThreadHashCount() - nHeaderHashStart, pblock->GetHash().GetHex());
+
   if (pwalletMain) {
     // If turned on MultiSend will send a transaction (or more) on the after maturity of a stake
     if (pwalletMain->isMultiSendEnabled()) pwalletMain->MultiSend();
@@ -3245,7 +3306,8 @@ bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex
 
   // NOTE: CheckBlockHeader is called by CheckBlock
   if (!ContextualCheckBlockHeader(block, state, pindexPrev)) return false;
-  if (!CheckBlock(block, state, fCheckPOW, fCheckMerkleRoot)) return false;
+  // A template is checked ahead of the real block, leave its spends cached for that one
+  if (!CheckBlock(block, state, fCheckPOW, fCheckMerkleRoot, true, true)) return false;
   if (!ContextualCheckBlock(block, state, pindexPrev)) return false;
   if (!ConnectBlock(block, state, &indexDummy, viewNew, true)) return false;
   assert(state.IsValid());
@@ -3254,7 +3316,9 @@ bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex
 }
 
 bool static LoadBlockIndexDB(string& strError) {
-  if (!pblocktree->LoadBlockIndexGuts()) return false;
+  int64_t nTimeStart = GetTimeMillis();
+  if (!pblocktree->LoadBlockIndexGuts(nLoadIndexThreads)) return false;
+  int64_t nTimeGuts = GetTimeMillis();
 
   boost::this_thread::interruption_point();
 
@@ -3291,6 +3355,9 @@ bool static LoadBlockIndexDB(string& strError) {
         (pindexBestHeader == nullptr || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
       pindexBestHeader = pindex;
   }
+  int64_t nTimeChain = GetTimeMillis();
+  LogPrintf("%s: block index %dms, chain work and skip list %dms\n", __func__, nTimeGuts - nTimeStart,
+            nTimeChain - nTimeGuts);
 
   // Load block file info
   pblocktree->ReadLastBlockFile(nLastBlockFile);
@@ -3343,6 +3410,8 @@ bool static LoadBlockIndexDB(string& strError) {
 
   PruneBlockIndexCandidates();
 
+  if (!stakeModifierCache.Load(*pblocktree)) return error("LoadBlockIndexDB() : failed to read stake modifiers");
+
   LogPrintf("LoadBlockIndexDB(): hashBestChain=%s height=%d date=%s progress=%f\n",
             chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(),
             DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()),
@@ -3356,6 +3425,7 @@ void UnloadBlockIndex() {
   setBlockIndexCandidates.clear();
   chainActive.SetTip(nullptr);
   pindexBestInvalid = nullptr;
+  stakeModifierCache.Clear();
 }
 
 bool LoadBlockIndex(string& strError) {
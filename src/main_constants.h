@@ -40,6 +40,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000;  // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** -zkpthreads default (number of threads evaluating one zerocoin serial number proof, 0 = auto) */
+static const int DEFAULT_ZKP_THREADS = 0;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -12,6 +12,7 @@
 #include "libzerocoin/CoinSpend.h"
 #include "libzerocoin/PublicCoin.h"
 #include "primitives/zerocoin.h"
+#include "saltedcuckoocache.h"
 #include "utilmoneystr.h"
 #include "zerochain.h"
 
@@ -20,6 +21,36 @@
 using namespace std;
 using namespace libzerocoin;
 
+namespace {
+
+/**
+ * Zerocoin spends whose proofs already verified, so a transaction checked on
+ * mempool entry is not proven a second time when its block is connected
+ */
+class CZerocoinSpendCache : public CSaltedCuckooCache {
+ public:
+  CZerocoinSpendCache() { Setup(ZEROCOIN_SPEND_CACHE_SIZE); }
+
+  //! Key for (txid, accumulator checksum, serial hash)
+  uint256 ComputeEntry(const uint256& txid, const CoinSpend& spend) const {
+    uint32_t nChecksum = spend.getAccumulatorChecksum();
+    uint256 hashSerial = GetSerialHash(spend.getCoinSerialNumber());
+    uint256 entry;
+    Hasher()
+        .Write(txid.begin(), 32)
+        .Write((const unsigned char*)&nChecksum, sizeof(nChecksum))
+        .Write(hashSerial.begin(), 32)
+        .Finalize(entry.begin());
+    return entry;
+  }
+};
+
+CZerocoinSpendCache zerocoinSpendCache;
+
+}  // namespace
+
+void ClearZerocoinSpendCache() { zerocoinSpendCache.Clear(); }
+
 bool CheckZerocoinMint(const uint256& txHash, const CTxOut& txout, CValidationState& state, bool fCheckOnly) {
   PublicCoin pubCoin;
   if (!TxOutToPublicCoin(txout, pubCoin, state))
@@ -58,7 +89,23 @@ bool ContextualCheckZerocoinSpend(const CTransaction& tx, const CoinSpend& spend
   return true;
 }
 
-bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidationState& state) {
+CZerocoinSpendCheck::CZerocoinSpendCheck(const CoinSpend& spendIn, const CBigNum& bnAccumulatorValueIn,
+                                         const uint256& txidIn, bool cacheIn)
+    : spend(std::make_shared<CoinSpend>(spendIn)),
+      bnAccumulatorValue(bnAccumulatorValueIn),
+      txid(txidIn),
+      cacheStore(cacheIn) {}
+
+bool CZerocoinSpendCheck::operator()() {
+  Accumulator accumulator(libzerocoin::gpZerocoinParams, spend->getDenomination(), bnAccumulatorValue);
+  if (!spend->Verify(accumulator))
+    return error("CZerocoinSpendCheck(): zerocoin spend in tx %s did not verify", txid.GetHex());
+  if (cacheStore) zerocoinSpendCache.Set(zerocoinSpendCache.ComputeEntry(txid, *spend));
+  return true;
+}
+
+bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidationState& state,
+                        std::vector<CZerocoinSpendCheck>* pvChecks, bool fCacheStore) {
   // max needed non-mint outputs should be 2 - one for redemption address and a possible 2nd for change
   if (tx.vout.size() > 2) {
     int outs = 0;
@@ -98,8 +145,10 @@ bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidati
     if (newSpend.getTxOutHash() != hashTxOut)
       return state.DoS(100, error("Zerocoinspend does not use the same txout that was used in the SoK"));
 
-    // Skip signature verification during initial block download
-    if (fVerifySignature) {
+    // Skip signature verification during initial block download, and for spends we already verified.
+    // Connecting a block does not store, so a hit there is consumed.
+    if (fVerifySignature &&
+        !zerocoinSpendCache.Get(zerocoinSpendCache.ComputeEntry(tx.GetHash(), newSpend), !fCacheStore)) {
       // see if we have record of the accumulator used in the spend tx
       CBigNum bnAccumulatorValue = 0;
       if (!zerocoinDB->ReadAccumulatorValue(newSpend.getAccumulatorChecksum(), bnAccumulatorValue)) {
@@ -108,11 +157,14 @@ bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidati
                                     __func__, HexStr(BEGIN(nChecksum), END(nChecksum))));
       }
 
-      Accumulator accumulator(libzerocoin::gpZerocoinParams, newSpend.getDenomination(), bnAccumulatorValue);
-
       // Check that the coin has been accumulated
-      if (!newSpend.Verify(accumulator))
+      CZerocoinSpendCheck check(newSpend, bnAccumulatorValue, tx.GetHash(), fCacheStore);
+      if (pvChecks) {
+        pvChecks->push_back(CZerocoinSpendCheck());
+        check.swap(pvChecks->back());
+      } else if (!check()) {
         return state.DoS(100, error("CheckZerocoinSpend(): zerocoin spend did not verify"));
+      }
     }
 
     if (serials.count(newSpend.getCoinSerialNumber()))
@@ -9,6 +9,12 @@
 
 #include "txdb.h"
 
+#include <memory>
+#include <vector>
+
+//! Number of verified zerocoin spends remembered between mempool acceptance and block connection
+static const unsigned int ZEROCOIN_SPEND_CACHE_SIZE = 16384;
+
 // Forward Declarations
 namespace libzerocoin {
 class PublicCoin;
@@ -20,5 +26,41 @@ bool ContextualCheckZerocoinMint(const CTransaction& tx, const libzerocoin::Publ
                                  const CBlockIndex* pindex);
 bool ContextualCheckZerocoinSpend(const CTransaction& tx, const libzerocoin::CoinSpend& spend, CBlockIndex* pindex,
                                   const uint256& hashBlock);
-bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidationState& state);
+
+/**
+ * Closure verifying the zero-knowledge proofs of one zerocoin spend against
+ * the accumulator it claims membership in, so it can run on a CCheckQueue
+ */
+class CZerocoinSpendCheck {
+ private:
+  std::shared_ptr<const libzerocoin::CoinSpend> spend;
+  CBigNum bnAccumulatorValue;
+  uint256 txid;
+  bool cacheStore;
+
+ public:
+  CZerocoinSpendCheck() : cacheStore(false) {}
+  CZerocoinSpendCheck(const libzerocoin::CoinSpend& spendIn, const CBigNum& bnAccumulatorValueIn,
+                      const uint256& txidIn, bool cacheIn);
+
+  bool operator()();
+
+  void swap(CZerocoinSpendCheck& check) {
+    spend.swap(check.spend);
+    std::swap(bnAccumulatorValue, check.bnAccumulatorValue);
+    std::swap(txid, check.txid);
+    std::swap(cacheStore, check.cacheStore);
+  }
+};
+
+/**
+ * With pvChecks set the spend proofs are queued there instead of verified inline.
+ * Proofs found in the verified-spend cache are skipped; fCacheStore adds newly
+ * verified ones to it and keeps hits (mempool, block templates), otherwise a hit
+ * is consumed (block connect).
+ */
+bool CheckZerocoinSpend(const CTransaction& tx, bool fVerifySignature, CValidationState& state,
+                        std::vector<CZerocoinSpendCheck>* pvChecks = nullptr, bool fCacheStore = false);
+//! Forget all verified spends, for when the accumulators they were checked against change
+void ClearZerocoinSpendCache();
 bool ValidatePublicCoin(const CBigNum& value);
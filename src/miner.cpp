@@ -28,6 +28,11 @@
 #include "validationinterface.h"
 
 #include "libzerocoin/CoinSpend.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include <boost/thread.hpp>
 
 using namespace std;
@@ -564,10 +569,12 @@ void BitcoinMiner(CWallet* pwallet, bool fProofOfStake) {
     // If Mining PoW and reach the End of the Period Automatically Switch to Proof-of-Stake
     if (chainActive.Tip()->nHeight >= Params().LAST_POW_BLOCK()) fProofOfStake = 1;
 
+    // Proof-of-work blocks are searched by the CPowMiner threads started in GenerateBitcoins
+    if (!fProofOfStake) return;
+
     //
     // Create new block
     //
-    unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
     CBlockIndex* pindexPrev = chainActive.Tip();
     if (!pindexPrev) continue;
 
@@ -592,99 +599,349 @@ void BitcoinMiner(CWallet* pwallet, bool fProofOfStake) {
 
       continue;
     }
+  }
+}
+
+CBlockIndex* CMinerTipWatch::Begin() {
+  fTipChanged = false;
+  return chainActive.Tip();
+}
 
-    LogPrintf("Running TessaMiner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
-              ::GetSerializeSize(*pblock));
+bool CMinerTipWatch::IsStale(const CBlockIndex* pindexPrev) const {
+  return fTipChanged || pindexPrev != chainActive.Tip();
+}
+
+namespace {
+
+//! Hash rate of each PoW worker over the last hashmeter interval, empty while no miner runs
+std::vector<double> vMinerThreadRates;
+//! Only guards vMinerThreadRates, so getmininginfo never waits on a miner starting or stopping
+std::mutex csMinerRates;
+
+/** Header template published by the PoW coordinator, every worker scans its own slice of the nonce space */
+struct CPowWork {
+  uint64_t nId;
+  CBlockHeader header;
+  arith_uint256 hashTarget;
+};
+
+/**
+ * Proof-of-work mining engine: a coordinator thread owns the block template and republishes it on tip changes,
+ * solutions and nonce exhaustion, while the worker threads hash disjoint nonce ranges of the shared header without
+ * taking any locks in the inner loop.
+ */
+class CPowMiner : public CValidationInterface {
+ private:
+  CWallet* pwallet;
+  int nWorkers;
+  boost::thread_group threads;
+
+  //! Protects the published work, the solution and the coordinator wake-up state
+  boost::mutex mutex;
+  boost::condition_variable condWorker;
+  boost::condition_variable condCoordinator;
+  std::shared_ptr<const CPowWork> pwork;
+  //! Id of the current work, read by the workers after every hash to notice stale work
+  std::atomic<uint64_t> nWorkId;
+  CMinerTipWatch tipWatch;
+  bool fSolved;
+  uint64_t nSolvedWorkId;
+  uint32_t nSolvedNonce;
+  int nExhausted;
+  bool fQuit;
+
+  //! Hashes done by each worker, only ever incremented by its owner
+  std::unique_ptr<std::atomic<uint64_t>[]> pHashCount;
+
+  void Publish(const CBlock& block, const arith_uint256& hashTarget) {
+    std::shared_ptr<CPowWork> work = std::make_shared<CPowWork>();
+    work->header = block.GetBlockHeader();
+    work->hashTarget = hashTarget;
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      work->nId = nWorkId.load() + 1;
+      pwork = work;
+      nWorkId.store(work->nId);
+      fSolved = false;
+      nExhausted = 0;
+    }
+    condWorker.notify_all();
+  }
+
+  //! Make the workers drop their current range and exit
+  void StopWorkers() {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      fQuit = true;
+      nWorkId.store(nWorkId.load() + 1);
+    }
+    condWorker.notify_all();
+  }
+
+  void UpdateHashMeter(int64_t& nMeterStart, std::vector<uint64_t>& vLastCount) {
+    int64_t nNow = GetTimeMillis();
+    if (nNow - nMeterStart < 4000) return;
+
+    std::vector<double> vRates(nWorkers);
+    double dTotal = 0.0;
+    for (int i = 0; i < nWorkers; i++) {
+      uint64_t nCount = pHashCount[i].load(std::memory_order_relaxed);
+      vRates[i] = 1000.0 * (nCount - vLastCount[i]) / (nNow - nMeterStart);
+      vLastCount[i] = nCount;
+      dTotal += vRates[i];
+    }
+    {
+      std::lock_guard<std::mutex> lock(csMinerRates);
+      vMinerThreadRates.swap(vRates);
+    }
+    dHashesPerSec = dTotal;
+    nHPSTimerStart = nNow;
+    nMeterStart = nNow;
+
+    static int64_t nLogTime;
+    if (GetTime() - nLogTime > 30 * 60) {
+      nLogTime = GetTime();
+      LogPrintf("hashmeter %6.0f khash/s over %d threads\n", dHashesPerSec / 1000.0, nWorkers);
+    }
+  }
+
+  void Coordinator() {
+    LogPrintf("TessaMiner started with %d PoW threads\n", nWorkers);
+    RenameThread("tessa-miner");
+
+    CReserveKey reservekey(pwallet);
+    unsigned int nExtraNonce = 0;
+    int64_t nMeterStart = GetTimeMillis();
+    std::vector<uint64_t> vLastCount(nWorkers, 0);
 
-    //
-    // Search
-    //
-    int64_t nStart = GetTime();
-    arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
     while (true) {
-      unsigned int nHashesDone = 0;
+      boost::this_thread::interruption_point();
 
-      uint256 hash;
-      while (true) {
-        hash = pblock->GetHash();
-        if (UintToArith256(hash) <= hashTarget) {
-          // Found a solution
-          SetThreadPriority(THREAD_PRIORITY_NORMAL);
-          LogPrintf("BitcoinMiner:\n");
-          LogPrintf("proof-of-work found  \n  hash: %s  \ntarget: %s\n", hash.GetHex(), hashTarget.GetHex());
-          ProcessBlockFound(pblock, *pwallet, reservekey);
-          SetThreadPriority(THREAD_PRIORITY_LOWEST);
-
-          // In regression test mode, stop mining after a block is found. This
-          // allows developers to controllably generate a block on demand.
-          if (Params().MineBlocksOnDemand()) throw boost::thread_interrupted();
+      // Regtest mode doesn't require peers
+      if (vNodes.empty() && Params().MiningRequiresPeers()) {
+        MilliSleep(1000);
+        continue;
+      }
+
+      // Once the PoW period is over this thread carries on as a stake miner
+      if (chainActive.Tip()->nHeight >= Params().LAST_POW_BLOCK()) {
+        StopWorkers();
+        BitcoinMiner(pwallet, true);
+        return;
+      }
 
+      //
+      // Create new block
+      //
+      unsigned int nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
+      CBlockIndex* pindexPrev = tipWatch.Begin();
+      if (!pindexPrev) continue;
+
+      unique_ptr<CBlockTemplate> pblocktemplate(CreateNewBlockWithKey(reservekey, pwallet, false));
+      if (!pblocktemplate.get()) continue;
+
+      CBlock* pblock = &pblocktemplate->block;
+      IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
+
+      LogPrintf("Running TessaMiner with %u transactions in block (%u bytes)\n", pblock->vtx.size(),
+                ::GetSerializeSize(*pblock));
+
+      int64_t nStart = GetTime();
+      arith_uint256 hashTarget = arith_uint256().SetCompact(pblock->nBits);
+      Publish(*pblock, hashTarget);
+
+      //
+      // Wait for a solution, the nonce space to run out or the template to go stale
+      //
+      while (true) {
+        bool fFound = false;
+        bool fRebuild = false;
+        uint32_t nNonce = 0;
+        {
+          boost::unique_lock<boost::mutex> lock(mutex);
+          uint64_t nId = nWorkId.load();
+          if (!(fSolved && nSolvedWorkId == nId) && nExhausted < nWorkers && !tipWatch.IsStale(pindexPrev))
+            condCoordinator.timed_wait(lock, boost::posix_time::seconds(1));
+          if (fSolved && nSolvedWorkId == nId) {
+            fFound = true;
+            nNonce = nSolvedNonce;
+          }
+          fRebuild = nExhausted >= nWorkers || tipWatch.IsStale(pindexPrev);
+        }
+        UpdateHashMeter(nMeterStart, vLastCount);
+
+        if (fFound) {
+          pblock->nNonce = nNonce;
+          uint256 hash = pblock->GetHash();
+          if (UintToArith256(hash) <= hashTarget) {
+            // Found a solution
+            SetThreadPriority(THREAD_PRIORITY_NORMAL);
+            LogPrintf("BitcoinMiner:\n");
+            LogPrintf("proof-of-work found  \n  hash: %s  \ntarget: %s\n", hash.GetHex(), hashTarget.GetHex());
+            ProcessBlockFound(pblock, *pwallet, reservekey);
+            SetThreadPriority(THREAD_PRIORITY_LOWEST);
+
+            // In regression test mode, stop mining after a block is found. This
+            // allows developers to controllably generate a block on demand.
+            if (Params().MineBlocksOnDemand()) throw boost::thread_interrupted();
+          }
           break;
         }
-        pblock->nNonce += 1;
-        nHashesDone += 1;
-        if ((pblock->nNonce & 0xFF) == 0) break;
+
+        // Check for stop or if block needs to be rebuilt
+        boost::this_thread::interruption_point();
+        if (fRebuild) break;
+        if (vNodes.empty() && Params().MiningRequiresPeers()) break;
+        if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60) break;
+
+        // Update nTime every few seconds, the new header restarts every worker on its own range
+        uint32_t nTimeOld = pblock->nTime;
+        UpdateTime(pblock, pindexPrev);
+        if (pblock->nTime != nTimeOld) {
+          if (Params().AllowMinDifficultyBlocks()) {
+            // Changing pblock->nTime can change work required on testnet:
+            hashTarget.SetCompact(pblock->nBits);
+          }
+          Publish(*pblock, hashTarget);
+        }
       }
+    }
+  }
 
-      // Meter hashes/sec
-      static int64_t nHashCounter;
-      if (nHPSTimerStart == 0) {
-        nHPSTimerStart = GetTimeMillis();
-        nHashCounter = 0;
-      } else
-        nHashCounter += nHashesDone;
-      if (GetTimeMillis() - nHPSTimerStart > 4000) {
-        static CCriticalSection cs;
-        {
-          LOCK(cs);
-          if (GetTimeMillis() - nHPSTimerStart > 4000) {
-            dHashesPerSec = 1000.0 * nHashCounter / (GetTimeMillis() - nHPSTimerStart);
-            nHPSTimerStart = GetTimeMillis();
-            nHashCounter = 0;
-            static int64_t nLogTime;
-            if (GetTime() - nLogTime > 30 * 60) {
-              nLogTime = GetTime();
-              LogPrintf("hashmeter %6.0f khash/s\n", dHashesPerSec / 1000.0);
+  void Worker(int nIndex) {
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+    RenameThread("tessa-miner");
+
+    std::atomic<uint64_t>& nHashCount = pHashCount[nIndex];
+    // Disjoint slice of the 32 bit nonce space for this worker, the last one takes the remainder
+    const uint64_t nSpan = ((uint64_t)1 << 32) / nWorkers;
+    const uint32_t nNonceBegin = (uint32_t)(nSpan * nIndex);
+    const uint32_t nNonceLast = (nIndex == nWorkers - 1) ? 0xffffffff : (uint32_t)(nSpan * (nIndex + 1) - 1);
+    uint64_t nLastWorkId = 0;
+
+    while (true) {
+      std::shared_ptr<const CPowWork> work;
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fQuit && (!pwork || pwork->nId == nLastWorkId)) condWorker.wait(lock);
+        if (fQuit) return;
+        work = pwork;
+      }
+      nLastWorkId = work->nId;
+
+      CBlockHeader header = work->header;
+      header.nNonce = nNonceBegin;
+      while (true) {
+        uint256 hash = header.GetHash();
+        nHashCount.fetch_add(1, std::memory_order_relaxed);
+        if (UintToArith256(hash) <= work->hashTarget) {
+          {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (!fSolved && work->nId == nWorkId.load()) {
+              fSolved = true;
+              nSolvedWorkId = work->nId;
+              nSolvedNonce = header.nNonce;
             }
           }
+          condCoordinator.notify_one();
+          break;
         }
+        if (header.nNonce == nNonceLast) {
+          {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (work->nId == nWorkId.load()) nExhausted++;
+          }
+          condCoordinator.notify_one();
+          break;
+        }
+        header.nNonce++;
+
+        if (nWorkId.load(std::memory_order_relaxed) != work->nId) break;
+        boost::this_thread::interruption_point();
       }
+    }
+  }
 
-      // Check for stop or if block needs to be rebuilt
-      boost::this_thread::interruption_point();
-      // Regtest mode doesn't require peers
-      if (vNodes.empty() && Params().MiningRequiresPeers()) break;
-      if (pblock->nNonce >= 0xffff0000) break;
-      if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 60) break;
-      if (pindexPrev != chainActive.Tip()) break;
+ protected:
+  void UpdatedBlockTip(const CBlockIndex* pindex) {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      tipWatch.Notify();
+    }
+    condCoordinator.notify_one();
+  }
 
-      // Update nTime every few seconds
-      UpdateTime(pblock, pindexPrev);
-      if (Params().AllowMinDifficultyBlocks()) {
-        // Changing pblock->nTime can change work required on testnet:
-        hashTarget.SetCompact(pblock->nBits);
+ public:
+  CPowMiner(CWallet* pwalletIn, int nWorkersIn)
+      : pwallet(pwalletIn),
+        nWorkers(nWorkersIn),
+        nWorkId(0),
+        fSolved(false),
+        nSolvedWorkId(0),
+        nSolvedNonce(0),
+        nExhausted(0),
+        fQuit(false),
+        pHashCount(new std::atomic<uint64_t>[nWorkersIn]) {
+    for (int i = 0; i < nWorkers; i++) pHashCount[i].store(0);
+  }
+
+  void Start() {
+    RegisterValidationInterface(this);
+    threads.create_thread([this] {
+      try {
+        Coordinator();
+      } catch (boost::thread_interrupted&) {
+        // normal stop
+      } catch (std::exception& e) { LogPrintf("ThreadBitcoinMiner() exception: %s\n", e.what()); } catch (...) {
+        LogPrintf("ThreadBitcoinMiner() exception\n");
       }
+      StopWorkers();
+      LogPrintf("ThreadBitcoinMiner exiting\n");
+    });
+    for (int i = 0; i < nWorkers; i++) {
+      threads.create_thread([this, i] {
+        try {
+          Worker(i);
+        } catch (boost::thread_interrupted&) {
+          // normal stop
+        }
+      });
     }
   }
-}
 
-void static ThreadBitcoinMiner(void* parg) {
-  boost::this_thread::interruption_point();
-  CWallet* pwallet = (CWallet*)parg;
-  try {
-    BitcoinMiner(pwallet, false);
-    boost::this_thread::interruption_point();
-  } catch (std::exception& e) { LogPrintf("ThreadBitcoinMiner() exception"); } catch (...) {
-    LogPrintf("ThreadBitcoinMiner() exception");
+  virtual ~CPowMiner() {}
+
+  void Stop() {
+    StopWorkers();
+    threads.interrupt_all();
+    threads.join_all();
+    UnregisterValidationInterface(this);
+    dHashesPerSec = 0.0;
+    std::lock_guard<std::mutex> lock(csMinerRates);
+    vMinerThreadRates.clear();
   }
+};
+
+CPowMiner* pminer = nullptr;
+//! Only held to swap pminer, never while a miner is stopped: its threads may be waiting on cs_main
+std::mutex csMiner;
 
-  LogPrintf("ThreadBitcoinMiner exiting\n");
+//! Stop and free a miner that is no longer reachable through pminer
+void StopMiner(CPowMiner* pminerOld) {
+  if (!pminerOld) return;
+  pminerOld->Stop();
+  delete pminerOld;
 }
 
-void GenerateBitcoins(bool fGenerate, CWallet* pwallet, int nThreads) {
-  static boost::thread_group* minerThreads = nullptr;
-  fGenerateBitcoins = fGenerate;
+}  // namespace
 
+std::vector<double> GetMinerThreadHashRates() {
+  std::lock_guard<std::mutex> lock(csMinerRates);
+  if (GetTimeMillis() - nHPSTimerStart > 8000) return std::vector<double>();
+  return vMinerThreadRates;
+}
+
+void GenerateBitcoins(bool fGenerate, CWallet* pwallet, int nThreads) {
   if (nThreads < 0) {
     // In regtest threads defaults to 1
     if (Params().DefaultMinerThreads())
@@ -693,14 +950,30 @@ void GenerateBitcoins(bool fGenerate, CWallet* pwallet, int nThreads) {
       nThreads = boost::thread::hardware_concurrency();
   }
 
-  if (minerThreads != nullptr) {
-    minerThreads->interrupt_all();
-    delete minerThreads;
-    minerThreads = nullptr;
+  // Joining the old threads waits for them to give up cs_main, which the caller
+  // of getmininginfo or Shutdown may hold, so that happens without csMiner
+  CPowMiner* pminerOld;
+  {
+    std::lock_guard<std::mutex> lock(csMiner);
+    fGenerateBitcoins = fGenerate;
+    pminerOld = pminer;
+    pminer = nullptr;
   }
+  StopMiner(pminerOld);
 
   if (nThreads == 0 || !fGenerate) return;
 
-  minerThreads = new boost::thread_group();
-  for (int i = 0; i < nThreads; i++) minerThreads->create_thread(std::bind(&ThreadBitcoinMiner, pwallet));
+  CPowMiner* pminerNew = new CPowMiner(pwallet, nThreads);
+  pminerNew->Start();
+  {
+    // A concurrent call may have started a miner of its own, or turned generation off, in the meantime
+    std::lock_guard<std::mutex> lock(csMiner);
+    if (fGenerateBitcoins) {
+      pminerOld = pminer;
+      pminer = pminerNew;
+    } else {
+      pminerOld = pminerNew;
+    }
+  }
+  StopMiner(pminerOld);
 }
@@ -8,7 +8,9 @@
 #ifndef BITCOIN_MINER_H
 #define BITCOIN_MINER_H
 
+#include <atomic>
 #include <stdint.h>
+#include <vector>
 
 class CBlock;
 class CBlockHeader;
@@ -19,6 +21,25 @@ class CWallet;
 
 struct CBlockTemplate;
 
+/**
+ * Tells the PoW coordinator when the parent its block template was built on is no longer the tip. Begin() clears
+ * the tip signal before reading the tip, so a tip change while the template is built is not lost.
+ */
+class CMinerTipWatch {
+ private:
+  std::atomic<bool> fTipChanged;
+
+ public:
+  CMinerTipWatch() : fTipChanged(false) {}
+
+  //! Start a new template, returns the parent to build it on
+  CBlockIndex* Begin();
+  //! Called from UpdatedBlockTip
+  void Notify() { fTipChanged = true; }
+  //! Whether a template built on pindexPrev must be rebuilt
+  bool IsStale(const CBlockIndex* pindexPrev) const;
+};
+
 /** Run the miner threads */
 void GenerateBitcoins(bool fGenerate, CWallet* pwallet, int nThreads);
 /** Generate a new block, without valid proof-of-work */
@@ -29,7 +50,10 @@ void IncrementExtraNonce(CBlock* pblock, CBlockIndex* pindexPrev, unsigned int&
 /** Check mined block */
 void UpdateTime(CBlockHeader* block, const CBlockIndex* pindexPrev);
 
+/** Run the proof-of-stake minter; proof-of-work is searched by the threads started in GenerateBitcoins */
 void BitcoinMiner(CWallet* pwallet, bool fProofOfStake);
+/** Recent hashes per second of each proof-of-work thread, empty when not generating */
+std::vector<double> GetMinerThreadHashRates();
 
 extern double dHashesPerSec;
 extern int64_t nHPSTimerStart;
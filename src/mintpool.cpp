@@ -26,7 +26,7 @@ void CMintPool::Add(const CBigNum& bnValue, const uint32_t& nCount) {
 }
 
 void CMintPool::Add(const pair<uint256, uint32_t>& pMint, bool fVerbose) {
-  insert(pMint);
+  if (insert(pMint).second) mapCountHash[pMint.second] = pMint.first;
   if (pMint.second > nCountLastGenerated) nCountLastGenerated = pMint.second;
 
   if (fVerbose)
@@ -53,6 +53,7 @@ std::list<pair<uint256, uint32_t> > CMintPool::List() {
 
 void CMintPool::Reset() {
   clear();
+  mapCountHash.clear();
   nCountLastGenerated = 0;
   nCountLastRemoved = 0;
 }
@@ -81,5 +82,7 @@ void CMintPool::Remove(const uint256& hashPubcoin) {
   if (it == end()) return;
 
   nCountLastRemoved = it->second;
+  auto itCount = mapCountHash.find(it->second);
+  if (itCount != mapCountHash.end() && itCount->second == hashPubcoin) mapCountHash.erase(itCount);
   erase(it);
 }
@@ -15,14 +15,106 @@
 #include "utilstrencodings.h"
 #include "crypto/hashargon2d.h"
 
+#include <cstring>
+#include <thread>
+
+namespace {
+thread_local uint64_t nThreadHashCount = 0;
+
+//! Holds a header's memo lock for its scope, only ever around a few copies
+class CMemoLock {
+ private:
+  std::atomic<bool>& fLocked;
+
+ public:
+  explicit CMemoLock(std::atomic<bool>& fLockedIn) : fLocked(fLockedIn) {
+    while (fLocked.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+  }
+  ~CMemoLock() { fLocked.store(false, std::memory_order_release); }
+};
+}  // namespace
+
+CBlockHeader::CBlockHeader(const CBlockHeader& other)
+    : nHeaderVersion(other.nHeaderVersion),
+      hashPrevBlock(other.hashPrevBlock),
+      hashMerkleRoot(other.hashMerkleRoot),
+      nTime(other.nTime),
+      nBits(other.nBits),
+      nNonce(other.nNonce),
+      nAccumulatorCheckpoint(other.nAccumulatorCheckpoint),
+      fHashCached(false),
+      fMemoLocked(false) {
+  CopyMemo(other);
+}
+
+CBlockHeader& CBlockHeader::operator=(const CBlockHeader& other) {
+  if (this == &other) return *this;
+  nHeaderVersion = other.nHeaderVersion;
+  hashPrevBlock = other.hashPrevBlock;
+  hashMerkleRoot = other.hashMerkleRoot;
+  nTime = other.nTime;
+  nBits = other.nBits;
+  nNonce = other.nNonce;
+  nAccumulatorCheckpoint = other.nAccumulatorCheckpoint;
+  CopyMemo(other);
+  return *this;
+}
+
+void CBlockHeader::ClearMemo() {
+  CMemoLock lock(fMemoLocked);
+  fHashCached = false;
+}
+
+void CBlockHeader::CopyMemo(const CBlockHeader& other) {
+  uint256 hash;
+  unsigned char vch[HASHED_HEADER_SIZE];
+  bool fCached;
+  {
+    CMemoLock lock(other.fMemoLocked);
+    fCached = other.fHashCached;
+    if (fCached) {
+      hash = other.hashCached;
+      memcpy(vch, other.vchHashedHeader, HASHED_HEADER_SIZE);
+    }
+  }
+  CMemoLock lock(fMemoLocked);
+  fHashCached = fCached;
+  if (fCached) {
+    hashCached = hash;
+    memcpy(vchHashedHeader, vch, HASHED_HEADER_SIZE);
+  }
+}
+
 uint256 CBlockHeader::GetHash() const {
+  static_assert(sizeof(nHeaderVersion) + sizeof(hashPrevBlock) + sizeof(hashMerkleRoot) + sizeof(nTime) +
+                        sizeof(nBits) + sizeof(nNonce) + sizeof(nAccumulatorCheckpoint) ==
+                    HASHED_HEADER_SIZE,
+                "HASHED_HEADER_SIZE does not match the header fields");
+
+  unsigned char vch[HASHED_HEADER_SIZE];
+  memcpy(vch, BEGIN(nHeaderVersion), HASHED_HEADER_SIZE);
+  {
+    CMemoLock lock(fMemoLocked);
+    if (fHashCached && memcmp(vch, vchHashedHeader, HASHED_HEADER_SIZE) == 0) return hashCached;
+  }
+
+  // Hashed outside the lock, other threads only ever wait for a copy
 #ifndef POWARGON
-  return Hash(BEGIN(nHeaderVersion), END(nAccumulatorCheckpoint));
+  uint256 hash = Hash(vch, vch + HASHED_HEADER_SIZE);
 #else
-  return HashArgon2d(BEGIN(nHeaderVersion), END(nAccumulatorCheckpoint));
+  uint256 hash = HashArgon2d(vch, vch + HASHED_HEADER_SIZE);
 #endif
+  nThreadHashCount++;
+
+  CMemoLock lock(fMemoLocked);
+  hashCached = hash;
+  memcpy(vchHashedHeader, vch, HASHED_HEADER_SIZE);
+  fHashCached = true;
+  return hash;
 }
 
+uint64_t CBlockHeader::ThreadHashCount() { return nThreadHashCount; }
+
 uint256 CBlock::BuildMerkleTree(bool* fMutated) const {
   /* WARNING! If you're reading this because you're learning about crypto
      and/or designing a new system that will use merkle trees, keep in mind
@@ -12,6 +12,8 @@
 #include "serialize.h"
 #include "uint256.h"
 
+#include <atomic>
+
 // For Now
 enum class BlockVersion : std::int32_t {
   GENESIS_BLOCK_VERSION=1
@@ -40,7 +42,20 @@ class CBlockHeader {
   uint32_t nNonce;
   uint256 nAccumulatorCheckpoint;
 
-  CBlockHeader() { SetNull(); }
+  //! Number of header bytes, from nHeaderVersion through nAccumulatorCheckpoint, that go into the hash
+  static const size_t HASHED_HEADER_SIZE = 4 + 32 + 32 + 4 + 4 + 4 + 32;
+
+  // memory only: the last computed hash and the header bytes it was computed from, so an unchanged header
+  // is only hashed once and any field mutation (nNonce, nTime, ...) is picked up on the next GetHash()
+  mutable uint256 hashCached;
+  mutable unsigned char vchHashedHeader[HASHED_HEADER_SIZE];
+  mutable bool fHashCached;
+  //! Spin lock over the memo, so that a const header shared between threads can be hashed by all of them
+  mutable std::atomic<bool> fMemoLocked;
+
+  CBlockHeader() : fMemoLocked(false) { SetNull(); }
+  CBlockHeader(const CBlockHeader& other);
+  CBlockHeader& operator=(const CBlockHeader& other);
 
   ADD_SERIALIZE_METHODS
 
@@ -64,12 +79,21 @@ class CBlockHeader {
     nBits = 0;
     nNonce = 0;
     nAccumulatorCheckpoint.SetNull();
+    ClearMemo();
   }
 
   bool IsNull() const { return (nBits == 0); }
 
   uint256 GetHash() const;
 
+  //! Number of header hashes computed (cache misses in GetHash) by the calling thread
+  static uint64_t ThreadHashCount();
+
+ private:
+  void ClearMemo();
+  //! Copy the memo of other, which may be hashed on another thread meanwhile
+  void CopyMemo(const CBlockHeader& other);
+
   int64_t GetBlockTime() const { return (int64_t)nTime; }
 };
 
@@ -109,17 +133,8 @@ class CBlock : public CBlockHeader {
     vchBlockSig.clear();
   }
 
-  CBlockHeader GetBlockHeader() const {
-    CBlockHeader block;
-    block.nHeaderVersion = nHeaderVersion;
-    block.hashPrevBlock = hashPrevBlock;
-    block.hashMerkleRoot = hashMerkleRoot;
-    block.nTime = nTime;
-    block.nBits = nBits;
-    block.nNonce = nNonce;
-    block.nAccumulatorCheckpoint = nAccumulatorCheckpoint;
-    return block;
-  }
+  // Copies the cached hash along with the header fields
+  CBlockHeader GetBlockHeader() const { return *this; }
 
   // ppcoin: two types of block: proof-of-work or proof-of-stake
   bool IsProofOfStake() const { return (vtx.size() > 1 && vtx[1].IsCoinStake()); }
@@ -12,6 +12,7 @@
 #include "clientversion.h"
 #include "main.h"
 #include "rpc/server.h"
+#include "script/sigcache.h"
 #include "sync.h"
 #include "txdb.h"
 #include "util.h"
@@ -755,6 +756,15 @@ UniValue mempoolInfoToJSON() {
   ret.push_back(Pair("bytes", (int64_t)mempool.GetTotalTxSize()));
   // ret.push_back(Pair("usage", (int64_t) mempool.DynamicMemoryUsage()));
 
+  CSignatureCacheStats sigstats;
+  GetSignatureCacheStats(sigstats);
+  UniValue sigcache(UniValue::VOBJ);
+  sigcache.push_back(Pair("hits", (uint64_t)sigstats.nHits));
+  sigcache.push_back(Pair("misses", (uint64_t)sigstats.nMisses));
+  sigcache.push_back(Pair("capacity", (int64_t)sigstats.nCapacity));
+  sigcache.push_back(Pair("bytes", (int64_t)sigstats.nBytes));
+  ret.push_back(Pair("sigcache", sigcache));
+
   return ret;
 }
 
@@ -768,6 +778,12 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp) {
         "{\n"
         "  \"size\": xxxxx                (numeric) Current tx count\n"
         "  \"bytes\": xxxxx               (numeric) Sum of all tx sizes\n"
+        "  \"sigcache\": {                (json object) Signature cache shared by mempool and block validation\n"
+        "    \"hits\": xxxxx              (numeric) Lookups answered from the cache\n"
+        "    \"misses\": xxxxx            (numeric) Lookups that needed a full signature check\n"
+        "    \"capacity\": xxxxx          (numeric) Number of entries the cache can hold\n"
+        "    \"bytes\": xxxxx             (numeric) Memory reserved for the cache\n"
+        "  }\n"
         "}\n"
 
         "\nExamples:\n" +
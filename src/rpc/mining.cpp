@@ -217,6 +217,7 @@ UniValue getmininginfo(const UniValue& params, bool fHelp) {
         "  \"genproclimit\": n          (numeric) The processor limit for generation. -1 if no generation. (see "
         "getgenerate or setgenerate calls)\n"
         "  \"hashespersec\": n          (numeric) The hashes per second of the generation, or 0 if no generation.\n"
+        "  \"threadhashespersec\": [n,...] (array) The hashes per second of each generation thread\n"
         "  \"pooledtx\": n              (numeric) The size of the mem pool\n"
         "  \"testnet\": true|false      (boolean) If using testnet or not\n"
         "  \"chain\": \"xxxx\",         (string) current network name as defined in BIP70 (main, test, regtest)\n"
@@ -241,6 +242,9 @@ UniValue getmininginfo(const UniValue& params, bool fHelp) {
   if (!fDisableWallet) {
     obj.push_back(Pair("generate", getgenerate(params, false)));
     obj.push_back(Pair("hashespersec", gethashespersec(params, false)));
+    UniValue threadRates(UniValue::VARR);
+    for (double dRate : GetMinerThreadHashRates()) threadRates.push_back((int64_t)dRate);
+    obj.push_back(Pair("threadhashespersec", threadRates));
   }
   return obj;
 }
@@ -3007,7 +3007,7 @@ UniValue setMasterHDseed(const UniValue& params, bool fHelp) {
     CZeroWallet* zwallet = pwalletMain->getZWallet();
     fSuccess |= zwallet->SetMasterSeed(seed, true);
     zwallet->SetMasterSeed(seed, true);
-    zwallet->GenerateZMintPool();
+    if (!zwallet->GenerateZMintPool()) fSuccess = false;
     zwallet->SyncWithChain();
   }
 
@@ -3110,33 +3110,13 @@ UniValue dzkpstate(const UniValue& params, bool fHelp) {
   return obj;
 }
 
-void static SearchThread(CZeroWallet* zwallet, int nCountStart, int nCountEnd) {
-  LogPrintf("%s: start=%d end=%d\n", __func__, nCountStart, nCountEnd);
-  try {
-    uint256 seedMaster = zwallet->GetMasterSeed();
-    uint256 hashSeed = Hash(seedMaster.begin(), seedMaster.end());
-    for (int i = nCountStart; i < nCountEnd; i++) {
-      boost::this_thread::interruption_point();
-      CDataStream ss(SER_GETHASH);
-      ss << seedMaster << i;
-      uint512 zerocoinSeed = Hash512(ss.begin(), ss.end());
-
-      libzerocoin::PrivateCoin MintedCoin(libzerocoin::gpZerocoinParams);
-      CBigNum bnValue = MintedCoin.CoinFromSeed(zerocoinSeed);
-
-      uint256 hashPubcoin = GetPubCoinHash(bnValue);
-      zwallet->AddToMintPool(make_pair(hashPubcoin, i), true);
-      gWalletDB.WriteMintPoolPair(hashSeed, hashPubcoin, i);
-    }
-  } catch (std::exception& e) { LogPrintf("SearchThread() exception"); } catch (...) {
-    LogPrintf("SearchThread() exception");
-  }
-}
+//! Mints derived and saved to the mint pool per step of searchdzkp
+static const int SEARCH_WRITE_BATCH = 1000;
 
 UniValue searchdzkp(const UniValue& params, bool fHelp) {
-  if (fHelp || params.size() != 3)
+  if (fHelp || params.size() < 2 || params.size() > 3)
     throw runtime_error(
-        "searchdzkp\n"
+        "searchdzkp count range ( threads )\n"
         "\nMake an extended search for deterministically generated ZKP that have not yet been recognized by the "
         "wallet.\n" +
         HelpRequiringPassphrase() +
@@ -3145,10 +3125,11 @@ UniValue searchdzkp(const UniValue& params, bool fHelp) {
         "\nArguments\n"
         "1. \"count\"       (numeric) Which sequential ZKP to start with.\n"
         "2. \"range\"       (numeric) How many ZKP to generate.\n"
-        "3. \"threads\"     (numeric) How many threads should this operation consume.\n"
+        "3. \"threads\"     (numeric, optional) Deprecated and ignored, mints are derived on the -zkpthreads\n"
+        "                   worker threads.\n"
 
         "\nExamples\n" +
-        HelpExampleCli("searchdzkp", "1, 100, 2") + HelpExampleRpc("searchdzkp", "1, 100, 2"));
+        HelpExampleCli("searchdzkp", "1, 100") + HelpExampleRpc("searchdzkp", "1, 100"));
 
   EnsureWalletIsUnlocked();
 
@@ -3158,24 +3139,14 @@ UniValue searchdzkp(const UniValue& params, bool fHelp) {
   int nRange = params[1].get_int();
   if (nRange < 1) throw JSONRPCError(RPC_INVALID_PARAMETER, "Range has to be at least 1");
 
-  int nThreads = params[2].get_int();
-
   CZeroWallet* zwallet = pwalletMain->zwalletMain;
 
-  boost::thread_group* dzkpThreads = new boost::thread_group();
-  int nRangePerThread = nRange / nThreads;
-
-  int nPrevThreadEnd = nCount - 1;
-  for (int i = 0; i < nThreads; i++) {
-    int nStart = nPrevThreadEnd + 1;
-    ;
-    int nEnd = nStart + nRangePerThread;
-    nPrevThreadEnd = nEnd;
-    dzkpThreads->create_thread(boost::bind(&SearchThread, zwallet, nStart, nEnd));
+  // Each step is written to the wallet before the next one starts
+  for (int nStart = nCount; nStart < nCount + nRange && !ShutdownRequested(); nStart += SEARCH_WRITE_BATCH) {
+    if (!zwallet->GenerateZMintPool(nStart, std::min(SEARCH_WRITE_BATCH, nCount + nRange - nStart)))
+      throw JSONRPCError(RPC_WALLET_ERROR, "Failed to write the mint pool to the wallet");
   }
 
-  dzkpThreads->join_all();
-
   zwallet->RemoveMintsFromPool(pwalletMain->zkpTracker->GetSerialHashes());
   zwallet->SyncWithChain(false);
 
@@ -0,0 +1,79 @@
+// Copyright (c) 2018 The TessaChain developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+/**
+ * Set of already-validated entries keyed by a salted SHA256, shared by the
+ * signature and zerocoin spend caches. Subclasses hash their own fields into
+ * Hasher() to build entries. Lookups take a shared lock, writes a unique one.
+ */
+class CSaltedCuckooCache {
+ private:
+  //! SHA256 state seeded with a per-process random salt, so peers cannot aim for colliding entries
+  CSHA256 salted_hasher;
+  cuckoocache<uint256, uint256_word_hasher> setValid;
+  mutable boost::shared_mutex cs_cache;
+  std::atomic<uint64_t> nHits;
+  std::atomic<uint64_t> nMisses;
+
+ public:
+  CSaltedCuckooCache() : nHits(0), nMisses(0) {
+    uint256 nonce = GetRandHash();
+    salted_hasher.Write(nonce.begin(), 32);
+    salted_hasher.Write(nonce.begin(), 32);
+  }
+
+  //! Copy of the salted state to write an entry's fields into
+  CSHA256 Hasher() const { return salted_hasher; }
+
+  //! Look the entry up; with fErase a hit is also released for reuse
+  bool Get(const uint256& entry, bool fErase) {
+    boost::shared_lock<boost::shared_mutex> lock(cs_cache);
+    bool fHit = setValid.contains(entry, fErase);
+    ++(fHit ? nHits : nMisses);
+    return fHit;
+  }
+
+  void Set(const uint256& entry) {
+    boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+    setValid.insert(entry);
+  }
+
+  //! Size the table for nElems entries, dropping the current contents
+  uint32_t Setup(uint32_t nElems) {
+    boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+    return setValid.setup(nElems);
+  }
+
+  //! Size the table to fit in nBytes, dropping the current contents
+  uint32_t SetupBytes(size_t nBytes) {
+    boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+    return setValid.setup_bytes(nBytes);
+  }
+
+  void Clear() {
+    boost::unique_lock<boost::shared_mutex> lock(cs_cache);
+    setValid.clear();
+  }
+
+  uint32_t Capacity() const {
+    boost::shared_lock<boost::shared_mutex> lock(cs_cache);
+    return setValid.capacity();
+  }
+
+  uint64_t Hits() const { return nHits; }
+  uint64_t Misses() const { return nMisses; }
+};
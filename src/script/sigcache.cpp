@@ -6,12 +6,10 @@
 #include "sigcache.h"
 
 #include "ecdsa/pubkey.h"
-#include "random.h"
+#include "saltedcuckoocache.h"
 #include "uint256.h"
 #include "util.h"
 
-#include <boost/thread.hpp>
-
 namespace {
 
 /**
@@ -19,47 +17,50 @@ namespace {
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
  */
-class CSignatureCache {
- private:
-  //! sigdata_type is (signature hash, signature, public key):
-  typedef std::tuple<uint256, std::vector<uint8_t>, ecdsa::CPubKey> sigdata_type;
-  std::set<sigdata_type> setValid;
-  boost::shared_mutex cs_sigcache;
-
+class CSignatureCache : public CSaltedCuckooCache {
  public:
-  bool Get(const uint256& hash, const std::vector<uint8_t>& vchSig, const ecdsa::CPubKey& pubKey) {
-    boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-
-    sigdata_type k(hash, vchSig, pubKey);
-    std::set<sigdata_type>::iterator mi = setValid.find(k);
-    if (mi != setValid.end()) return true;
-    return false;
+  //! Key for (signature hash, signature, public key)
+  uint256 ComputeEntry(const uint256& hash, const std::vector<uint8_t>& vchSig, const ecdsa::CPubKey& pubKey) const {
+    uint256 entry;
+    Hasher()
+        .Write(hash.begin(), 32)
+        .Write(pubKey.begin(), pubKey.size())
+        .Write(vchSig.data(), vchSig.size())
+        .Finalize(entry.begin());
+    return entry;
   }
 
-  void Set(const uint256& hash, const std::vector<uint8_t>& vchSig, const ecdsa::CPubKey& pubKey) {
-    // DoS prevention: limit cache size to less than 10MB
-    // (~200 bytes per cache entry times 50,000 entries)
-    // Since there are a maximum of 20,000 signature operations per block
-    // 50,000 is a reasonable default.
-    int64_t nMaxCacheSize = GetArg("-maxsigcachesize", 50000);
-    if (nMaxCacheSize <= 0) return;
-
-    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-    sigdata_type k(hash, vchSig, pubKey);
-    setValid.insert(k);
+  void GetStats(CSignatureCacheStats& stats) const {
+    stats.nHits = Hits();
+    stats.nMisses = Misses();
+    stats.nCapacity = Capacity();
+    stats.nBytes = (size_t)stats.nCapacity * sizeof(uint256);
   }
 };
 
+CSignatureCache signatureCache;
+
 }  // namespace
 
+void InitSignatureCache() {
+  int64_t nMaxCacheSize = std::min(std::max(GetArg("-sigcachemaxsize", DEFAULT_MAX_SIG_CACHE_SIZE), (int64_t)0),
+                                   MAX_MAX_SIG_CACHE_SIZE);
+  uint32_t nElems = signatureCache.SetupBytes((size_t)nMaxCacheSize << 20);
+  LogPrintf("Using %u MiB for signature cache, able to store %u elements\n",
+            (unsigned)((nElems * sizeof(uint256)) >> 20), nElems);
+}
+
+void GetSignatureCacheStats(CSignatureCacheStats& stats) { signatureCache.GetStats(stats); }
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<uint8_t>& vchSig, const ecdsa::CPubKey& pubkey,
                                                          const uint256& sighash) const {
-  static CSignatureCache signatureCache;
+  uint256 entry = signatureCache.ComputeEntry(sighash, vchSig, pubkey);
 
-  if (signatureCache.Get(sighash, vchSig, pubkey)) return true;
+  // Block validation does not store; a signature seen there will not be checked again, so free its slot
+  if (signatureCache.Get(entry, !store)) return true;
 
   if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash)) return false;
 
-  if (store) signatureCache.Set(sighash, vchSig, pubkey);
+  if (store) signatureCache.Set(entry);
   return true;
 }
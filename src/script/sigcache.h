@@ -8,8 +8,20 @@
 #include "script/interpreter.h"
 #include "ecdsa/key.h"
 
+#include <cstdint>
 #include <vector>
 
+//! -sigcachemaxsize default (MiB)
+static const int64_t DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+//! max. -sigcachemaxsize (MiB)
+static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+
+struct CSignatureCacheStats {
+  uint64_t nHits;
+  uint64_t nMisses;
+  uint32_t nCapacity;
+  size_t nBytes;
+};
 
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker {
  private:
@@ -22,3 +34,6 @@ class CachingTransactionSignatureChecker : public TransactionSignatureChecker {
   bool VerifySignature(const std::vector<uint8_t>& vchSig, const ecdsa::CPubKey& vchPubKey, const uint256& sighash) const;
 };
 
+//! Size the signature cache from -sigcachemaxsize
+void InitSignatureCache();
+void GetSignatureCacheStats(CSignatureCacheStats& stats);
@@ -20,12 +20,22 @@
 #include <exception>
 #include <cstdlib>
 #include <sys/time.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "random.h"
+#include "rand_bignum.h"
 #include "streams.h"
-#include "libzerocoin/ParamGeneration.h"
-#include "libzerocoin/Denominations.h"
-#include "libzerocoin/Coin.h"
-#include "libzerocoin/CoinSpend.h"
+#include "uint512.h"
+#include "utiltime.h"
+#include "version.h"
 #include "libzerocoin/Accumulator.h"
+#include "libzerocoin/AccumulatorWitness.h"
+#include "libzerocoin/BatchVerifier.h"
+#include "libzerocoin/CoinSpend.h"
+#include "libzerocoin/Denominations.h"
+#include "libzerocoin/MultiExp.h"
+#include "libzerocoin/PrivateCoin.h"
 
 using namespace std;
 using namespace libzerocoin;
@@ -115,8 +125,8 @@ gGetTestModulus()
 	// TODO: should use a hard-coded RSA modulus for testing
 	if (!testModulus) {
 		CBigNum p, q;
-		p = CBigNum::generatePrime(1024, false);
-		q = CBigNum::generatePrime(1024, false);
+		p = generatePrime(1024, false);
+		q = generatePrime(1024, false);
 		testModulus = p * q;
 	}
 
@@ -181,30 +191,18 @@ Testb_CalcParamSizes()
 bool
 Testb_GenerateGroupParams()
 {
-	uint32_t pLen = 1024, qLen = 256, count;
-	IntegerGroupParams group;
-
-	for (count = 0; count < 1; count++) {
-
-		try {
-			group = deriveIntegerGroupParams(calculateSeed(gGetTestModulus(), "test", ZEROCOIN_DEFAULT_SECURITYLEVEL, "TEST GROUP"), pLen, qLen);
-		} catch (std::runtime_error e) {
-			cout << "Caught exception " << e.what() << endl;
-			return false;
-		}
+	// The groups are fixed in ZerocoinParams now, ParamGeneration.cpp is not built
+	const IntegerGroupParams* groups[] = {&gg_Params->coinCommitmentGroup, &gg_Params->accumulatorParams.accumulatorPoKCommitmentGroup};
 
-		// Now perform some simple tests on the resulting parameters
-		if ((uint32_t)group.groupOrder.bitSize() < qLen || (uint32_t)group.modulus.bitSize() < pLen) {
+	for (const IntegerGroupParams* group : groups) {
+		// Now perform some simple tests on the parameters
+		if (!group->g || !group->h || !group->modulus || !group->groupOrder) {
 			return false;
 		}
 
-		CBigNum c = group.g.pow_mod(group.groupOrder, group.modulus);
+		CBigNum c = group->g.pow_mod(group->groupOrder, group->modulus);
 		//cout << "g^q mod p = " << c << endl;
 		if (!(c.isOne())) return false;
-
-		// Try at multiple parameter sizes
-		pLen = pLen * 1.5;
-		qLen = qLen * 1.5;
 	}
 
 	return true;
@@ -217,8 +215,8 @@ Testb_ParamGen()
 
 	try {
 		timer.start();
-		// Instantiating testParams runs the parameter generation code
-		ZerocoinParams testParams(gGetTestModulus(),ZEROCOIN_DEFAULT_SECURITYLEVEL);
+		// Instantiating testParams sets up the fixed groups
+		ZerocoinParams testParams(ZEROCOIN_DEFAULT_SECURITYLEVEL);
 		timer.stop();
 
 		cout << "\tPARAMGEN ELAPSED TIME: " << timer.duration() << " ms\t" << timer.duration()*0.001 << " s" << endl;
@@ -288,7 +286,11 @@ Testb_MintCoin()
 		// Generate a list of coins
 		timer.start();
 		for (uint32_t i = 0; i < TESTS_COINS_TO_ACCUMULATE; i++) {
-            ggCoins[i] = new PrivateCoin(gg_Params,CoinDenomination::ZQ_ONE);
+            // The wallet's deterministic mint, from a random seed
+            uint512 seed;
+            GetRandBytes(seed.begin(), seed.size());
+            ggCoins[i] = new PrivateCoin(gg_Params);
+            ggCoins[i]->CoinFromSeed(seed);
 		}
 		timer.stop();
 	} catch (exception &e) {
@@ -338,7 +340,7 @@ Testb_MintAndSpend()
 
 		// Now spend the coin
 		timer.start();
-		CoinSpend spend(gg_Params, gg_Params, *(ggCoins[0]), acc, 0, wAcc, 0, SpendType::SPEND); //(0) presstab
+		CoinSpend spend(gg_Params, *(ggCoins[0]), acc, 0, wAcc, uint256());
 		timer.stop();
 
 		cout << "\tSPEND ELAPSED TIME: " << timer.duration() << " ms\t" << timer.duration()*0.001 << " s" << endl;
@@ -350,7 +352,7 @@ Testb_MintAndSpend()
 		ss << spend;
 		timer.stop();
 
-		CoinSpend newSpend(gg_Params, gg_Params, ss);
+		CoinSpend newSpend(gg_Params, ss);
 
 		cout << "\tSERIALIZE ELAPSED TIME: " << timer.duration() << " ms\t" << timer.duration()*0.001 << " s" << endl;
 
@@ -373,8 +375,8 @@ Testb_MintAndSpend()
 void
 Testb_RunAllTests()
 {
-	// Make a new set of parameters from a random RSA modulus
-	gg_Params = new ZerocoinParams(gGetTestModulus());
+	// The parameters are fixed, only the test modulus is random
+	gg_Params = new ZerocoinParams();
 
 	ggNumTests = ggSuccessfulTests = 0;
 	for (uint32_t i = 0; i < TESTS_COINS_TO_ACCUMULATE; i++) {
@@ -384,7 +386,7 @@ Testb_RunAllTests()
 	// Run through all of the Zerocoin tests
 	gLogTestResult("an RSA modulus can be generated", Testb_GenRSAModulus);
 	gLogTestResult("parameter sizes are correct", Testb_CalcParamSizes);
-	gLogTestResult("group/field parameters can be generated", Testb_GenerateGroupParams);
+	gLogTestResult("group/field parameters are consistent", Testb_GenerateGroupParams);
 	gLogTestResult("parameter generation is correct", Testb_ParamGen);
 	gLogTestResult("coins can be minted", Testb_MintCoin);
 	gLogTestResult("the accumulator works", Testb_Accumulator);
@@ -403,13 +405,165 @@ Testb_RunAllTests()
 	cout << ggSuccessfulTests << " out of " << ggNumTests << " tests passed." << endl << endl;
 	delete gg_Params;
 }
+
+namespace {
+
+const size_t DISTINCT_SPENDS = 4;
+
+//! Uniform below range, randBignum() only bounds the byte length
+CBigNum RandBelow(const CBigNum& range) { return randBignum(range) % range; }
+
+const ZerocoinParams& GetParams() {
+  static const ZerocoinParams params;
+  return params;
+}
+
+//! Milliseconds since nStart, from GetTimeMicros()
+double ElapsedMs(int64_t nStart) { return (GetTimeMicros() - nStart) * 0.001; }
+
+//! A few spends against one accumulator, for the benchmarks to repeat
+struct SpendSetup {
+  Accumulator acc;
+  std::vector<std::unique_ptr<CoinSpend> > vSpends;
+
+  explicit SpendSetup(const ZerocoinParams* params, size_t nSpends) : acc(params, CoinDenomination::ZQ_ONE) {
+    const CBigNum& bnOrder = params->coinCommitmentGroup.groupOrder;
+    std::vector<PrivateCoin> vCoins;
+    while (vCoins.size() < nSpends) {
+      // The spend signs with the key the serial comes from
+      ecdsa::CKey key;
+      CBigNum bnSerial;
+      GenerateKeyPair(bnOrder, uint256(), key, bnSerial);
+      PrivateCoin coin(params, CoinDenomination::ZQ_ONE, bnSerial, RandBelow(bnOrder));
+      coin.setPrivKey(key.GetPrivKey());
+      if (coin.getPublicCoin().validate()) vCoins.push_back(coin);
+    }
+    for (const PrivateCoin& coin : vCoins) acc += coin.getPublicCoin();
+    for (size_t i = 0; i < vCoins.size(); i++) {
+      AccumulatorWitness witness(params, Accumulator(params, CoinDenomination::ZQ_ONE), vCoins[i].getPublicCoin());
+      for (size_t j = 0; j < vCoins.size(); j++)
+        if (j != i) witness += vCoins[j].getPublicCoin();
+      vSpends.emplace_back(new CoinSpend(params, vCoins[i], acc, 0, witness, uint256()));
+    }
+  }
+};
+
+}  // namespace
+
 BOOST_AUTO_TEST_SUITE(benchmark_zerocoin)
 
 BOOST_AUTO_TEST_CASE(benchmark_test)
 {
-	cout << "libzerocoin v" << ZEROCOIN_VERSION_STRING << " benchmark utility." << endl << endl;
+	cout << "libzerocoin benchmark utility." << endl << endl;
 
 	Testb_RunAllTests();
 }
+
+BOOST_AUTO_TEST_CASE(multi_exp) {
+  // prod(b_i^e_i) mod N with one pow_mod per factor versus one multi-exponentiation
+  const CBigNum& m = GetParams().accumulatorParams.accumulatorModulus;
+  std::cout << "multi-exponentiation mod the accumulator modulus" << std::endl;
+  for (unsigned int nBits : {128, 1024, 3072}) {
+    for (unsigned int nBases : {2, 4, 16, 64, 256}) {
+      std::vector<CBigNum> vBases, vExps;
+      for (unsigned int i = 0; i < nBases; i++) {
+        vBases.push_back(RandBelow(m));
+        vExps.push_back(RandBelow(CBigNum(2).pow(nBits)));
+      }
+      const unsigned int nRuns = std::max(1u, 512 / nBases);
+
+      CBigNum bnSingle;
+      int64_t nStart = GetTimeMicros();
+      for (unsigned int r = 0; r < nRuns; r++) {
+        bnSingle = CBigNum(1);
+        for (unsigned int i = 0; i < nBases; i++) bnSingle = bnSingle.mul_mod(vBases[i].pow_mod(vExps[i], m), m);
+      }
+      double nSingle = ElapsedMs(nStart) / nRuns;
+
+      CBigNum bnMulti;
+      nStart = GetTimeMicros();
+      for (unsigned int r = 0; r < nRuns; r++) bnMulti = MultiPowMod(vBases, vExps, m);
+      double nMulti = ElapsedMs(nStart) / nRuns;
+
+      std::cout << "  " << nBases << " bases, " << nBits << "-bit exponents: per factor " << nSingle
+                << " ms, multi-exp " << nMulti << " ms" << std::endl;
+      BOOST_CHECK(bnSingle == bnMulti);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(batch_verify) {
+  const ZerocoinParams* params = &GetParams();
+  SpendSetup setup(params, DISTINCT_SPENDS);
+
+  // The distinct spends repeated to fill each batch
+  std::cout << "spend verification" << std::endl;
+  for (size_t nBatch : {1, 8, 64, 256}) {
+    bool fSingle = true;
+    int64_t nStart = GetTimeMicros();
+    for (size_t i = 0; i < nBatch; i++) fSingle = setup.vSpends[i % DISTINCT_SPENDS]->Verify(setup.acc) && fSingle;
+    double nSingle = ElapsedMs(nStart);
+
+    BatchVerifier batch(params);
+    for (size_t i = 0; i < nBatch; i++) batch.Add(*setup.vSpends[i % DISTINCT_SPENDS], setup.acc);
+    nStart = GetTimeMicros();
+    bool fBatch = batch.Verify();
+    double nBatched = ElapsedMs(nStart);
+
+    std::cout << "  " << nBatch << " spends: one by one " << nBatch * 1000.0 / nSingle << " proofs/s, BatchVerifier "
+              << nBatch * 1000.0 / nBatched << " proofs/s" << std::endl;
+    BOOST_CHECK(fSingle && fBatch);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(batch_accumulate) {
+  // Values the size of a pubcoin, one exponentiation each versus one per ACCUMULATOR_BATCH_MAX values
+  const ZerocoinParams* params = &GetParams();
+  const CBigNum& bnMaxCoin = params->accumulatorParams.maxCoinValue;
+  std::cout << "accumulation" << std::endl;
+  for (size_t nCount : {8, 64, 256}) {
+    std::vector<CBigNum> vValues;
+    for (size_t i = 0; i < nCount; i++) vValues.push_back(RandBelow(bnMaxCoin));
+
+    Accumulator accSingle(params, CoinDenomination::ZQ_ONE);
+    int64_t nStart = GetTimeMicros();
+    for (const CBigNum& bnValue : vValues) accSingle.increment(bnValue);
+    double nSingle = ElapsedMs(nStart);
+
+    Accumulator accBatch(params, CoinDenomination::ZQ_ONE);
+    nStart = GetTimeMicros();
+    accBatch.increment(vValues);
+    double nBatched = ElapsedMs(nStart);
+
+    std::cout << "  " << nCount << " values: one by one " << nSingle << " ms, batched " << nBatched << " ms"
+              << std::endl;
+    BOOST_CHECK(accSingle.getValue() == accBatch.getValue());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bignum_allocations) {
+  SpendSetup setup(&GetParams(), 2);
+  const CoinSpend& spend = *setup.vSpends[0];
+
+  // GMP allocations per CoinSpend::Verify(), straight from malloc and through the per-thread pool
+  const unsigned int nRuns = 10;
+  std::cout << "GMP allocations per spend verification" << std::endl;
+  for (bool fPool : {false, true}) {
+    SetBignumPooling(fPool);
+    BOOST_CHECK(spend.Verify(setup.acc));
+    SetBignumPooling(fPool);
+    bool fVerified = true;
+    int64_t nStart = GetTimeMicros();
+    for (unsigned int i = 0; i < nRuns; i++) fVerified = spend.Verify(setup.acc) && fVerified;
+    double nElapsed = ElapsedMs(nStart) / nRuns;
+    uint64_t nAllocs, nMallocs;
+    GetBignumAllocStats(nAllocs, nMallocs);
+    std::cout << "  " << (fPool ? "pooled: " : "malloc: ") << nAllocs / nRuns << " allocations, " << nMallocs / nRuns
+              << " from malloc, " << nElapsed << " ms per verify" << std::endl;
+    BOOST_CHECK(fVerified);
+  }
+  SetBignumPooling(false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -3,7 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "coins.h"
+#include "primitives/block.h"
 #include "random.h"
+#include "test/test_tessa.h"
+#include "txmempool.h"
 #include "uint256.h"
 
 #include <vector>
@@ -112,7 +115,7 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
                 } else {
                     updated_an_entry = true;
                 }
-                coins.nVersion = insecure_rand();
+                coins.nTransactionVersion = insecure_rand();
                 coins.vout.resize(1);
                 coins.vout[0].nValue = insecure_rand();
                 *entry = coins;
@@ -175,4 +178,96 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(missed_an_entry);
 }
 
+BOOST_AUTO_TEST_CASE(coins_prefetch_inputs_test)
+{
+    CCoinsViewTest base;
+    uint256 txidA = GetRandHash(), txidB = GetRandHash();
+    {
+        CCoinsViewCache setup(&base);
+        {
+            CCoinsModifier a = setup.ModifyCoins(txidA);
+            a->vout.resize(1);
+            a->vout[0].nValue = 1;
+        }
+        {
+            CCoinsModifier b = setup.ModifyCoins(txidB);
+            b->vout.resize(1);
+            b->vout[0].nValue = 2;
+        }
+        BOOST_CHECK(setup.Flush());
+    }
+
+    // tx1 spends A and B, tx2 spends tx1 within the same block
+    CMutableTransaction tx1, tx2;
+    tx1.vin.resize(2);
+    tx1.vin[0].prevout = COutPoint(txidA, 0);
+    tx1.vin[1].prevout = COutPoint(txidB, 0);
+    tx1.vout.resize(1);
+    tx2.vin.resize(1);
+    tx2.vin[0].prevout = COutPoint(CTransaction(tx1).GetHash(), 0);
+    tx2.vout.resize(1);
+    CBlock block;
+    block.vtx.push_back(CTransaction(tx1));
+    block.vtx.push_back(CTransaction(tx2));
+
+    CCoinsViewCache cache(&base);
+    BOOST_CHECK_EQUAL(cache.PrefetchInputs(block), 2U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 2U);
+    BOOST_CHECK(cache.HaveInputs(block.vtx[0]));
+    // Already cached entries are not fetched again
+    BOOST_CHECK_EQUAL(cache.PrefetchInputs(block), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(coins_mempool_view_many_test)
+{
+    CMutableTransaction txMempool;
+    txMempool.vin.resize(1);
+    txMempool.vin[0].prevout = COutPoint(GetRandHash(), 0);
+    txMempool.vout.resize(1);
+    txMempool.vout[0].nValue = 3;
+    const uint256 txidMempool = CTransaction(txMempool).GetHash();
+
+    // The base has A, plus an older entry under the mempool txid that the mempool one must shadow
+    CCoinsViewTest base;
+    uint256 txidA = GetRandHash();
+    {
+        CCoinsViewCache setup(&base);
+        {
+            CCoinsModifier a = setup.ModifyCoins(txidA);
+            a->vout.resize(1);
+            a->vout[0].nValue = 1;
+        }
+        {
+            CCoinsModifier m = setup.ModifyCoins(txidMempool);
+            m->vout.resize(2);
+            m->vout[1].nValue = 4;
+            m->nHeight = 1;
+        }
+        BOOST_CHECK(setup.Flush());
+    }
+
+    CTxMemPool pool(CFeeRate(0));
+    pool.addUnchecked(txidMempool, CTxMemPoolEntry(txMempool, 0, 0, 0.0, 1));
+    CCoinsViewMemPool view(&base, pool);
+
+    std::vector<uint256> vTxid;
+    vTxid.push_back(txidA);
+    vTxid.push_back(txidMempool);
+    vTxid.push_back(GetRandHash());
+    std::vector<CCoins> vCoins;
+    std::vector<bool> vFound;
+    view.GetCoinsMany(vTxid, vCoins, vFound);
+    BOOST_CHECK_EQUAL(vCoins.size(), vTxid.size());
+    BOOST_CHECK_EQUAL(vFound.size(), vTxid.size());
+    BOOST_CHECK(vFound[0] && vFound[1] && !vFound[2]);
+    BOOST_CHECK_EQUAL(vCoins[1].nHeight, MEMPOOL_HEIGHT);
+
+    // The batch agrees with one GetCoins call per txid
+    for (size_t i = 0; i < vTxid.size(); i++) {
+        CCoins coins;
+        BOOST_CHECK_EQUAL(view.GetCoins(vTxid[i], coins), vFound[i]);
+        if (vFound[i]) BOOST_CHECK(coins == vCoins[i]);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
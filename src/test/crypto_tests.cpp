@@ -9,7 +9,9 @@
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/hashargon2d.h"
 #include "random.h"
+#include "test/test_tessa.h"
 #include "utilstrencodings.h"
 
 #include <vector>
@@ -282,4 +284,21 @@ BOOST_AUTO_TEST_CASE(rfc6979_hmac_sha256)
             ("7597887cbd76321f32e30440679a22cf7f8d9d2eac390e581fea091ce202ba94"));
 }
 
+BOOST_AUTO_TEST_CASE(argon2d_context_reuse)
+{
+    // The reusable context must match a one-shot argon2d_hash_raw with the same parameters, call after call
+    CArgon2dContext context;
+    for (int i = 0; i < 4; i++) {
+        std::vector<unsigned char> data(80 + i * 17);
+        GetRandBytes(&data[0], data.size());
+
+        uint256 expected;
+        BOOST_CHECK_EQUAL(argon2d_hash_raw(CArgon2dContext::T_COST, CArgon2dContext::M_COST,
+                                           CArgon2dContext::PARALLELISM, &data[0], data.size(), &data[0],
+                                           data.size(), expected.begin(), expected.size()), ARGON2_OK);
+        BOOST_CHECK(context.Hash(&data[0], data.size()) == expected);
+        BOOST_CHECK(HashArgon2d(data.begin(), data.end()) == expected);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+// Copyright (c) 2018 The TessaChain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "cuckoocache.h"
+#include "random.h"
+#include "uint256.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(cuckoocache_tests)
+
+BOOST_AUTO_TEST_CASE(cuckoocache_insert_contains) {
+  cuckoocache<uint256, uint256_word_hasher> cache;
+  BOOST_CHECK_EQUAL(cache.setup(1024), 1024U);
+
+  std::vector<uint256> vHashes;
+  for (int i = 0; i < 512; i++) vHashes.push_back(GetRandHash());
+  for (const uint256& hash : vHashes) cache.insert(hash);
+
+  int nFound = 0;
+  for (const uint256& hash : vHashes) nFound += cache.contains(hash, false);
+  // Half full: nothing should have been dropped
+  BOOST_CHECK_EQUAL(nFound, 512);
+  BOOST_CHECK(!cache.contains(GetRandHash(), false));
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_bounded) {
+  cuckoocache<uint256, uint256_word_hasher> cache;
+  cache.setup_bytes(1024 * sizeof(uint256));
+  BOOST_CHECK_EQUAL(cache.capacity(), 1024U);
+
+  // Writing four times the capacity evicts, but never grows the table
+  std::vector<uint256> vHashes;
+  for (int i = 0; i < 4096; i++) vHashes.push_back(GetRandHash());
+  for (const uint256& hash : vHashes) cache.insert(hash);
+  BOOST_CHECK_EQUAL(cache.capacity(), 1024U);
+
+  int nFound = 0;
+  for (const uint256& hash : vHashes) nFound += cache.contains(hash, false);
+  BOOST_CHECK(nFound <= 1024);
+  BOOST_CHECK(nFound > 900);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_erase) {
+  cuckoocache<uint256, uint256_word_hasher> cache;
+  cache.setup(1024);
+
+  // Fill the table, then erase everything and check the freed slots are reused
+  std::vector<uint256> vOld, vNew;
+  for (int i = 0; i < 1024; i++) vOld.push_back(GetRandHash());
+  for (const uint256& hash : vOld) cache.insert(hash);
+  for (const uint256& hash : vOld) cache.contains(hash, true);
+
+  for (int i = 0; i < 512; i++) vNew.push_back(GetRandHash());
+  for (const uint256& hash : vNew) cache.insert(hash);
+  int nFound = 0;
+  for (const uint256& hash : vNew) nFound += cache.contains(hash, false);
+  BOOST_CHECK_EQUAL(nFound, 512);
+}
+
+BOOST_AUTO_TEST_CASE(cuckoocache_clear) {
+  cuckoocache<uint256, uint256_word_hasher> cache;
+  cache.setup(1024);
+  uint256 hash = GetRandHash();
+  cache.insert(hash);
+  BOOST_CHECK(cache.contains(hash, false));
+  cache.clear();
+  BOOST_CHECK(!cache.contains(hash, false));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,213 @@
+// Copyright (c) 2018 The TessaChain developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "random.h"
+#include "util.h"
+#include "wallet/db.h"
+#include "wallet/walletdb.h"
+#include "zerotracker.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+/** The wallet database with its typed accessors opened up for the tests */
+class CTestDB : public CDB {
+ public:
+  using CDB::Erase;
+  using CDB::Exists;
+  using CDB::Read;
+  using CDB::Write;
+};
+
+BOOST_AUTO_TEST_SUITE(dbwrapper_tests)
+
+static fs::path TempDbPath(const std::string& strName) {
+  return GetTempPath() / strprintf("%s_%lu_%i", strName, (unsigned long)GetTime(), (int)GetRand(100000));
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_batch_commit) {
+  fs::path path = TempDbPath("dbwrapper_batch_commit");
+  {
+    CTestDB db;
+    BOOST_CHECK(db.init(path) == 0);
+    // A new wallet file is stamped with the client version
+    int nVersion = 0;
+    BOOST_CHECK(db.ReadVersion(nVersion));
+    BOOST_CHECK_EQUAL(nVersion, CLIENT_VERSION);
+    {
+      CDBBatch batch(db);
+      for (int i = 0; i < 1000; i++) BOOST_CHECK(db.Write(std::make_pair(std::string("n"), i), i * 2));
+      BOOST_CHECK(batch.Commit());
+    }
+    int nValue = 0;
+    BOOST_CHECK(db.Read(std::make_pair(std::string("n"), 999), nValue));
+    BOOST_CHECK_EQUAL(nValue, 1998);
+    BOOST_CHECK(db.Read(std::make_pair(std::string("n"), 0), nValue));
+    BOOST_CHECK_EQUAL(nValue, 0);
+  }
+  fs::remove_all(path);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_batch_abort) {
+  fs::path path = TempDbPath("dbwrapper_batch_abort");
+  {
+    CTestDB db;
+    BOOST_CHECK(db.init(path) == 0);
+    {
+      // An abandoned inner batch poisons the outer one
+      CDBBatch batch(db);
+      BOOST_CHECK(db.Write(std::string("key"), 1));
+      { CDBBatch inner(db); }
+      BOOST_CHECK(!batch.Commit());
+    }
+    BOOST_CHECK(!db.Exists(std::string("key")));
+  }
+  fs::remove_all(path);
+}
+
+static void StressReader(CTestDB* pdb, int nKeys, const boost::atomic<bool>* pfStop,
+                         boost::atomic<uint64_t>* pnReads, boost::atomic<uint64_t>* pnFailed) {
+  uint64_t nReads = 0, nFailed = 0;
+  FastRandomContext rng;
+  while (!pfStop->load()) {
+    int n = rng.randrange(nKeys);
+    int nValue = -1;
+    if (!pdb->Read(std::make_pair(std::string("n"), n), nValue) || nValue != n) nFailed++;
+    nReads++;
+  }
+  *pnReads += nReads;
+  *pnFailed += nFailed;
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_concurrent_readers) {
+  const int nKeys = 1000;
+  const int nReaders = 8;
+  fs::path path = TempDbPath("dbwrapper_concurrent_readers");
+  {
+    CTestDB db;
+    BOOST_CHECK(db.init(path) == 0);
+    {
+      CDBBatch batch(db);
+      for (int i = 0; i < nKeys; i++) db.Write(std::make_pair(std::string("n"), i), i);
+      BOOST_CHECK(batch.Commit());
+    }
+
+    boost::atomic<bool> fStop(false);
+    boost::atomic<uint64_t> nReads(0), nFailed(0);
+    boost::thread_group readers;
+    int64_t nStart = GetTimeMicros();
+    for (int i = 0; i < nReaders; i++)
+      readers.create_thread(boost::bind(&StressReader, &db, nKeys, &fStop, &nReads, &nFailed));
+
+    // One writer keeps committing while the readers run
+    int nWrites = 0;
+    while (GetTimeMicros() - nStart < 1000000) {
+      BOOST_CHECK(db.Write(std::make_pair(std::string("w"), nWrites), nWrites));
+      nWrites++;
+    }
+    fStop = true;
+    readers.join_all();
+    int64_t nElapsed = GetTimeMicros() - nStart;
+
+    BOOST_CHECK_EQUAL(nFailed.load(), 0U);
+    BOOST_CHECK(nReads.load() > 0);
+    BOOST_TEST_MESSAGE(strprintf("dbwrapper_concurrent_readers: %d readers, %.0f reads/s, %d writes", nReaders,
+                                 nReads.load() * 1000000.0 / nElapsed, nWrites));
+
+    int nValue = 0;
+    BOOST_CHECK(db.Read(std::make_pair(std::string("w"), nWrites - 1), nValue));
+    BOOST_CHECK_EQUAL(nValue, nWrites - 1);
+  }
+  fs::remove_all(path);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_map_growth) {
+  fs::path path = TempDbPath("dbwrapper_map_growth");
+  {
+    // Start from a 1 MiB map and write well past it, both inside and outside a batch.
+    // Values stay under the MDB_DUPSORT item limit.
+    CTestDB db;
+    BOOST_CHECK(db.init(path, "r+", 1 << 20) == 0);
+    std::vector<unsigned char> vch(400, 0x5a);
+    {
+      CDBBatch batch(db);
+      for (int i = 0; i < 10000; i++) BOOST_CHECK(db.Write(std::make_pair(std::string("b"), i), vch));
+      BOOST_CHECK(batch.Commit());
+    }
+    for (int i = 0; i < 10000; i++) BOOST_CHECK(db.Write(std::make_pair(std::string("s"), i), vch));
+
+    std::vector<unsigned char> vchRead;
+    BOOST_CHECK(db.Read(std::make_pair(std::string("b"), 0), vchRead));
+    BOOST_CHECK(vchRead == vch);
+    BOOST_CHECK(db.Read(std::make_pair(std::string("s"), 9999), vchRead));
+    BOOST_CHECK(vchRead == vch);
+  }
+  fs::remove_all(path);
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_read_only) {
+  fs::path path = TempDbPath("dbwrapper_read_only");
+  {
+    CTestDB db;
+    BOOST_CHECK(db.init(path, "r+", 1 << 20) == 0);
+    BOOST_CHECK(db.Write(std::string("key"), 7));
+  }
+  uintmax_t nFileSize = fs::file_size(path / "data.mdb");
+  {
+    // A larger requested map must not extend the file of a read-only env
+    CTestDB db;
+    BOOST_CHECK(db.init(path, "r", 8 << 20) == 0);
+    int nValue = 0;
+    BOOST_CHECK(db.Read(std::string("key"), nValue));
+    BOOST_CHECK_EQUAL(nValue, 7);
+  }
+  BOOST_CHECK_EQUAL(fs::file_size(path / "data.mdb"), nFileSize);
+  fs::remove_all(path);
+}
+
+BOOST_AUTO_TEST_CASE(walletdb_prune_mint_witnesses) {
+  fs::path path = TempDbPath("walletdb_prune_mint_witnesses");
+  BOOST_CHECK(gWalletDB.init(path) == 0);
+  std::vector<uint256> vHashes;
+  for (int i = 0; i < 4; i++) vHashes.push_back(GetRandHash());
+  {
+    // Records that sort before and after the witnesses
+    BOOST_CHECK(gWalletDB.WriteName("address", "label"));
+    BOOST_CHECK(gWalletDB.WriteMintPoolPair(GetRandHash(), GetRandHash(), 1));
+    BOOST_CHECK(gWalletDB.WriteOrderPosNext(7));
+
+    CZeroTracker tracker;
+    for (int i = 0; i < 4; i++) {
+      CMintWitness witness;
+      witness.bnPubcoin = i + 1;
+      witness.nHeight = i + 1;
+      tracker.SetWitness(vHashes[i], witness);
+    }
+  }
+  std::list<uint256> listWitnesses = gWalletDB.ListMintWitnesses();
+  BOOST_CHECK_EQUAL(listWitnesses.size(), 4U);
+
+  {
+    // A tracker after a restart only knows the witnesses through the wallet
+    CZeroTracker tracker;
+    std::set<uint256> setKeep;
+    setKeep.insert(vHashes[0]);
+    tracker.PruneWitnesses(setKeep);
+  }
+  listWitnesses = gWalletDB.ListMintWitnesses();
+  BOOST_CHECK_EQUAL(listWitnesses.size(), 1U);
+  BOOST_CHECK(listWitnesses.size() == 1 && listWitnesses.front() == vHashes[0]);
+  CMintWitness witness;
+  BOOST_CHECK(gWalletDB.ReadMintWitness(vHashes[0], witness));
+  BOOST_CHECK_EQUAL(witness.nHeight, 1);
+  for (int i = 1; i < 4; i++) BOOST_CHECK(!gWalletDB.ReadMintWitness(vHashes[i], witness));
+
+  gWalletDB.Close();
+  fs::remove_all(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
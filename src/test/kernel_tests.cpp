@@ -0,0 +1,257 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chain.h"
+#include "chainparams.h"
+#include "hash.h"
+#include "kernel.h"
+#include "libzerocoin/ParallelFor.h"
+#include "main_externs.h"
+#include "streams.h"
+#include "test/test_tessa.h"
+#include "txdb.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+//! Timestamps after nTimeTx that CStakeKernel::Search tries, as the staker always has
+const int HASH_DRIFT = 30;
+
+//! A short active chain, so the kernel search and the modifier cache have a tip to check against
+struct KernelSetup {
+  std::vector<uint256> vHashes;
+  std::vector<CBlockIndex> vIndex;
+
+  explicit KernelSetup(int nBlocks = 20) : vHashes(nBlocks), vIndex(nBlocks) {
+    SelectParams(CBaseChainParams::REGTEST);
+    for (int i = 0; i < nBlocks; i++) {
+      vHashes[i] = insecure_rand_ctx.rand256();
+      vIndex[i].nHeight = i;
+      vIndex[i].phashBlock = &vHashes[i];
+      vIndex[i].pprev = i ? &vIndex[i - 1] : nullptr;
+      mapBlockIndex[vHashes[i]] = &vIndex[i];
+    }
+    chainActive.SetTip(&vIndex.back());
+  }
+
+  ~KernelSetup() {
+    chainActive.SetTip(nullptr);
+    for (const uint256& hash : vHashes) mapBlockIndex.erase(hash);
+    mapHashedBlocks.clear();
+  }
+
+  //! A modifier walk that ended at the active block at nHeightLast
+  CStakeModifierEntry MakeEntry(int nHeightLast) const {
+    CStakeModifierEntry entry;
+    entry.nStakeModifier = insecure_rand_ctx.rand64();
+    entry.nStakeModifierHeight = nHeightLast - 1;
+    entry.nStakeModifierTime = insecure_rand();
+    entry.nHeightLast = nHeightLast;
+    entry.hashLast = vHashes[nHeightLast];
+    return entry;
+  }
+};
+
+//! Outpoint-like uniqueness data of random length
+CDataStream RandomUniqueness() {
+  CDataStream ss(SER_GETHASH);
+  ss << insecure_rand_ctx.rand256() << insecure_rand();
+  std::vector<uint8_t> vch = insecure_rand_ctx.randbytes(insecure_rand_ctx.randrange(64));
+  ss.write((const char*)vch.data(), vch.size());
+  return ss;
+}
+
+//! The kernel hash as CheckStake computed it before CStakeKernel kept the SHA256 midstate
+uint256 OldKernelHash(const CDataStream& ssUniqueID, uint64_t nStakeModifier, unsigned int nTimeBlockFrom,
+                      unsigned int nTimeTx) {
+  CDataStream ss(SER_GETHASH);
+  ss << nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx;
+  return Hash(ss.begin(), ss.end());
+}
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(kernel_tests, KernelSetup)
+
+BOOST_AUTO_TEST_CASE(kernel_hash_matches_stream_hash) {
+  // At a value of 100 the target is the per coin day one, which a hash meets about once in 256 tries
+  const arith_uint256 bnTargetPerCoinDay = ~arith_uint256(0) >> 8;
+  const CAmount nValueIn = 100;
+  int nHits = 0;
+  for (int n = 0; n < 200; n++) {
+    const CDataStream ssUniqueID = RandomUniqueness();
+    const uint64_t nStakeModifier = insecure_rand_ctx.rand64();
+    const unsigned int nTimeBlockFrom = 1500000000 + insecure_rand_ctx.randrange(100000000);
+    const unsigned int nTimeTx = nTimeBlockFrom + Params().StakeMinAge() + insecure_rand_ctx.randrange(1000000);
+    const CStakeKernel kernel(ssUniqueID, nValueIn, nStakeModifier, nTimeBlockFrom);
+
+    // The midstate is only copied, so the same kernel hashes any number of timestamps
+    for (unsigned int nTime : {nTimeTx, nTimeTx + 1, nTimeBlockFrom, 0u, 0xffffffffu})
+      BOOST_CHECK(kernel.GetHash(nTime) == OldKernelHash(ssUniqueID, nStakeModifier, nTimeBlockFrom, nTime));
+
+    unsigned int nTimeCheck = nTimeTx;
+    uint256 hashProofOfStake;
+    const bool fHit = CheckStake(ssUniqueID, nValueIn, nStakeModifier, bnTargetPerCoinDay, nTimeBlockFrom,
+                                 nTimeCheck, hashProofOfStake);
+    const uint256 hashOld = OldKernelHash(ssUniqueID, nStakeModifier, nTimeBlockFrom, nTimeTx);
+    BOOST_CHECK(hashProofOfStake == hashOld);
+    BOOST_CHECK_EQUAL(fHit, UintToArith256(hashOld) < bnTargetPerCoinDay);
+
+    // Search tries the latest timestamp first, as the old staking loop did
+    unsigned int nTimeOld = 0;
+    uint256 hashFoundOld;
+    for (int i = 0; i < HASH_DRIFT && !nTimeOld; i++) {
+      const unsigned int nTryTime = nTimeTx + HASH_DRIFT - i;
+      const uint256 hash = OldKernelHash(ssUniqueID, nStakeModifier, nTimeBlockFrom, nTryTime);
+      if (UintToArith256(hash) < bnTargetPerCoinDay) {
+        nTimeOld = nTryTime;
+        hashFoundOld = hash;
+      }
+    }
+    unsigned int nTimeHit = 0;
+    uint256 hashFound;
+    BOOST_CHECK_EQUAL(kernel.Search(bnTargetPerCoinDay, nTimeTx, nTimeHit, hashFound), nTimeOld != 0);
+    if (nTimeOld) {
+      BOOST_CHECK_EQUAL(nTimeHit, nTimeOld);
+      BOOST_CHECK(hashFound == hashFoundOld);
+      nHits++;
+    }
+  }
+  BOOST_CHECK(nHits > 0);
+}
+
+BOOST_AUTO_TEST_CASE(find_stake_kernel_lowest_hit) {
+  const arith_uint256 bnTarget = ~arith_uint256(0) >> 9;
+  const unsigned int nBits = bnTarget.GetCompact();
+  arith_uint256 bnTargetPerCoinDay;
+  bnTargetPerCoinDay.SetCompact(nBits);
+
+  const unsigned int nTimeTx = 1700000000;
+  std::vector<CStakeKernel> vKernels;
+  for (int i = 0; i < 300; i++)
+    vKernels.emplace_back(RandomUniqueness(), 100, insecure_rand_ctx.rand64(),
+                          nTimeTx - Params().StakeMinAge() - insecure_rand_ctx.randrange(1000000));
+
+  // Every input searched one after the other, in order
+  std::vector<int> vHits;
+  std::vector<unsigned int> vTimes;
+  std::vector<uint256> vProofs;
+  for (size_t i = 0; i < vKernels.size(); i++) {
+    unsigned int nTimeHit;
+    uint256 hash;
+    if (!vKernels[i].Search(bnTargetPerCoinDay, nTimeTx, nTimeHit, hash)) continue;
+    vHits.push_back(i);
+    vTimes.push_back(nTimeHit);
+    vProofs.push_back(hash);
+  }
+  BOOST_CHECK(vHits.size() > 1);
+
+  // Spread over the proof workers, each call still finds the lowest remaining hit
+  libzerocoin::SetProofThreads(4);
+  size_t nStart = 0;
+  for (size_t n = 0; n <= vHits.size(); n++) {
+    unsigned int nTime = nTimeTx;
+    uint256 hashProofOfStake;
+    const int nFound = FindStakeKernel(vKernels, nStart, nBits, nTime, hashProofOfStake);
+    if (n == vHits.size()) {
+      BOOST_CHECK_EQUAL(nFound, -1);
+      break;
+    }
+    BOOST_CHECK_EQUAL(nFound, vHits[n]);
+    BOOST_CHECK_EQUAL(nTime, vTimes[n]);
+    BOOST_CHECK(hashProofOfStake == vProofs[n]);
+    if (nFound < 0) break;
+    nStart = nFound + 1;
+  }
+  libzerocoin::SetProofThreads(1);
+}
+
+BOOST_AUTO_TEST_CASE(stake_modifier_cache_disconnect) {
+  CStakeModifierCache cache;
+  const CStakeModifierEntry entryLow = MakeEntry(5), entryHigh = MakeEntry(12);
+  cache.Put(vHashes[1], entryLow);
+  cache.Put(vHashes[2], entryHigh);
+
+  CStakeModifierEntry entry;
+  BOOST_CHECK(cache.Get(vHashes[2], entry));
+  BOOST_CHECK_EQUAL(entry.nStakeModifier, entryHigh.nStakeModifier);
+  BOOST_CHECK_EQUAL(entry.nStakeModifierHeight, entryHigh.nStakeModifierHeight);
+  BOOST_CHECK_EQUAL(entry.nStakeModifierTime, entryHigh.nStakeModifierTime);
+
+  // Disconnecting above nHeightLast leaves the entry, at nHeightLast drops it
+  cache.DisconnectBlock(13);
+  BOOST_CHECK(cache.Get(vHashes[2], entry));
+  cache.DisconnectBlock(12);
+  BOOST_CHECK(!cache.Get(vHashes[2], entry));
+  BOOST_CHECK(cache.Get(vHashes[1], entry));
+  BOOST_CHECK_EQUAL(entry.nStakeModifier, entryLow.nStakeModifier);
+}
+
+BOOST_AUTO_TEST_CASE(stake_modifier_cache_reorg) {
+  CBlockTreeDB db(0, true);
+  CStakeModifierCache cache;
+  cache.Put(vHashes[3], MakeEntry(10));
+  BOOST_CHECK(cache.Flush(db));
+
+  // Another block at nHeightLast, without DisconnectBlock having run
+  uint256 hashFork = insecure_rand_ctx.rand256();
+  CBlockIndex indexFork;
+  indexFork.nHeight = 10;
+  indexFork.pprev = &vIndex[9];
+  indexFork.phashBlock = &hashFork;
+  chainActive.SetTip(&indexFork);
+
+  CStakeModifierEntry entry;
+  BOOST_CHECK(!cache.Get(vHashes[3], entry));
+
+  // The entry is gone rather than hidden, even once the old block is back
+  chainActive.SetTip(&vIndex.back());
+  BOOST_CHECK(!cache.Get(vHashes[3], entry));
+
+  // and was marked dirty, so the flush erased it from the database too
+  BOOST_CHECK(cache.Flush(db));
+  cache.Clear();
+  BOOST_CHECK(cache.Load(db));
+  BOOST_CHECK(!cache.Get(vHashes[3], entry));
+}
+
+BOOST_AUTO_TEST_CASE(stake_modifier_cache_flush_load) {
+  CBlockTreeDB db(0, true);
+  CStakeModifierCache cache;
+  const CStakeModifierEntry entryValid = MakeEntry(8);
+  cache.Put(vHashes[4], entryValid);
+
+  // A walk that ended on a block chainActive does not have, and one from an unknown block
+  CStakeModifierEntry entryStale = MakeEntry(15);
+  entryStale.hashLast = insecure_rand_ctx.rand256();
+  cache.Put(vHashes[5], entryStale);
+  const uint256 hashUnknown = insecure_rand_ctx.rand256();
+  cache.Put(hashUnknown, MakeEntry(9));
+  BOOST_CHECK(cache.Flush(db));
+
+  cache.Clear();
+  CStakeModifierEntry entry;
+  BOOST_CHECK(!cache.Get(vHashes[4], entry));
+  BOOST_CHECK(cache.Load(db));
+  BOOST_CHECK(cache.Get(vHashes[4], entry));
+  BOOST_CHECK_EQUAL(entry.nStakeModifier, entryValid.nStakeModifier);
+  BOOST_CHECK_EQUAL(entry.nStakeModifierHeight, entryValid.nStakeModifierHeight);
+  BOOST_CHECK_EQUAL(entry.nStakeModifierTime, entryValid.nStakeModifierTime);
+  BOOST_CHECK_EQUAL(entry.nHeightLast, entryValid.nHeightLast);
+  BOOST_CHECK(entry.hashLast == entryValid.hashLast);
+  BOOST_CHECK(!cache.Get(vHashes[5], entry));
+  BOOST_CHECK(!cache.Get(hashUnknown, entry));
+
+  // The entries left out are erased by the next flush
+  BOOST_CHECK(cache.Flush(db));
+  std::vector<std::pair<uint256, CStakeModifierEntry> > vEntries;
+  BOOST_CHECK(db.ReadStakeModifiers(vEntries));
+  BOOST_CHECK_EQUAL(vEntries.size(), 1U);
+  BOOST_CHECK(vEntries.size() == 1 && vEntries[0].first == vHashes[4]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
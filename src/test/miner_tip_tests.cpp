@@ -0,0 +1,67 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chain.h"
+#include "main_externs.h"
+#include "miner.h"
+#include "test/test_tessa.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+//! Two blocks, the coordinator starts building on the first and the second arrives meanwhile
+struct MinerTipSetup {
+  std::vector<uint256> vHashes;
+  std::vector<CBlockIndex> vIndex;
+
+  MinerTipSetup() : vHashes(2), vIndex(2) {
+    for (int i = 0; i < 2; i++) {
+      vHashes[i] = insecure_rand_ctx.rand256();
+      vIndex[i].nHeight = i;
+      vIndex[i].phashBlock = &vHashes[i];
+      vIndex[i].pprev = i ? &vIndex[i - 1] : nullptr;
+    }
+    chainActive.SetTip(&vIndex[0]);
+  }
+
+  ~MinerTipSetup() { chainActive.SetTip(nullptr); }
+};
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(miner_tip_tests, MinerTipSetup)
+
+BOOST_AUTO_TEST_CASE(miner_tip_change_during_template_build) {
+  CMinerTipWatch tipWatch;
+
+  // A signal left over from the previous template does not make the new one stale
+  tipWatch.Notify();
+  CBlockIndex* pindexPrev = tipWatch.Begin();
+  BOOST_CHECK(pindexPrev == &vIndex[0]);
+  BOOST_CHECK(!tipWatch.IsStale(pindexPrev));
+
+  // The tip moves while CreateNewBlock runs, the template must be rebuilt once published
+  chainActive.SetTip(&vIndex[1]);
+  tipWatch.Notify();
+  BOOST_CHECK(tipWatch.IsStale(pindexPrev));
+
+  pindexPrev = tipWatch.Begin();
+  BOOST_CHECK(pindexPrev == &vIndex[1]);
+  BOOST_CHECK(!tipWatch.IsStale(pindexPrev));
+}
+
+BOOST_AUTO_TEST_CASE(miner_tip_change_without_signal) {
+  CMinerTipWatch tipWatch;
+  CBlockIndex* pindexPrev = tipWatch.Begin();
+  BOOST_CHECK(!tipWatch.IsStale(pindexPrev));
+
+  // Even if the signal is missed, a template on an old parent is stale
+  chainActive.SetTip(&vIndex[1]);
+  BOOST_CHECK(tipWatch.IsStale(pindexPrev));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
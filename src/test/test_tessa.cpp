@@ -0,0 +1,12 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#define BOOST_TEST_MODULE Tessa Test Suite
+#define BOOST_TEST_MAIN
+
+#include "test/test_tessa.h"
+
+#include <boost/test/unit_test.hpp>
+
+FastRandomContext insecure_rand_ctx(true);
@@ -0,0 +1,11 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#pragma once
+
+#include "random.h"
+
+//! Randomness for the test cases, deterministic so a failure reproduces
+extern FastRandomContext insecure_rand_ctx;
+
+static inline uint32_t insecure_rand() { return insecure_rand_ctx.rand32(); }
@@ -9,6 +9,8 @@
 #include "libzerocoin/Denominations.h"
 #include "amount.h"
 #include "chainparams.h"
+#include "ecdsa/key.h"
+#include "ecdsa/pubkey.h"
 #include "main.h"
 #include "txdb.h"
 
@@ -16,11 +18,16 @@
 #include <iostream>
 
 struct ZeroSetup {
+    // Spends sign with the coin's key
+    ECCVerifyHandle globalVerifyHandle;
+
     ZeroSetup() {
         std::cout << "global setup\n";
+        ECC_Start();
     }
     ~ZeroSetup()
     {
+        ECC_Stop();
         std::cout << "global teardown\n";
     }
 };
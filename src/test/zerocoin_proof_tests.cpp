@@ -0,0 +1,323 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "libzerocoin/Accumulator.h"
+#include "libzerocoin/AccumulatorWitness.h"
+#include "libzerocoin/BatchVerifier.h"
+#include "libzerocoin/CoinSpend.h"
+#include "libzerocoin/FixedBaseExp.h"
+#include "libzerocoin/IntegerMod.h"
+#include "libzerocoin/MultiExp.h"
+#include "libzerocoin/ParallelFor.h"
+#include "libzerocoin/PrivateCoin.h"
+#include "rand_bignum.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace libzerocoin;
+
+namespace {
+
+const size_t COINS_TO_ACCUMULATE = 4;
+
+//! Uniform below range, randBignum() only bounds the byte length
+CBigNum RandBelow(const CBigNum& range) { return randBignum(range) % range; }
+
+const ZerocoinParams& GetParams() {
+  static const ZerocoinParams params;
+  return params;
+}
+
+//! Coins minted once and shared by every test that spends
+const std::vector<PrivateCoin>& GetCoins() {
+  static std::vector<PrivateCoin> vCoins;
+  if (vCoins.empty()) {
+    const ZerocoinParams* params = &GetParams();
+    const CBigNum& bnOrder = params->coinCommitmentGroup.groupOrder;
+    while (vCoins.size() < COINS_TO_ACCUMULATE) {
+      // The serial comes from a key, which the spend signs with. Retry until the commitment is a prime in range
+      ecdsa::CKey key;
+      CBigNum bnSerial;
+      GenerateKeyPair(bnOrder, uint256(), key, bnSerial);
+      PrivateCoin coin(params, CoinDenomination::ZQ_ONE, bnSerial, RandBelow(bnOrder));
+      coin.setPrivKey(key.GetPrivKey());
+      if (coin.getPublicCoin().validate()) vCoins.push_back(coin);
+    }
+  }
+  return vCoins;
+}
+
+//! Accumulator over all shared coins, and a spend of each one of them against it
+struct SpendSetup {
+  Accumulator acc;
+  std::vector<std::unique_ptr<CoinSpend> > vSpends;
+
+  explicit SpendSetup(const ZerocoinParams* params) : acc(params, CoinDenomination::ZQ_ONE) {
+    const std::vector<PrivateCoin>& vCoins = GetCoins();
+    for (const PrivateCoin& coin : vCoins) acc += coin.getPublicCoin();
+    for (size_t i = 0; i < vCoins.size(); i++) {
+      AccumulatorWitness witness(params, Accumulator(params, CoinDenomination::ZQ_ONE), vCoins[i].getPublicCoin());
+      for (size_t j = 0; j < vCoins.size(); j++)
+        if (j != i) witness += vCoins[j].getPublicCoin();
+      vSpends.emplace_back(new CoinSpend(params, vCoins[i], acc, 0, witness, uint256()));
+    }
+  }
+};
+
+// Every Montgomery operation against the plain GMP result, for the modulus of T
+template <ModulusType T> void CheckMontgomery() {
+  typedef IntegerMod<T> Z;
+  const typename Z::MontgomeryArith& mont = Z::GetMontgomery();
+  const CBigNum& m = Z::Mod;
+
+  // Conversions, including values that are negative or not reduced
+  const CBigNum vEdge[] = {CBigNum(0), CBigNum(1), m - 1, m, m + 1, m * m + 5, CBigNum(0) - 7, CBigNum(0) - m - 1};
+  for (const CBigNum& x : vEdge) BOOST_CHECK(mont.FromMont(mont.ToMont(x)) == ((x % m) + m) % m);
+
+  for (int i = 0; i < 8; i++) {
+    const CBigNum a = RandBelow(m), b = RandBelow(m);
+    typename Z::MontgomeryArith::Elem r;
+    mont.Mul(r, mont.ToMont(a), mont.ToMont(b));
+    BOOST_CHECK(mont.FromMont(r) == a.mul_mod(b, m));
+    mont.Sqr(r, mont.ToMont(a));
+    BOOST_CHECK(mont.FromMont(r) == a.mul_mod(a, m));
+
+    // Exponents narrower and wider than the modulus, and negative ones
+    const CBigNum e = RandBelow(CBigNum(2).pow(i % 2 ? 256 : m.bitSize() + 64));
+    BOOST_CHECK((Z(a) ^ e) == a.pow_mod(e, m));
+    BOOST_CHECK((Z(a) ^ (0 - e)) == a.inverse(m).pow_mod(e, m));
+  }
+
+  // Zero exponent, zero base, the largest exponent of a given width
+  const CBigNum a = RandBelow(m);
+  const CBigNum ones = CBigNum(2).pow(m.bitSize()) - 1;
+  BOOST_CHECK((Z(a) ^ CBigNum(0)) == CBigNum(1));
+  BOOST_CHECK((Z(CBigNum(0)) ^ CBigNum(5)) == CBigNum(0));
+  BOOST_CHECK((Z(a) ^ ones) == a.pow_mod(ones, m));
+  BOOST_CHECK(mont.FromMont(mont.Pow(mont.ToMont(a), ones, m.bitSize())) == a.pow_mod(ones, m));
+
+  // Multi-exponentiation in Montgomery form against the mpz one
+  std::vector<Z> vBases;
+  std::vector<CBigNum> vValues, vExps;
+  for (int i = 0; i < 5; i++) {
+    vValues.push_back(RandBelow(m));
+    vBases.push_back(Z(vValues.back()));
+    vExps.push_back(RandBelow(CBigNum(2).pow(512)));
+  }
+  vExps[1] = 0 - vExps[1];
+  vExps[3] = 0;
+  BOOST_CHECK(Z::multiPow(vBases, vExps) == MultiPowMod(vValues, vExps, m));
+  BOOST_CHECK(Z::multiPow({}, {}) == CBigNum(1));
+  BOOST_CHECK(Z::multiPow({vBases[0]}, {vExps[0]}) == vValues[0].pow_mod(vExps[0], m));
+
+  // and with two more factors from fixed-base tables, whose entries are in Montgomery form too
+  const CBigNum g = RandBelow(m), h = RandBelow(m), eg = RandBelow(CBigNum(2).pow(512));
+  const FixedBaseExp gTable(g, m, 512), hTable(h, m, 512);
+  const CBigNum expected =
+      MultiPowMod(vValues, vExps, m).mul_mod(g.pow_mod(eg, m), m).mul_mod(h.inverse(m).pow_mod(eg, m), m);
+  BOOST_CHECK(Z::multiPow(vBases, vExps, gTable, eg, hTable, 0 - eg) == expected);
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(zerocoin_proof_tests)
+
+BOOST_AUTO_TEST_CASE(fixed_base_exp) {
+  const IntegerGroupParams& group = GetParams().accumulatorParams.accumulatorPoKCommitmentGroup;
+  const FixedBaseExp table(group.g, group.modulus, 1024);
+
+  for (int i = 0; i < 16; i++) {
+    const CBigNum e = RandBelow(CBigNum(2).pow(1024));
+    BOOST_CHECK(table.pow(e) == group.g.pow_mod(e, group.modulus));
+    // Negative exponents give the inverse
+    BOOST_CHECK(table.pow(0 - e) == group.g.pow_mod(e, group.modulus).inverse(group.modulus));
+  }
+
+  // Exponents wider than the table fall back to plain exponentiation
+  const CBigNum wide = CBigNum(2).pow(1500) + CBigNum(3);
+  BOOST_CHECK(table.pow(wide) == group.g.pow_mod(wide, group.modulus));
+  BOOST_CHECK(table.pow(CBigNum(0)) == CBigNum(1));
+
+  // An even modulus has no Montgomery form and always takes the plain path
+  const CBigNum even = group.modulus + 1;
+  const FixedBaseExp evenTable(group.g, even, 256);
+  const CBigNum e = RandBelow(CBigNum(2).pow(256));
+  BOOST_CHECK(evenTable.pow(e) == group.g.pow_mod(e, even));
+}
+
+BOOST_AUTO_TEST_CASE(multi_exp) {
+  const CBigNum& modulus = GetParams().accumulatorParams.accumulatorModulus;
+
+  // Few bases with wide exponents, many with short ones, and some negative exponents throughout
+  const size_t nBaseCounts[] = {2, 3, 300};
+  const unsigned int nExpBits[] = {1024, 1024, 64};
+  for (int t = 0; t < 3; t++) {
+    std::vector<CBigNum> vBases, vExps;
+    CBigNum expected(1);
+    for (size_t i = 0; i < nBaseCounts[t]; i++) {
+      vBases.push_back(RandBelow(modulus));
+      vExps.push_back(RandBelow(CBigNum(2).pow(nExpBits[t])));
+      if (i % 3 == 1) {
+        vExps.back() = 0 - vExps.back();
+        expected = expected.mul_mod(vBases[i].inverse(modulus).pow_mod(0 - vExps[i], modulus), modulus);
+      } else {
+        expected = expected.mul_mod(vBases[i].pow_mod(vExps[i], modulus), modulus);
+      }
+    }
+    BOOST_CHECK(MultiPowMod(vBases, vExps, modulus) == expected);
+  }
+  BOOST_CHECK(MultiPowMod({}, {}, modulus) == CBigNum(1));
+}
+
+BOOST_AUTO_TEST_CASE(montgomery) {
+  CheckMontgomery<ACCUMULATOR_MODULUS>();
+  CheckMontgomery<COIN_COMMITMENT_MODULUS>();
+  CheckMontgomery<SERIAL_NUMBER_SOK_COMMITMENT_MODULUS>();
+  CheckMontgomery<SERIAL_NUMBER_SOK_COMMITMENT_GROUP>();
+  CheckMontgomery<ACCUMULATOR_POK_COMMITMENT_MODULUS>();
+  CheckMontgomery<ACCUMULATOR_POK_COMMITMENT_GROUP>();
+}
+
+BOOST_AUTO_TEST_CASE(batch_accumulate) {
+  const ZerocoinParams* params = &GetParams();
+
+  // Coins added as one batch give the same accumulator as coins added one by one
+  Accumulator accOne(params, CoinDenomination::ZQ_ONE);
+  Accumulator accBatch(params, CoinDenomination::ZQ_ONE);
+  std::vector<PublicCoin> vCoins;
+  for (const PrivateCoin& coin : GetCoins()) {
+    accOne += coin.getPublicCoin();
+    vCoins.push_back(coin.getPublicCoin());
+  }
+  accBatch.accumulate(vCoins);
+  BOOST_CHECK(accOne.getValue() == accBatch.getValue());
+
+  // Raw values spanning several chunks
+  std::vector<CBigNum> vValues;
+  for (int i = 0; i < 2 * ACCUMULATOR_BATCH_MAX + 3; i++) {
+    vValues.push_back(RandBelow(CBigNum(2).pow(256)));
+    accOne.increment(vValues.back());
+  }
+  accBatch.increment(vValues);
+  BOOST_CHECK(accOne.getValue() == accBatch.getValue());
+}
+
+BOOST_AUTO_TEST_CASE(batch_verify) {
+  const ZerocoinParams* params = &GetParams();
+  SpendSetup setup(params);
+  const Accumulator& acc = setup.acc;
+
+  BatchVerifier batch(params);
+  for (const std::unique_ptr<CoinSpend>& spend : setup.vSpends) {
+    BOOST_CHECK(spend->Verify(acc));
+    batch.Add(*spend, acc);
+  }
+  batch.Add(*setup.vSpends[0], acc);
+  std::vector<size_t> vInvalid;
+  BOOST_CHECK(batch.Verify(&vInvalid));
+  BOOST_CHECK(vInvalid.empty());
+
+  // Against an accumulator missing the coin only that spend fails, and is singled out
+  Accumulator accWrong(params, CoinDenomination::ZQ_ONE);
+  accWrong += GetCoins()[0].getPublicCoin();
+  BOOST_CHECK(!setup.vSpends[1]->Verify(accWrong));
+  batch.Add(*setup.vSpends[1], accWrong);
+  batch.Add(*setup.vSpends[2], acc);
+  BOOST_CHECK(!batch.Verify(&vInvalid));
+  BOOST_CHECK(vInvalid == std::vector<size_t>(1, setup.vSpends.size() + 1));
+}
+
+BOOST_AUTO_TEST_CASE(precomputed_spend) {
+  // Proofs made with the generator tables verify without them, and the other way round
+  ZerocoinParams paramsTables;
+  paramsTables.Precompute();
+  SpendSetup setupPlain(&GetParams());
+  SpendSetup setupTables(&paramsTables);
+  BOOST_CHECK(setupPlain.acc.getValue() == setupTables.acc.getValue());
+  for (size_t i = 0; i < setupPlain.vSpends.size(); i++) {
+    BOOST_CHECK(setupPlain.vSpends[i]->Verify(setupTables.acc));
+    BOOST_CHECK(setupTables.vSpends[i]->Verify(setupPlain.acc));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bignum_pooling) {
+  SpendSetup setup(&GetParams());
+  const CoinSpend& spend = *setup.vSpends[0];
+
+  // Once warm, the per-thread pool serves most of a verification's GMP allocations
+  SetBignumPooling(true);
+  BOOST_CHECK(spend.Verify(setup.acc));
+  SetBignumPooling(true);
+  BOOST_CHECK(spend.Verify(setup.acc));
+  uint64_t nAllocs, nMallocs;
+  GetBignumAllocStats(nAllocs, nMallocs);
+  SetBignumPooling(false);
+  BOOST_CHECK(nAllocs > 0);
+  BOOST_CHECK(nMallocs * 2 < nAllocs);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_proofs) {
+  const ZerocoinParams* params = &GetParams();
+  const size_t nCount = 1000;
+  std::vector<uint64_t> vSerial(nCount), vParallel(nCount);
+  for (size_t i = 0; i < nCount; i++) vSerial[i] = (uint64_t)i * i;
+
+  // Spends made before the workers start
+  SpendSetup setupSerial(params);
+  Accumulator accWrong(params, CoinDenomination::ZQ_ONE);
+  accWrong += GetCoins()[0].getPublicCoin();
+
+  // Resizing the pool up and down on the way
+  SetProofThreads(2);
+  SetProofThreads(8);
+  SetProofThreads(4);
+  BOOST_CHECK_EQUAL(GetProofThreads(), 4U);
+
+  ParallelFor(nCount, [&](size_t i) { vParallel[i] = (uint64_t)i * i; });
+  BOOST_CHECK(vParallel == vSerial);
+  ParallelFor(0, [](size_t i) { BOOST_ERROR("called for an empty range"); });
+
+  // An exception is rethrown once every other index has run
+  std::atomic<size_t> nRan(0);
+  BOOST_CHECK_THROW(ParallelFor(nCount,
+                                [&](size_t i) {
+                                  if (i == 37) throw std::runtime_error("index 37");
+                                  nRan++;
+                                }),
+                    std::runtime_error);
+  BOOST_CHECK_EQUAL(nRan.load(), nCount - 1);
+
+  // Proofs made and checked on the workers agree with the single-threaded ones
+  SpendSetup setupParallel(params);
+  BOOST_CHECK(setupParallel.acc.getValue() == setupSerial.acc.getValue());
+  Accumulator accBatch(params, CoinDenomination::ZQ_ONE);
+  std::vector<PublicCoin> vCoins;
+  for (const PrivateCoin& coin : GetCoins()) vCoins.push_back(coin.getPublicCoin());
+  accBatch.accumulate(vCoins);
+  BOOST_CHECK(accBatch.getValue() == setupSerial.acc.getValue());
+  BatchVerifier batch(params);
+  for (size_t i = 0; i < setupSerial.vSpends.size(); i++) {
+    BOOST_CHECK(setupSerial.vSpends[i]->Verify(setupSerial.acc));
+    BOOST_CHECK(setupParallel.vSpends[i]->Verify(setupSerial.acc));
+    BOOST_CHECK(!setupParallel.vSpends[i]->Verify(accWrong));
+    batch.Add(*setupParallel.vSpends[i], setupSerial.acc);
+  }
+  batch.Add(*setupParallel.vSpends[1], accWrong);
+  std::vector<size_t> vInvalid;
+  BOOST_CHECK(!batch.Verify(&vInvalid));
+  BOOST_CHECK(vInvalid == std::vector<size_t>(1, setupParallel.vSpends.size()));
+
+  SetProofThreads(1);
+  BOOST_CHECK_EQUAL(GetProofThreads(), 1U);
+  for (size_t i = 0; i < setupParallel.vSpends.size(); i++)
+    BOOST_CHECK(setupParallel.vSpends[i]->Verify(setupParallel.acc));
+  BOOST_CHECK(!setupParallel.vSpends[1]->Verify(accWrong));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+// Copyright (c) 2018 The TessaCoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "ecdsa/key.h"
+#include "ecdsa/pubkey.h"
+#include "libzerocoin/Accumulator.h"
+#include "libzerocoin/AccumulatorWitness.h"
+#include "libzerocoin/CoinSpend.h"
+#include "libzerocoin/PrivateCoin.h"
+#include "main_externs.h"
+#include "mainzero.h"
+#include "primitives/transaction.h"
+#include "rand_bignum.h"
+#include "random.h"
+#include "streams.h"
+#include "txdb.h"
+#include "util.h"
+#include "validationstate.h"
+#include "zerochain.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace libzerocoin;
+
+namespace {
+
+//! An in-memory zerocoin database without any accumulator checkpoints, so a
+//! spend that misses the cache fails instead of being proven again
+struct SpendCacheSetup {
+  ECCVerifyHandle globalVerifyHandle;
+  fs::path pathData;
+
+  SpendCacheSetup() {
+    ECC_Start();
+    SelectParams(CBaseChainParams::REGTEST);
+    pathData = GetTempPath() / strprintf("zerocoin_spendcache_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000));
+    fs::create_directories(pathData);
+    gArgs.ForceSetArg("-datadir", pathData.string());
+    zerocoinDB = new CZerocoinDB(0, true);
+    ClearZerocoinSpendCache();
+  }
+
+  ~SpendCacheSetup() {
+    ClearZerocoinSpendCache();
+    delete zerocoinDB;
+    zerocoinDB = nullptr;
+    fs::remove_all(pathData);
+    ECC_Stop();
+  }
+};
+
+//! A transaction redeeming one freshly minted coin, and the accumulator value it was proven against
+CTransaction CreateSpendTx(CBigNum& bnAccumulatorValue) {
+  const ZerocoinParams* params = gpZerocoinParams;
+  const CBigNum& bnOrder = params->coinCommitmentGroup.groupOrder;
+
+  std::vector<PrivateCoin> vCoins;
+  while (vCoins.size() < 2) {
+    // CoinSpend signs with the key the serial was derived from
+    ecdsa::CKey key;
+    CBigNum bnSerial;
+    GenerateKeyPair(bnOrder, uint256(), key, bnSerial);
+    PrivateCoin coin(params, CoinDenomination::ZQ_ONE, bnSerial, randBignum(bnOrder) % bnOrder);
+    coin.setPrivKey(key.GetPrivKey());
+    if (coin.getPublicCoin().validate()) vCoins.push_back(coin);
+  }
+  Accumulator acc(params, CoinDenomination::ZQ_ONE);
+  for (const PrivateCoin& coin : vCoins) acc += coin.getPublicCoin();
+  AccumulatorWitness witness(params, Accumulator(params, CoinDenomination::ZQ_ONE), vCoins[0].getPublicCoin());
+  witness += vCoins[1].getPublicCoin();
+  bnAccumulatorValue = acc.getValue();
+
+  CMutableTransaction txNew;
+  txNew.vout.push_back(CTxOut(ZerocoinDenominationToAmount(CoinDenomination::ZQ_ONE), CScript() << OP_TRUE));
+  CoinSpend spend(params, vCoins[0], acc, 0, witness, CMutableTransaction(txNew).GetHash());
+
+  CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+  ss << spend;
+  std::vector<unsigned char> data(ss.begin(), ss.end());
+  CTxIn txin;
+  txin.nSequence = CoinDenomination::ZQ_ONE;
+  txin.scriptSig = CScript() << OP_ZEROCOINSPEND << data.size();
+  txin.scriptSig.insert(txin.scriptSig.end(), data.begin(), data.end());
+  txNew.vin.push_back(txin);
+  return CTransaction(txNew);
+}
+
+}  // namespace
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_spendcache_tests, SpendCacheSetup)
+
+BOOST_AUTO_TEST_CASE(zerocoin_spendcache_template_then_connect) {
+  CBigNum bnAccumulatorValue;
+  CTransaction tx = CreateSpendTx(bnAccumulatorValue);
+  CoinSpend spend = TxInToZerocoinSpend(tx.vin[0]);
+  CValidationState state;
+
+  // Nothing cached yet and no checkpoint to prove against
+  BOOST_CHECK(!CheckZerocoinSpend(tx, true, state, nullptr, true));
+
+  // Mempool acceptance proves the spend and caches it
+  CZerocoinSpendCheck check(spend, bnAccumulatorValue, tx.GetHash(), true);
+  BOOST_CHECK(check());
+
+  // The block template check (TestBlockValidity) hits and keeps the entry...
+  BOOST_CHECK(CheckZerocoinSpend(tx, true, state, nullptr, true));
+  BOOST_CHECK(CheckZerocoinSpend(tx, true, state, nullptr, true));
+
+  // ...so connecting the block still skips the proof
+  std::vector<CZerocoinSpendCheck> vChecks;
+  BOOST_CHECK(CheckZerocoinSpend(tx, true, state, &vChecks, false));
+  BOOST_CHECK(vChecks.empty());
+
+  // Forgetting the cache brings back the full check
+  ClearZerocoinSpendCache();
+  BOOST_CHECK(!CheckZerocoinSpend(tx, true, state, nullptr, false));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
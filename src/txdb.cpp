@@ -8,6 +8,7 @@
 #include "txdb.h"
 
 #include "accumulators.h"
+#include "kernel.h"
 #include "libzerocoin/CoinSpend.h"
 #include "main.h"
 #include "pow.h"
@@ -15,6 +16,10 @@
 #include "uint256.h"
 #include <cstdint>
 
+#include <deque>
+#include <memory>
+
+#include <boost/bind.hpp>
 #include <boost/thread.hpp>
 
 using namespace std;
@@ -28,11 +33,22 @@ void static BatchWriteCoins(CLevelDBBatch& batch, const uint256& hash, const CCo
 
 void static BatchWriteHashBestChain(CLevelDBBatch& batch, const uint256& hash) { batch.Write('B', hash); }
 
+//! Coins get a column family of their own, the best block marker stays in the default one
+static const std::vector<CLevelDBFamily> vCoinsFamilies = {{'c', "coins"}};
+
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe)
-    : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe) {}
+    : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, vCoinsFamilies) {}
 
 bool CCoinsViewDB::GetCoins(const uint256& txid, CCoins& coins) const { return db.Read(make_pair('c', txid), coins); }
 
+void CCoinsViewDB::GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                                std::vector<bool>& vFound) const {
+  std::vector<std::pair<char, uint256> > vKeys;
+  vKeys.reserve(vTxid.size());
+  for (const uint256& txid : vTxid) vKeys.push_back(make_pair('c', txid));
+  db.ReadMany(vKeys, vCoins, vFound);
+}
+
 bool CCoinsViewDB::HaveCoins(const uint256& txid) const { return db.Exists(make_pair('c', txid)); }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
@@ -44,7 +60,7 @@ uint256 CCoinsViewDB::GetBestBlock() const {
 }
 
 bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) {
-  CLevelDBBatch batch;
+  CLevelDBBatch batch(db);
   size_t count = 0;
   size_t changed = 0;
   for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
@@ -63,8 +79,10 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) {
   return db.WriteBatch(batch);
 }
 
+static const std::vector<CLevelDBFamily> vBlockTreeFamilies = {{'b', "blockindex"}, {'t', "txindex"}, {'m', "stakemodifier"}};
+
 CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe)
-    : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {}
+    : CLevelDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, vBlockTreeFamilies) {}
 
 bool CBlockTreeDB::WriteBlockIndex(const CDiskBlockIndex& blockindex) {
   return Write(make_pair('b', blockindex.GetBlockHash()), blockindex);
@@ -96,7 +114,7 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const {
   /* It seems that there are no "const iterators" for LevelDB.  Since we
      only need read operations on it, use a const-cast to get around
      that restriction.  */
-  std::unique_ptr<rocksdb::Iterator> pcursor(const_cast<CLevelDBWrapper*>(&db)->NewIterator());
+  std::unique_ptr<rocksdb::Iterator> pcursor(const_cast<CLevelDBWrapper*>(&db)->NewIterator('c'));
   pcursor->SeekToFirst();
 
   CHashWriter ss;
@@ -146,7 +164,7 @@ bool CCoinsViewDB::GetStats(CCoinsStats& stats) const {
 bool CBlockTreeDB::ReadTxIndex(const uint256& txid, CDiskTxPos& pos) { return Read(make_pair('t', txid), pos); }
 
 bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >& vect) {
-  CLevelDBBatch batch;
+  CLevelDBBatch batch(*this);
   for (std::vector<std::pair<uint256, CDiskTxPos> >::const_iterator it = vect.begin(); it != vect.end(); it++)
     batch.Write(make_pair('t', it->first), it->second);
   return WriteBatch(batch);
@@ -167,16 +185,21 @@ bool CBlockTreeDB::WriteInt(const std::string& name, int nValue) { return Write(
 
 bool CBlockTreeDB::ReadInt(const std::string& name, int& nValue) { return Read(std::make_pair('I', name), nValue); }
 
-bool CBlockTreeDB::LoadBlockIndexGuts() {
-  std::unique_ptr<rocksdb::Iterator> pcursor(NewIterator());
+bool CBlockTreeDB::WriteStakeModifiers(const std::vector<std::pair<uint256, CStakeModifierEntry> >& vWrite,
+                                       const std::vector<uint256>& vErase) {
+  CLevelDBBatch batch(*this);
+  for (const std::pair<uint256, CStakeModifierEntry>& item : vWrite) batch.Write(make_pair('m', item.first), item.second);
+  for (const uint256& hash : vErase) batch.Erase(make_pair('m', hash));
+  return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadStakeModifiers(std::vector<std::pair<uint256, CStakeModifierEntry> >& vEntries) {
+  std::unique_ptr<rocksdb::Iterator> pcursor(NewIterator('m'));
 
   CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
-  ssKeySet << make_pair('b', uint256());
+  ssKeySet << make_pair('m', uint256());
   pcursor->Seek(ssKeySet.str());
 
-  // Load mapBlockIndex
-  uint256 nPreviousCheckpoint = uint256();
-  nPreviousCheckpoint.SetNull();
   while (pcursor->Valid()) {
     boost::this_thread::interruption_point();
     try {
@@ -184,14 +207,216 @@ bool CBlockTreeDB::LoadBlockIndexGuts() {
       CDataStream ssKey(slKey.data(), slKey.data() + slKey.size(), SER_DISK, CLIENT_VERSION);
       char chType;
       ssKey >> chType;
-      if (chType == 'b') {
+      if (chType != 'm') break;
+      rocksdb::Slice slValue = pcursor->value();
+      CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+      vEntries.emplace_back();
+      ssKey >> vEntries.back().first;
+      ssValue >> vEntries.back().second;
+      pcursor->Next();
+    } catch (const std::exception& e) { return error("%s : Deserialize or I/O error - %s", __func__, e.what()); }
+  }
+  return true;
+}
+
+namespace {
+
+/** A run of consecutive 'b' records, handed from the reader to the decode workers and then to the linker */
+struct CBlockIndexChunk {
+  std::vector<std::string> vRaw;
+  std::vector<CDiskBlockIndex> vIndex;
+  std::vector<bool> vUpgrade;
+  std::string strError;
+  int64_t nDecodeMicros;
+  bool fDone;
+
+  CBlockIndexChunk() : nDecodeMicros(0), fDone(false) {}
+};
+
+/** Deserialize a chunk, derive the hash of legacy records and check the PoW of each entry */
+void DecodeBlockIndexChunk(CBlockIndexChunk& chunk) {
+  int64_t nStart = GetTimeMicros();
+  chunk.vIndex.resize(chunk.vRaw.size());
+  chunk.vUpgrade.assign(chunk.vRaw.size(), false);
+  try {
+    for (size_t i = 0; i < chunk.vRaw.size(); i++) {
+      const std::string& strValue = chunk.vRaw[i];
+      CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
+      CDiskBlockIndex& diskindex = chunk.vIndex[i];
+      ssValue >> diskindex;
+
+      if (diskindex.HasStoredHash()) {
+        if (fCheckBlockIndex && diskindex.ComputeBlockHash() != diskindex.hashBlock) {
+          chunk.strError = strprintf("stored hash mismatch at height %d: %s", diskindex.nHeight,
+                                     diskindex.hashBlock.ToString());
+          break;
+        }
+      } else {
+        diskindex.SetStoredHash(diskindex.ComputeBlockHash());
+        chunk.vUpgrade[i] = true;
+      }
+
+      if (diskindex.nHeight <= Params().LAST_POW_BLOCK() && !CheckProofOfWork(diskindex.hashBlock, diskindex.nBits)) {
+        chunk.strError = strprintf("CheckProofOfWork failed at height %d: %s", diskindex.nHeight,
+                                   diskindex.hashBlock.ToString());
+        break;
+      }
+    }
+  } catch (std::exception& e) { chunk.strError = strprintf("Deserialize or I/O error - %s", e.what()); }
+  std::vector<std::string>().swap(chunk.vRaw);
+  chunk.nDecodeMicros = GetTimeMicros() - nStart;
+}
+
+/** Worker pool that decodes block index chunks while the caller keeps reading and linking */
+class CBlockIndexDecodeQueue {
+ private:
+  boost::mutex mutex;
+  boost::condition_variable condWorker;
+  boost::condition_variable condMaster;
+  std::deque<std::shared_ptr<CBlockIndexChunk> > queue;
+  boost::thread_group threads;
+  bool fQuit;
+
+  void Thread() {
+    while (true) {
+      std::shared_ptr<CBlockIndexChunk> chunk;
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (queue.empty() && !fQuit) condWorker.wait(lock);
+        if (fQuit) return;
+        chunk = queue.front();
+        queue.pop_front();
+      }
+      DecodeBlockIndexChunk(*chunk);
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        chunk->fDone = true;
+      }
+      condMaster.notify_all();
+    }
+  }
+
+ public:
+  explicit CBlockIndexDecodeQueue(int nThreads) : fQuit(false) {
+    for (int i = 0; i < nThreads; i++) threads.create_thread(boost::bind(&CBlockIndexDecodeQueue::Thread, this));
+  }
+
+  ~CBlockIndexDecodeQueue() {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      fQuit = true;
+    }
+    condWorker.notify_all();
+    threads.join_all();
+  }
+
+  void Add(const std::shared_ptr<CBlockIndexChunk>& chunk) {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      queue.push_back(chunk);
+    }
+    condWorker.notify_one();
+  }
+
+  void Wait(const CBlockIndexChunk& chunk) {
+    boost::unique_lock<boost::mutex> lock(mutex);
+    while (!chunk.fDone) condMaster.wait(lock);
+  }
+};
+
+}  // namespace
+
+/**
+ * Load mapBlockIndex as a three stage pipeline: this thread streams raw 'b' records off the cursor, nThreads
+ * workers deserialize them and derive hashes, and this thread links the decoded chunks in cursor order.
+ */
+bool CBlockTreeDB::LoadBlockIndexGuts(int nThreads) {
+  static const size_t nChunkSize = 1024;
+
+  std::unique_ptr<rocksdb::Iterator> pcursor(NewIterator('b'));
+
+  CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
+  ssKeySet << make_pair('b', uint256());
+  pcursor->Seek(ssKeySet.str());
+
+  // With a single thread decoding runs inline and chunks are linked as soon as they are read
+  std::unique_ptr<CBlockIndexDecodeQueue> pqueue(nThreads > 1 ? new CBlockIndexDecodeQueue(nThreads) : nullptr);
+  const size_t nMaxInFlight = pqueue ? 4 * nThreads : 1;
+  std::deque<std::shared_ptr<CBlockIndexChunk> > dqInFlight;
+  bool fEndOfIndex = false;
+
+  // Load mapBlockIndex
+  uint256 nPreviousCheckpoint = uint256();
+  nPreviousCheckpoint.SetNull();
+
+  // Records from before the block hash was persisted are rewritten in place as they are linked
+  CLevelDBBatch batchUpgrade(*this);
+  unsigned int nUpgradePending = 0;
+  unsigned int nUpgraded = 0;
+  unsigned int nLoaded = 0;
+  int64_t nStart = GetTimeMillis();
+  int64_t nLastReport = nStart;
+  int64_t nReadMicros = 0;
+  int64_t nDecodeMicros = 0;
+  int64_t nWaitMicros = 0;
+  int64_t nLinkMicros = 0;
+
+  while (!fEndOfIndex || !dqInFlight.empty()) {
+    boost::this_thread::interruption_point();
+
+    if (!fEndOfIndex) {
+      int64_t nTimeRead = GetTimeMicros();
+      std::shared_ptr<CBlockIndexChunk> chunk = std::make_shared<CBlockIndexChunk>();
+      chunk->vRaw.reserve(nChunkSize);
+      while (chunk->vRaw.size() < nChunkSize) {
+        // the key starts with its one byte type tag, so stop at the first record that is not 'b'
+        if (!pcursor->Valid() || pcursor->key().size() == 0 || pcursor->key().data()[0] != 'b') {
+          fEndOfIndex = true;
+          break;
+        }
         rocksdb::Slice slValue = pcursor->value();
-        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-        CDiskBlockIndex diskindex;
-        ssValue >> diskindex;
+        chunk->vRaw.emplace_back(slValue.data(), slValue.size());
+        pcursor->Next();
+      }
+      nReadMicros += GetTimeMicros() - nTimeRead;
+
+      if (!chunk->vRaw.empty()) {
+        dqInFlight.push_back(chunk);
+        if (pqueue)
+          pqueue->Add(chunk);
+        else
+          DecodeBlockIndexChunk(*chunk);
+      }
+    }
+
+    // Link the oldest chunk once the window is full, and drain everything once the cursor is exhausted
+    while (!dqInFlight.empty() && (fEndOfIndex || dqInFlight.size() >= nMaxInFlight)) {
+      std::shared_ptr<CBlockIndexChunk> chunk = dqInFlight.front();
+      dqInFlight.pop_front();
+      if (pqueue) {
+        int64_t nTimeWait = GetTimeMicros();
+        pqueue->Wait(*chunk);
+        nWaitMicros += GetTimeMicros() - nTimeWait;
+      }
+      if (!chunk->strError.empty()) return error("LoadBlockIndex() : %s", chunk->strError);
+      nDecodeMicros += chunk->nDecodeMicros;
+
+      int64_t nTimeLink = GetTimeMicros();
+      for (size_t i = 0; i < chunk->vIndex.size(); i++) {
+        CDiskBlockIndex& diskindex = chunk->vIndex[i];
+
+        if (chunk->vUpgrade[i]) {
+          batchUpgrade.Write(make_pair('b', diskindex.hashBlock), diskindex);
+          if (++nUpgradePending >= 1000) {
+            if (!WriteBatch(batchUpgrade)) return error("LoadBlockIndex() : failed to write upgraded block index");
+            batchUpgrade.Clear();
+            nUpgraded += nUpgradePending;
+            nUpgradePending = 0;
+          }
+        }
 
         // Construct block index object
-        CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
+        CBlockIndex* pindexNew = InsertBlockIndex(diskindex.hashBlock);
         pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
         pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
         pindexNew->nHeight = diskindex.nHeight;
@@ -208,22 +433,18 @@ bool CBlockTreeDB::LoadBlockIndexGuts() {
 
         // zerocoin
         pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
-        pindexNew->mapZerocoinSupply = diskindex.mapZerocoinSupply;
-        pindexNew->vMintDenominationsInBlock = diskindex.vMintDenominationsInBlock;
+        pindexNew->mapZerocoinSupply.swap(diskindex.mapZerocoinSupply);
+        pindexNew->vMintDenominationsInBlock.swap(diskindex.vMintDenominationsInBlock);
 
         // Proof Of Stake
         pindexNew->nMint = diskindex.nMint;
         pindexNew->nMoneySupply = diskindex.nMoneySupply;
-        pindexNew->nFlags = diskindex.nFlags;
+        pindexNew->nFlags = diskindex.nFlags & ~CBlockIndex::BLOCK_HASH_STORED;
         pindexNew->nStakeModifier = diskindex.nStakeModifier;
         pindexNew->prevoutStake = diskindex.prevoutStake;
         pindexNew->nStakeTime = diskindex.nStakeTime;
         pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
 
-        if (pindexNew->nHeight <= Params().LAST_POW_BLOCK()) {
-          if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
-            return error("LoadBlockIndex() : CheckProofOfWork failed: %s", pindexNew->ToString());
-        }
         // ppcoin: build setStakeSeen
         if (pindexNew->IsProofOfStake()) gStaker.setSeen(make_pair(pindexNew->prevoutStake, pindexNew->nStakeTime));
 
@@ -236,34 +457,58 @@ bool CBlockTreeDB::LoadBlockIndexGuts() {
           nPreviousCheckpoint = pindexNew->nAccumulatorCheckpoint;
         }
 
-        pcursor->Next();
-      } else {
-        break;  // if shutdown requested or finished loading block index
+        if (++nLoaded % 100000 == 0) {
+          int64_t nNow = GetTimeMillis();
+          LogPrintf("%s: loaded %u block index entries (last 100000 in %dms)\n", __func__, nLoaded,
+                    nNow - nLastReport);
+          nLastReport = nNow;
+        }
       }
-    } catch (std::exception& e) { return error("%s : Deserialize or I/O error - %s", __func__, e.what()); }
+      nLinkMicros += GetTimeMicros() - nTimeLink;
+    }
+  }
+
+  if (nUpgradePending > 0) {
+    if (!WriteBatch(batchUpgrade)) return error("LoadBlockIndex() : failed to write upgraded block index");
+    nUpgraded += nUpgradePending;
   }
+  if (nUpgraded > 0) LogPrintf("%s: upgraded %u block index entries to store the block hash\n", __func__, nUpgraded);
+  LogPrintf("%s: loaded %u block index entries in %dms using %d decode threads\n", __func__, nLoaded,
+            GetTimeMillis() - nStart, nThreads);
+  LogPrintf("%s: read %.2fms, decode %.2fms (summed over threads), wait %.2fms, link %.2fms\n", __func__,
+            nReadMicros * 0.001, nDecodeMicros * 0.001, nWaitMicros * 0.001, nLinkMicros * 0.001);
 
   return true;
 }
 
+static const std::vector<CLevelDBFamily> vZerocoinFamilies = {
+    {'m', "zerocoin_mints"}, {'s', "zerocoin_spends"}, {'2', "accumulators"}, {'h', "zerocoin_block_mints"}};
+
 CZerocoinDB::CZerocoinDB(size_t nCacheSize, bool fMemory, bool fWipe)
-    : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe) {}
+    : CLevelDBWrapper(GetDataDir() / "zerocoin", nCacheSize, fMemory, fWipe, vZerocoinFamilies) {}
 
 bool CZerocoinDB::WriteCoinMint(const libzerocoin::PublicCoin& pubCoin, const uint256& hashTx) {
   uint256 hash = GetPubCoinHash(pubCoin.getValue());
   return Write(make_pair('m', hash), hashTx, true);
 }
-bool CZerocoinDB::WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo) {
-  CLevelDBBatch batch;
+bool CZerocoinDB::WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo,
+                                     const uint256& hashBlock, int nHeight) {
+  CLevelDBBatch batch(*this);
   size_t count = 0;
+  std::map<libzerocoin::CoinDenomination, std::vector<CBigNum> > mapBlockMints;
   for (std::vector<std::pair<libzerocoin::PublicCoin, uint256> >::const_iterator it = mintInfo.begin();
        it != mintInfo.end(); it++) {
     libzerocoin::PublicCoin pubCoin = it->first;
     uint256 hash = GetPubCoinHash(pubCoin.getValue());
     batch.Write(make_pair('m', hash), it->second);
+    mapBlockMints[pubCoin.getDenomination()].push_back(pubCoin.getValue());
     ++count;
   }
 
+  // The block hash goes along so that a reader can tell a leftover from a block that was since replaced
+  for (const auto& denomMints : mapBlockMints)
+    batch.Write(make_pair('h', make_pair((int)denomMints.first, nHeight)), make_pair(hashBlock, denomMints.second));
+
   LogPrint(TessaLog::ZERO, "Writing %u coin mints to db.\n", (unsigned int)count);
   return WriteBatch(batch, true);
 }
@@ -281,6 +526,21 @@ bool CZerocoinDB::EraseCoinMint(const CBigNum& bnPubcoin) {
   return Erase(make_pair('m', hash));
 }
 
+bool CZerocoinDB::ReadBlockMints(libzerocoin::CoinDenomination denom, int nHeight, const uint256& hashBlock,
+                                 std::vector<CBigNum>& vPubcoins) {
+  std::pair<uint256, std::vector<CBigNum> > blockMints;
+  if (!Read(make_pair('h', make_pair((int)denom, nHeight)), blockMints) || blockMints.first != hashBlock) return false;
+  vPubcoins.swap(blockMints.second);
+  return true;
+}
+
+bool CZerocoinDB::EraseBlockMints(int nHeight) {
+  CLevelDBBatch batch(*this);
+  for (libzerocoin::CoinDenomination denom : libzerocoin::zerocoinDenomList)
+    batch.Erase(make_pair('h', make_pair((int)denom, nHeight)));
+  return WriteBatch(batch);
+}
+
 bool CZerocoinDB::WriteCoinSpend(const CBigNum& bnSerial, const uint256& txHash) {
   CDataStream ss(SER_GETHASH);
   ss << bnSerial;
@@ -325,9 +585,9 @@ bool CZerocoinDB::EraseCoinSpend(const CBigNum& bnSerial) {
 bool CZerocoinDB::WipeCoins(std::string strType) {
   if (strType != "spends" && strType != "mints") return error("%s: did not recognize type %s", __func__, strType);
 
-  std::unique_ptr<rocksdb::Iterator> pcursor(NewIterator());
-
   char type = (strType == "spends" ? 's' : 'm');
+  std::unique_ptr<rocksdb::Iterator> pcursor(NewIterator(type));
+
   CDataStream ssKeySet(SER_DISK, CLIENT_VERSION);
   ssKeySet << make_pair(type, uint256());
   pcursor->Seek(ssKeySet.str());
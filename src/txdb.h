@@ -20,6 +20,7 @@
 #include <vector>
 
 class CCoins;
+struct CStakeModifierEntry;
 class uint256;
 namespace libzerocoin {
 class PublicCoin;
@@ -31,6 +32,10 @@ static const int64_t nDefaultDbCache = 100;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 4096 : 1024;
 //! min. -dbcache in (MiB)
 static const int64_t nMinDbCache = 4;
+//! -loadindexthreads default (0 = auto)
+static const int DEFAULT_LOADINDEX_THREADS = 0;
+//! max. -loadindexthreads
+static const int MAX_LOADINDEX_THREADS = 32;
 
 /** CCoinsView backed by the LevelDB coin database (chainstate/) */
 class CCoinsViewDB : public CCoinsView {
@@ -41,6 +46,7 @@ class CCoinsViewDB : public CCoinsView {
   CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
   bool GetCoins(const uint256& txid, CCoins& coins) const;
+  void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins, std::vector<bool>& vFound) const;
   bool HaveCoins(const uint256& txid) const;
   uint256 GetBestBlock() const;
   bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock);
@@ -70,7 +76,10 @@ class CBlockTreeDB : public CLevelDBWrapper {
   bool ReadFlag(const std::string& name, bool& fValue);
   bool WriteInt(const std::string& name, int nValue);
   bool ReadInt(const std::string& name, int& nValue);
-  bool LoadBlockIndexGuts();
+  bool WriteStakeModifiers(const std::vector<std::pair<uint256, CStakeModifierEntry> >& vWrite,
+                           const std::vector<uint256>& vErase);
+  bool ReadStakeModifiers(std::vector<std::pair<uint256, CStakeModifierEntry> >& vEntries);
+  bool LoadBlockIndexGuts(int nThreads = 1);
 };
 
 class CZerocoinDB : public CLevelDBWrapper {
@@ -82,7 +91,9 @@ class CZerocoinDB : public CLevelDBWrapper {
   void operator=(const CZerocoinDB&);
 
  public:
-  bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo);
+  //! Record the mints of the block hashBlock at nHeight, and index their pubcoins by denomination and height
+  bool WriteCoinMintBatch(const std::vector<std::pair<libzerocoin::PublicCoin, uint256> >& mintInfo,
+                          const uint256& hashBlock, int nHeight);
   //  bool WriteCoinSpendBatch(const std::vector<std::pair<libzerocoin::CoinSpend, uint256> >& spendInfo);
   bool WriteCoinMint(const libzerocoin::PublicCoin& pubCoin, const uint256& txHash);
   bool ReadCoinMint(const CBigNum& bnPubcoin, uint256& txHash);
@@ -91,6 +102,10 @@ class CZerocoinDB : public CLevelDBWrapper {
   bool ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash);
   bool ReadCoinSpend(const uint256& hashSerial, uint256& txHash);
   bool EraseCoinMint(const CBigNum& bnPubcoin);
+  //! Pubcoins of denom minted at nHeight, false unless they were indexed for block hashBlock
+  bool ReadBlockMints(libzerocoin::CoinDenomination denom, int nHeight, const uint256& hashBlock,
+                      std::vector<CBigNum>& vPubcoins);
+  bool EraseBlockMints(int nHeight);
   bool EraseCoinSpend(const CBigNum& bnSerial);
   bool WipeCoins(std::string strType);
   bool WriteAccumulatorValue(const uint32_t& nChecksum, const CBigNum& bnValue);
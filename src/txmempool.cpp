@@ -612,4 +612,34 @@ bool CCoinsViewMemPool::GetCoins(const uint256& txid, CCoins& coins) const {
   return (base->GetCoins(txid, coins) && !coins.IsPruned());
 }
 
+void CCoinsViewMemPool::GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins,
+                                     std::vector<bool>& vFound) const {
+  vCoins.assign(vTxid.size(), CCoins());
+  vFound.assign(vTxid.size(), false);
+
+  // Same precedence as GetCoins: mempool entries first, the rest in one batch from base
+  std::vector<uint256> vMissing;
+  std::vector<size_t> vMissingPos;
+  for (size_t i = 0; i < vTxid.size(); i++) {
+    CTransaction tx;
+    if (mempool.lookup(vTxid[i], tx)) {
+      vCoins[i] = CCoins(tx, MEMPOOL_HEIGHT);
+      vFound[i] = true;
+      continue;
+    }
+    vMissing.push_back(vTxid[i]);
+    vMissingPos.push_back(i);
+  }
+  if (vMissing.empty()) return;
+
+  std::vector<CCoins> vBaseCoins;
+  std::vector<bool> vBaseFound;
+  base->GetCoinsMany(vMissing, vBaseCoins, vBaseFound);
+  for (size_t i = 0; i < vMissing.size(); i++) {
+    if (!vBaseFound[i] || vBaseCoins[i].IsPruned()) continue;
+    vBaseCoins[i].swap(vCoins[vMissingPos[i]]);
+    vFound[vMissingPos[i]] = true;
+  }
+}
+
 bool CCoinsViewMemPool::HaveCoins(const uint256& txid) const { return mempool.exists(txid) || base->HaveCoins(txid); }
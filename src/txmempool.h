@@ -169,6 +169,7 @@ class CCoinsViewMemPool : public CCoinsViewBacked {
  public:
   CCoinsViewMemPool(CCoinsView* baseIn, CTxMemPool& mempoolIn);
   bool GetCoins(const uint256& txid, CCoins& coins) const;
+  void GetCoinsMany(const std::vector<uint256>& vTxid, std::vector<CCoins>& vCoins, std::vector<bool>& vFound) const;
   bool HaveCoins(const uint256& txid) const;
 };
 
@@ -1637,9 +1637,11 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int
 
   if (GetAdjustedTime() - chainActive.Tip()->GetBlockTime() < 60) MilliSleep(10000);
 
-  CAmount nCredit = 0;
-  CScript scriptPubKeyKernel;
-  bool fKernelFound = false;
+  // Gather the fixed part of every input's kernel first, the hashing then runs on the proof worker threads
+  std::vector<CStakeInput*> vInputs;
+  std::vector<CStakeKernel> vKernels;
+  vInputs.reserve(listInputs.size());
+  vKernels.reserve(listInputs.size());
   for (std::unique_ptr<CStakeInput>& stakeInput : listInputs) {
     // Make sure the wallet is unlocked and shutdown hasn't been requested
     if (IsLocked() || ShutdownRequested()) return false;
@@ -1651,13 +1653,33 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int
       continue;
     }
 
-    // Read block header
-    CBlockHeader block = pindex->GetBlockHeader();
+    // grab stake modifier
+    uint64_t nStakeModifier = 0;
+    if (!stakeInput->GetModifier(nStakeModifier)) {
+      LogPrintf("%s : failed to get kernel stake modifier\n", __func__);
+      continue;
+    }
+
+    vKernels.emplace_back(stakeInput->GetUniqueness(), stakeInput->GetValue(), nStakeModifier, pindex->GetBlockTime());
+    vInputs.push_back(stakeInput.get());
+  }
+
+  CAmount nCredit = 0;
+  CScript scriptPubKeyKernel;
+  bool fKernelFound = false;
+  size_t nNextInput = 0;
+  while (nNextInput < vKernels.size()) {
+    // Make sure the wallet is unlocked and shutdown hasn't been requested
+    if (IsLocked() || ShutdownRequested()) return false;
+
     uint256 hashProofOfStake;
     nTxNewTime = GetAdjustedTime();
+    const int nFound = FindStakeKernel(vKernels, nNextInput, nBits, nTxNewTime, hashProofOfStake);
+    if (nFound < 0) break;
+    nNextInput = nFound + 1;
+    CStakeInput* stakeInput = vInputs[nFound];
 
-    // iterates each utxo inside of CheckStakeKernelHash()
-    if (Stake(stakeInput.get(), nBits, block.GetBlockTime(), nTxNewTime, hashProofOfStake)) {
+    {
       LOCK(cs_main);
       // Double check that this will pass time requirements
       if (nTxNewTime <= chainActive.Tip()->GetMedianTimePast()) {
@@ -1713,7 +1735,6 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, unsigned int nBits, int
       fKernelFound = true;
       break;
     }
-    if (fKernelFound) break;  // if kernel is found stop searching
   }
   if (!fKernelFound) return false;
 
@@ -1907,6 +1928,21 @@ bool CWallet::SetDefaultKey(const CPubKey& vchPubKey) {
   return true;
 }
 
+void CWallet::RollbackKeyPool(const std::set<int64_t>& setKeyPoolOld, const CHDChain& hdChainOld,
+                              const std::vector<CPubKey>& vNewKeys) {
+  AssertLockHeld(cs_wallet);
+  {
+    LOCK(cs_KeyStore);
+    for (const CPubKey& pubkey : vNewKeys) {
+      mapKeys.erase(pubkey.GetID());
+      mapCryptedKeys.erase(pubkey.GetID());
+    }
+  }
+  for (const CPubKey& pubkey : vNewKeys) mapKeyMetadata.erase(pubkey.GetID());
+  hdChain = hdChainOld;
+  setKeyPool = setKeyPoolOld;
+}
+
 /**
  * Mark old keypool keys as used,
  * and generate all new keys
@@ -1914,18 +1950,37 @@ bool CWallet::SetDefaultKey(const CPubKey& vchPubKey) {
 bool CWallet::NewKeyPool() {
   {
     LOCK(cs_wallet);
+    const std::set<int64_t> setKeyPoolOld = setKeyPool;
+    const CHDChain hdChainOld = hdChain;
+    std::vector<CPubKey> vNewKeys;
+    CDBBatch batch(gWalletDB);
     for (int64_t nIndex : setKeyPool) gWalletDB.ErasePool(nIndex);
     setKeyPool.clear();
 
-    if (IsLocked()) return false;
+    if (IsLocked()) {
+      if (!batch.Commit()) {
+        RollbackKeyPool(setKeyPoolOld, hdChainOld, vNewKeys);
+        return error("CWallet::NewKeyPool() : erasing old keypool failed");
+      }
+      return false;
+    }
 
     int64_t nKeys = max(GetArg("-keypool", KEY_RES_SIZE), (int64_t)0);
-    for (int i = 0; i < nKeys; i++) {
-      int64_t nIndex = i + 1;
-      gWalletDB.WritePool(nIndex, CKeyPool(GenerateNewKey()));
-      setKeyPool.insert(nIndex);
+    try {
+      for (int i = 0; i < nKeys; i++) {
+        int64_t nIndex = i + 1;
+        vNewKeys.push_back(GenerateNewKey());
+        gWalletDB.WritePool(nIndex, CKeyPool(vNewKeys.back()));
+        setKeyPool.insert(nIndex);
+      }
+    } catch (const std::exception&) {
+      RollbackKeyPool(setKeyPoolOld, hdChainOld, vNewKeys);
+      throw;
+    }
+    if (!batch.Commit()) {
+      RollbackKeyPool(setKeyPoolOld, hdChainOld, vNewKeys);
+      return error("CWallet::NewKeyPool() : writing new keypool failed");
     }
-    // gWalletDB.TxnCommit();
     LogPrintf("CWallet::NewKeyPool wrote %d new keys\n", nKeys);
   }
   return true;
@@ -1944,18 +1999,30 @@ bool CWallet::TopUpKeyPool(unsigned int kpSize) {
     else
       nTargetSize = max(GetArg("-keypool", KEY_RES_SIZE), (int64_t)0);
 
-    while (setKeyPool.size() < (nTargetSize + 1)) {
-      int64_t nEnd = 1;
-      if (!setKeyPool.empty()) nEnd = *(--setKeyPool.end()) + 1;
-      if (!gWalletDB.WritePool(nEnd, CKeyPool(GenerateNewKey())))
-        throw runtime_error("TopUpKeyPool() : writing generated key failed");
-      setKeyPool.insert(nEnd);
-      LogPrintf("keypool added key %d, size=%u\n", nEnd, setKeyPool.size());
-      double dProgress = 100.f * nEnd / (nTargetSize + 1);
-      std::string strMsg = strprintf(_("Loading wallet... (%3.2f %%)"), dProgress);
-      uiInterface.InitMessage(strMsg);
+    // Nothing generated below reaches the wallet file unless the batch
+    // commits, so every failure path undoes the in-memory changes as well
+    const std::set<int64_t> setKeyPoolOld = setKeyPool;
+    const CHDChain hdChainOld = hdChain;
+    std::vector<CPubKey> vNewKeys;
+    CDBBatch batch(gWalletDB);
+    try {
+      while (setKeyPool.size() < (nTargetSize + 1)) {
+        int64_t nEnd = 1;
+        if (!setKeyPool.empty()) nEnd = *(--setKeyPool.end()) + 1;
+        vNewKeys.push_back(GenerateNewKey());
+        if (!gWalletDB.WritePool(nEnd, CKeyPool(vNewKeys.back())))
+          throw runtime_error("TopUpKeyPool() : writing generated key failed");
+        setKeyPool.insert(nEnd);
+        LogPrintf("keypool added key %d, size=%u\n", nEnd, setKeyPool.size());
+        double dProgress = 100.f * nEnd / (nTargetSize + 1);
+        std::string strMsg = strprintf(_("Loading wallet... (%3.2f %%)"), dProgress);
+        uiInterface.InitMessage(strMsg);
+      }
+      if (!batch.Commit()) throw runtime_error("TopUpKeyPool() : committing generated keys failed");
+    } catch (const std::exception&) {
+      RollbackKeyPool(setKeyPoolOld, hdChainOld, vNewKeys);
+      throw;
     }
-    // gWalletDB.TxnCommit();
   }
   return true;
 }
@@ -2817,8 +2884,10 @@ bool CWallet::MintToTxIn(CZerocoinMint zerocoinSelected, int nSecurityLevel, con
   libzerocoin::AccumulatorWitness witness(paramsAccumulator, accumulator, pubCoinSelected);
   string strFailReason = "";
   int nMintsAdded = 0;
+  CMintWitness mintWitness;
+  bool fCachedWitness = zkpTracker->GetWitness(GetPubCoinHash(pubCoinSelected.getValue()), mintWitness);
   if (!GenerateAccumulatorWitness(pubCoinSelected, accumulator, witness, nSecurityLevel, nMintsAdded, strFailReason,
-                                  pindexCheckpoint)) {
+                                  pindexCheckpoint, fCachedWitness ? &mintWitness : nullptr)) {
     receipt.SetStatus(_("Try to spend with a higher security level to include more coins"),
                       ZKP_FAILED_ACCUMULATOR_INITIALIZATION);
     return error("%s : %s", __func__, receipt.GetStatusMessage());
@@ -3402,6 +3471,129 @@ bool CWallet::SetMintUnspent(const CBigNum& bnSerial) {
   return true;
 }
 
+void CWallet::UpdatedBlockTip(const CBlockIndex* pindex) { fMintWitnessesStale = true; }
+
+void CWallet::UpdateMintWitnesses() {
+  if (!zwalletMain || !zkpTracker || !fMintWitnessesStale.exchange(false)) return;
+
+  struct WitnessJob {
+    uint256 hashPubcoin;
+    CMintWitness mintWitness;
+    std::vector<CWitnessBlock> vBlocks;
+    //! No witness was cached, the pubcoin was regenerated for it
+    bool fNew = false;
+  };
+  std::vector<WitnessJob> vJobs;
+  std::vector<uint256> vFailed;
+  std::set<uint256> setUnspent;
+  bool fMore = false;
+  int nHeightEnd;
+  {
+    LOCK(cs_main);
+    nHeightEnd = GetWitnessStopHeight();
+  }
+
+  {
+    // Regenerating a mint is a full prime search, it runs without cs_main and only a few times per run
+    LOCK(cs_wallet);
+    const int64_t nNow = GetTime();
+    int nRegenerated = 0;
+    for (const CMintMeta& meta : zkpTracker->GetMints(true)) {
+      if (!meta.nHeight || meta.nHeight >= nHeightEnd) continue;
+      setUnspent.insert(meta.hashPubcoin);
+      auto it = mapWitnessRetry.find(meta.hashPubcoin);
+      if (it != mapWitnessRetry.end() && it->second.second > nNow) {
+        fMore = true;
+        continue;
+      }
+
+      WitnessJob job;
+      job.hashPubcoin = meta.hashPubcoin;
+      if (!zkpTracker->GetWitness(meta.hashPubcoin, job.mintWitness)) {
+        // the pubcoin is needed once, to start the witness
+        if (IsLocked() || nRegenerated >= MAX_WITNESS_REGENERATIONS_PER_UPDATE) {
+          fMore = true;
+          continue;
+        }
+        nRegenerated++;
+        CDeterministicMint dMint;
+        CZerocoinMint mint;
+        if (!gWalletDB.ReadDeterministicMint(meta.hashPubcoin, dMint) || !zwalletMain->RegenerateMint(dMint, mint)) {
+          LogPrint(TessaLog::ZERO, "%s: could not regenerate mint %s\n", __func__, meta.hashPubcoin.GetHex());
+          vFailed.push_back(meta.hashPubcoin);
+          continue;
+        }
+        job.mintWitness.bnPubcoin = mint.GetValue();
+        job.mintWitness.denom = mint.GetDenomination();
+        job.fNew = true;
+      }
+      vJobs.push_back(std::move(job));
+    }
+  }
+
+  {
+    // Only list the blocks here, reading and accumulating them does not need the locks
+    LOCK(cs_main);
+    size_t nBudget = MAX_WITNESS_BLOCKS_PER_UPDATE;
+    for (WitnessJob& job : vJobs) {
+      // a new witness is still started, so that its regenerated pubcoin is kept
+      if (!nBudget && !job.fNew) {
+        fMore = true;
+        job.hashPubcoin.SetNull();
+        continue;
+      }
+      libzerocoin::PublicCoin coin(job.mintWitness.bnPubcoin, job.mintWitness.denom);
+      if (!SnapshotMintWitness(coin, job.mintWitness, nHeightEnd, nBudget, job.vBlocks)) {
+        LogPrint(TessaLog::ZERO, "%s: could not start witness of %s\n", __func__, job.hashPubcoin.GetHex());
+        vFailed.push_back(job.hashPubcoin);
+        job.hashPubcoin.SetNull();
+        continue;
+      }
+      nBudget -= job.vBlocks.size();
+      if (job.mintWitness.nHeight + (int)job.vBlocks.size() < nHeightEnd) fMore = true;
+    }
+  }
+
+  for (WitnessJob& job : vJobs) {
+    if (job.hashPubcoin.IsNull()) continue;
+    libzerocoin::PublicCoin coin(job.mintWitness.bnPubcoin, job.mintWitness.denom);
+    if (!AddBlocksToMintWitness(coin, job.mintWitness, job.vBlocks)) {
+      LogPrint(TessaLog::ZERO, "%s: could not advance witness of %s\n", __func__, job.hashPubcoin.GetHex());
+      vFailed.push_back(job.hashPubcoin);
+      job.hashPubcoin.SetNull();
+    }
+  }
+
+  {
+    LOCK(cs_wallet);
+    for (const WitnessJob& job : vJobs) {
+      // a spend may have used the mint while the locks were released
+      if (job.hashPubcoin.IsNull() || !zkpTracker->HasPubcoinHash(job.hashPubcoin)) continue;
+      mapWitnessRetry.erase(job.hashPubcoin);
+      CMintMeta meta = zkpTracker->GetMetaFromPubcoin(job.hashPubcoin);
+      if (!meta.isUsed && !meta.isArchived) zkpTracker->SetWitness(job.hashPubcoin, job.mintWitness);
+    }
+
+    // Failures can be passing, e.g. a reorg under the snapshot, so retry them with a growing delay
+    const int64_t nNow = GetTime();
+    for (const uint256& hashPubcoin : vFailed) {
+      std::pair<int, int64_t>& retry = mapWitnessRetry[hashPubcoin];
+      retry.second = nNow + (WITNESS_UPDATE_INTERVAL << std::min(retry.first, MAX_WITNESS_RETRY_BACKOFF));
+      retry.first++;
+    }
+    for (auto it = mapWitnessRetry.begin(); it != mapWitnessRetry.end();) {
+      if (setUnspent.count(it->first))
+        ++it;
+      else
+        it = mapWitnessRetry.erase(it);
+    }
+    zkpTracker->PruneWitnesses(setUnspent);
+  }
+
+  // a reorg while accumulating is caught by the next run, SnapshotMintWitness() starts such a witness over
+  if (fMore || !vFailed.empty()) fMintWitnessesStale = true;
+}
+
 //----- HD Stuff ------------
 
 CPubKey CWallet::GenerateNewHDMasterKey() {
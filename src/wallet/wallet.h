@@ -34,6 +34,7 @@
 #include "zerowallet.h"
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <set>
 #include <stdexcept>
@@ -59,6 +60,14 @@ static const int DEFAULT_CUSTOMBACKUPTHRESHOLD = 1;
 
 //! if set, all keys will be derived by using BIP32
 static const bool DEFAULT_USE_HD_WALLET = true;
+//! Most blocks all mint witnesses together are carried forward by per update, so that catching up is spread out
+static const int MAX_WITNESS_BLOCKS_PER_UPDATE = 1000;
+//! Seconds between background updates of the mint witnesses
+static const int64_t WITNESS_UPDATE_INTERVAL = 10;
+//! Most mints whose pubcoin is regenerated to start a witness per update
+static const int MAX_WITNESS_REGENERATIONS_PER_UPDATE = 4;
+//! A mint whose witness failed waits WITNESS_UPDATE_INTERVAL << min(failures, this) seconds before the next try
+static const int MAX_WITNESS_RETRY_BACKOFF = 8;
 
 class CCoinControl;
 class COutput;
@@ -109,6 +118,10 @@ class CWallet : public CCryptoKeyStore, public CValidationInterface {
 
   void SyncMetaData(std::pair<TxSpends::iterator, TxSpends::iterator>);
 
+  //! Undo the in-memory side of a keypool batch whose commit failed
+  void RollbackKeyPool(const std::set<int64_t>& setKeyPoolOld, const CHDChain& hdChainOld,
+                       const std::vector<ecdsa::CPubKey>& vNewKeys);
+
  public:
   bool MintableCoins();
   bool SelectStakeCoins(std::list<std::unique_ptr<CStakeInput> >& listInputs, CAmount nTargetAmount);
@@ -141,6 +154,11 @@ class CWallet : public CCryptoKeyStore, public CValidationInterface {
   bool SetMintUnspent(const CBigNum& bnSerial);
   bool UpdateMint(const CBigNum& bnValue, const int& nHeight, const uint256& txid,
                   const libzerocoin::CoinDenomination& denom);
+  /**
+   * Carry the witnesses of the confirmed unspent mints forward to the height a spend would stop at, if the tip
+   * moved since the last run. Run from the scheduler: the blocks are accumulated without cs_main or cs_wallet.
+   */
+  void UpdateMintWitnesses();
   std::string GetUniqueWalletBackupName(bool fzkpAuto) const;
 
   /** Zerocin entry changed.
@@ -171,6 +189,10 @@ class CWallet : public CCryptoKeyStore, public CValidationInterface {
   void DeriveNewChildKey(CWalletDB& walletdb, CKeyMetadata& metadata, ecdsa::CKey& secret, bool internal = false);
 
   std::unique_ptr<CZeroTracker> zkpTracker;
+  //! The tip moved, or the last witness update ran out of budget
+  std::atomic<bool> fMintWitnessesStale;
+  //! Mints whose witness update failed, with the number of failures and the time of the next try
+  std::map<uint256, std::pair<int, int64_t> > mapWitnessRetry;
 
   std::set<int64_t> setKeyPool;
   std::map<ecdsa::CKeyID, CKeyMetadata> mapKeyMetadata;
@@ -215,6 +237,7 @@ class CWallet : public CCryptoKeyStore, public CValidationInterface {
     nNextResend = 0;
     nLastResend = 0;
     nTimeFirstKey = 0;
+    fMintWitnessesStale = true;
     fWalletUnlockAnonymizeOnly = false;
     fBackupMints = false;
 
@@ -359,6 +382,7 @@ class CWallet : public CCryptoKeyStore, public CValidationInterface {
   void MarkDirty();
   bool AddToWallet(const CWalletTx& wtxIn, bool fFromLoadWallet = false);
   void SyncTransaction(const CTransaction& tx, const CBlock* pblock);
+  void UpdatedBlockTip(const CBlockIndex* pindex);
   bool AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate);
   void EraseFromWallet(const uint256& hash);
   int ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate = false);
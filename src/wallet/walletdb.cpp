@@ -9,6 +9,8 @@
 #include "walletdb.h"
 #include "walletkey.h"
 
+#include "accumulators.h"
+
 #include "base58.h"
 #include "fs.h"
 #include "protocol.h"
@@ -753,6 +755,18 @@ bool CWalletDB::EraseDeterministicMint(const uint256& hashPubcoin) {
   return Erase(make_pair(string("dzkp"), hashPubcoin));
 }
 
+bool CWalletDB::WriteMintWitness(const uint256& hashPubcoin, const CMintWitness& mintWitness) {
+  return Write(make_pair(string("zkpwitness"), hashPubcoin), mintWitness);
+}
+
+bool CWalletDB::ReadMintWitness(const uint256& hashPubcoin, CMintWitness& mintWitness) {
+  return Read(make_pair(string("zkpwitness"), hashPubcoin), mintWitness);
+}
+
+bool CWalletDB::EraseMintWitness(const uint256& hashPubcoin) {
+  return Erase(make_pair(string("zkpwitness"), hashPubcoin));
+}
+
 bool CWalletDB::ArchiveMintOrphan(const CZerocoinMint& zerocoinMint) {
   CDataStream ss(SER_GETHASH);
   ss << zerocoinMint.GetValue();
@@ -909,6 +923,39 @@ std::list<CDeterministicMint> CWalletDB::ListDeterministicMints() {
   return listMints;
 }
 
+std::list<uint256> CWalletDB::ListMintWitnesses() {
+  std::list<uint256> listPubcoinHashes;
+  auto pcursor = GetCursor();
+  if (!pcursor) throw runtime_error(std::string(__func__) + " : cannot create DB cursor");
+  unsigned int fFlags = MDB_SET_RANGE;
+  for (;;) {
+    // Read next record
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    if (fFlags == MDB_SET_RANGE) ssKey << make_pair(string("zkpwitness"), uint256());
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+    int ret = ReadAtCursor(pcursor, ssKey, ssValue, fFlags);
+    fFlags = MDB_NEXT;
+    if (ret == MDB_NOTFOUND)
+      break;
+    else if (ret != 0) {
+      cursor_close(pcursor);
+      throw runtime_error(std::string(__func__) + " : error scanning DB");
+    }
+
+    // Unserialize
+    string strType;
+    ssKey >> strType;
+    if (strType != "zkpwitness") break;
+
+    uint256 hashPubcoin;
+    ssKey >> hashPubcoin;
+    listPubcoinHashes.emplace_back(hashPubcoin);
+  }
+
+  cursor_close(pcursor);
+  return listPubcoinHashes;
+}
+
 std::list<CZerocoinSpend> CWalletDB::ListSpentCoins() {
   std::list<CZerocoinSpend> listCoinSpend;
   auto pcursor = GetCursor();
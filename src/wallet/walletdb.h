@@ -26,6 +26,7 @@ class CAccount;
 class CAccountingEntry;
 struct CBlockLocator;
 class CKeyPool;
+class CMintWitness;
 class CMasterKey;
 class CScript;
 class CWallet;
@@ -195,6 +196,10 @@ class CWalletDB : public CDB {
   bool ReadZKPCount(uint32_t& nCount);
   std::map<uint256, std::vector<std::pair<uint256, uint32_t> > > MapMintPool();
   bool WriteMintPoolPair(const uint256& hashMasterSeed, const uint256& hashPubcoin, const uint32_t& nCount);
+  bool WriteMintWitness(const uint256& hashPubcoin, const CMintWitness& mintWitness);
+  bool ReadMintWitness(const uint256& hashPubcoin, CMintWitness& mintWitness);
+  bool EraseMintWitness(const uint256& hashPubcoin);
+  std::list<uint256> ListMintWitnesses();
 
  private:
   CWalletDB(const CWalletDB&);
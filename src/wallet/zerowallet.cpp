@@ -5,6 +5,7 @@
 
 #include "zerowallet.h"
 #include "init.h"
+#include "libzerocoin/ParallelFor.h"
 #include "libzerocoin/PrivateCoin.h"
 #include "main.h"
 #include "primitives/deterministicmint.h"
@@ -84,9 +85,9 @@ void CZeroWallet::AddToMintPool(const std::pair<uint256, uint32_t>& pMint, bool
 }
 
 // Add the next ZMINTS_TO_ADD mints to the mint pool
-void CZeroWallet::GenerateZMintPool(uint32_t nCountStart, uint32_t nCountEnd) {
+bool CZeroWallet::GenerateZMintPool(uint32_t nCountStart, uint32_t nCountEnd) {
   // Is locked
-  if (seedMaster.IsNull()) return;
+  if (seedMaster.IsNull()) return true;
 
   uint32_t n = nCountLastUsed + 1;
 
@@ -95,37 +96,48 @@ void CZeroWallet::GenerateZMintPool(uint32_t nCountStart, uint32_t nCountEnd) {
   uint32_t nStop = n + ZMINTS_TO_ADD;
   if (nCountEnd > 0) nStop = std::max(n, n + nCountEnd);
 
-  bool fFound;
+  // Prevent unnecessary repeated minted
+  std::vector<uint32_t> vCounts;
+  for (uint32_t i = n; i < nStop; ++i) {
+    if (!mintPool.HasCount(i)) vCounts.push_back(i);
+  }
+  if (vCounts.empty()) return true;
 
   uint256 hashSeed = Hash(seedMaster.begin(), seedMaster.end());
   LogPrint(TessaLog::ZERO, "%s : n=%d nStop=%d, diff = %d\n", __func__, n, nStop - 1, nStop - n);
   int64_t nTime_ref = GetTimeMillis();
-  for (uint32_t i = n; i < nStop; ++i) {
-    if (ShutdownRequested()) return;
-
-    fFound = false;
-
-    // Prevent unnecessary repeated minted
-    for (auto& pair : mintPool) {
-      if (pair.second == i) {
-        fFound = true;
-        break;
-      }
-    }
-
-    if (fFound) continue;
-    int64_t nTime_delta = GetTimeMillis();
 
-    uint512 seedZerocoin = GetZerocoinSeed(i);
+  // Each coin is a prime search of its own, so they are derived on the zkp worker threads
+  std::vector<CBigNum> vValues(vCounts.size());
+  std::vector<char> vDone(vCounts.size(), false);
+  libzerocoin::ParallelFor(vCounts.size(), [&](size_t i) {
+    if (ShutdownRequested()) return;
     libzerocoin::PrivateCoin MintedCoin(libzerocoin::gpZerocoinParams);
-    CBigNum bnValue = MintedCoin.CoinFromSeed(seedZerocoin);
+    vValues[i] = MintedCoin.CoinFromSeed(GetZerocoinSeed(vCounts[i]));
+    vDone[i] = true;
+  });
 
-    mintPool.Add(bnValue, i);
-    gWalletDB.WriteMintPoolPair(hashSeed, GetPubCoinHash(bnValue), i);
-    int64_t now = GetTimeMillis();
-    LogPrint(TessaLog::ZERO, "%s : %s count=%d, time total= %d (ms), this coin time = %d (ms)\n", __func__,
-             bnValue.GetHex().substr(0, 6), i, now - nTime_ref, now - nTime_delta);
+  std::vector<std::pair<uint256, uint32_t> > vGenerated;
+  for (size_t i = 0; i < vCounts.size(); ++i) {
+    if (vDone[i]) vGenerated.push_back(std::make_pair(GetPubCoinHash(vValues[i]), vCounts[i]));
   }
+  LogPrint(TessaLog::ZERO, "%s : generated %d mints, time total= %d (ms)\n", __func__, vGenerated.size(),
+           GetTimeMillis() - nTime_ref);
+
+  // Mints derived before a shutdown are still kept, in one commit, and only join the pool once they are written
+  if (vGenerated.empty()) return true;
+  {
+    CDBBatch batch(gWalletDB);
+    for (const auto& pMint : vGenerated) {
+      if (!gWalletDB.WriteMintPoolPair(hashSeed, pMint.first, pMint.second))
+        return error("%s : failed to write mint pool to wallet db", __func__);
+    }
+    if (!batch.Commit()) return error("%s : failed to write mint pool to wallet db", __func__);
+  }
+  for (size_t i = 0; i < vCounts.size(); ++i) {
+    if (vDone[i]) mintPool.Add(vValues[i], vCounts[i]);
+  }
+  return true;
 }
 
 // pubcoin hashes are stored to db so that a full accounting of mints belonging to the seed can be tracked without
@@ -206,35 +206,36 @@ std::string ReindexZerocoinDB() {
     CBlock block;
     if (!ReadBlockFromDisk(block, pindex)) { return _("Reindexing zerocoin failed"); }
 
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints;
     for (const CTransaction& tx : block.vtx) {
-      for (unsigned int i = 0; i < tx.vin.size(); i++) {
-        if (tx.IsCoinBase()) break;
-
-        if (tx.ContainsZerocoins()) {
-          uint256 txid = tx.GetHash();
-          // Record Serials
-          if (tx.IsZerocoinSpend()) {
-            for (auto& in : tx.vin) {
-              if (!in.scriptSig.IsZerocoinSpend()) continue;
-
-              libzerocoin::CoinSpend spend = TxInToZerocoinSpend(in);
-              zerocoinDB->WriteCoinSpend(spend.getCoinSerialNumber(), txid);
-            }
-          }
-
-          // Record mints
-          if (tx.IsZerocoinMint()) {
-            for (auto& out : tx.vout) {
-              if (!out.IsZerocoinMint()) continue;
-
-              CValidationState state;
-              libzerocoin::PublicCoin coin;
-              TxOutToPublicCoin(out, coin, state);
-              zerocoinDB->WriteCoinMint(coin, txid);
-            }
-          }
+      // one pass per transaction, so that each mint is indexed once
+      if (tx.IsCoinBase() || !tx.ContainsZerocoins()) continue;
+
+      uint256 txid = tx.GetHash();
+      // Record Serials
+      if (tx.IsZerocoinSpend()) {
+        for (auto& in : tx.vin) {
+          if (!in.scriptSig.IsZerocoinSpend()) continue;
+
+          libzerocoin::CoinSpend spend = TxInToZerocoinSpend(in);
+          zerocoinDB->WriteCoinSpend(spend.getCoinSerialNumber(), txid);
         }
       }
+
+      // Record mints
+      if (tx.IsZerocoinMint()) {
+        for (auto& out : tx.vout) {
+          if (!out.IsZerocoinMint()) continue;
+
+          CValidationState state;
+          libzerocoin::PublicCoin coin;
+          TxOutToPublicCoin(out, coin, state);
+          vMints.emplace_back(coin, txid);
+        }
+      }
+    }
+    if (!zerocoinDB->WriteCoinMintBatch(vMints, pindex->GetBlockHash(), pindex->nHeight)) {
+      return _("Reindexing zerocoin failed");
     }
     pindex = chainActive.Next(pindex);
   }
@@ -35,6 +35,7 @@ void CZeroTracker::Init() {
 
 bool CZeroTracker::Archive(CMintMeta& meta) {
   if (mapSerialHashes.count(meta.hashSerial)) mapSerialHashes.at(meta.hashSerial).isArchived = true;
+  EraseWitness(meta.hashPubcoin);
 
   CDeterministicMint dMint;
   if (!gWalletDB.ReadDeterministicMint(meta.hashPubcoin, dMint))
@@ -183,10 +184,44 @@ bool CZeroTracker::UpdateState(const CMintMeta& meta) {
     return error("%s: failed to update deterministic mint when writing to db", __func__);
 
   mapSerialHashes[meta.hashSerial] = meta;
+  if (meta.isUsed || meta.isArchived) EraseWitness(meta.hashPubcoin);
 
   return true;
 }
 
+bool CZeroTracker::GetWitness(const uint256& hashPubcoin, CMintWitness& mintWitness) {
+  auto it = mapWitnesses.find(hashPubcoin);
+  if (it != mapWitnesses.end()) {
+    mintWitness = it->second;
+    return true;
+  }
+
+  if (!gWalletDB.ReadMintWitness(hashPubcoin, mintWitness)) return false;
+  mapWitnesses[hashPubcoin] = mintWitness;
+  return true;
+}
+
+void CZeroTracker::SetWitness(const uint256& hashPubcoin, const CMintWitness& mintWitness) {
+  mapWitnesses[hashPubcoin] = mintWitness;
+  if (!gWalletDB.WriteMintWitness(hashPubcoin, mintWitness))
+    LogPrintf("%s: failed to write witness for pubcoinhash %s\n", __func__, hashPubcoin.GetHex());
+}
+
+void CZeroTracker::EraseWitness(const uint256& hashPubcoin) {
+  mapWitnesses.erase(hashPubcoin);
+  gWalletDB.EraseMintWitness(hashPubcoin);
+}
+
+void CZeroTracker::PruneWitnesses(const std::set<uint256>& setKeep) {
+  std::vector<uint256> vErase;
+  for (const auto& it : mapWitnesses)
+    if (!setKeep.count(it.first)) vErase.emplace_back(it.first);
+  // Witnesses written before a restart are only in the wallet
+  for (const uint256& hashPubcoin : gWalletDB.ListMintWitnesses())
+    if (!setKeep.count(hashPubcoin) && !mapWitnesses.count(hashPubcoin)) vErase.emplace_back(hashPubcoin);
+  for (const uint256& hashPubcoin : vErase) EraseWitness(hashPubcoin);
+}
+
 void CZeroTracker::Add(const CDeterministicMint& dMint, bool isNew, bool isArchived) {
   CMintMeta meta;
   meta.hashPubcoin = dMint.GetPubcoinHash();
@@ -355,4 +390,7 @@ std::set<CMintMeta> CZeroTracker::ListMints(bool fUnusedOnly, bool fMatureOnly,
   return setMints;
 }
 
-void CZeroTracker::Clear() { mapSerialHashes.clear(); }
+void CZeroTracker::Clear() {
+  mapSerialHashes.clear();
+  mapWitnesses.clear();
+}
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "accumulators.h"
 #include "primitives/zerocoin.h"
 #include <list>
 
@@ -15,6 +16,7 @@ class CZeroTracker {
   bool fInitialized;
   std::map<uint256, CMintMeta> mapSerialHashes;
   std::map<uint256, uint256> mapPendingSpends;  // serialhash, txid of spend
+  std::map<uint256, CMintWitness> mapWitnesses;  // pubcoinhash, witness kept up to date for the next spend
   bool UpdateStatusInternal(const std::set<uint256>& setMempool, CMintMeta& mint);
 
  public:
@@ -41,5 +43,10 @@ class CZeroTracker {
   void SetPubcoinNotUsed(const uint256& hashPubcoin);
   bool UnArchive(const uint256& hashPubcoin);
   bool UpdateState(const CMintMeta& meta);
+  bool GetWitness(const uint256& hashPubcoin, CMintWitness& mintWitness);
+  void SetWitness(const uint256& hashPubcoin, const CMintWitness& mintWitness);
+  void EraseWitness(const uint256& hashPubcoin);
+  //! Drop the witnesses of every mint not in setKeep, which are spent or gone, from memory and the wallet
+  void PruneWitnesses(const std::set<uint256>& setKeep);
   void Clear();
 };